@@ -0,0 +1,36 @@
+#include "bgfx_shader.sh"
+
+// 延迟光照：全屏三角形逐像素读 G-buffer → 由深度重建世界坐标 → 与前向同一份 pbrShade
+// 排列：fs_deferred_light_p00（方向光 + 环境光）/ _p08（再加分簇点光/聚光，PBR_CLUSTERED=1）
+#include "pbr_common.sh"
+
+SAMPLER2D(s_gbAlbedo,   0);
+SAMPLER2D(s_gbNormal,   1);
+SAMPLER2D(s_gbEmissive, 2);
+SAMPLER2D(s_gbDepth,    3);
+uniform vec4 u_deferred; // x = originBottomLeft  y = homogeneousDepth  zw = 1 / G-buffer 纹理尺寸
+
+void main()
+{
+    // 渲染目标纹理与 gl_FragCoord 的原点在各后端一致，直接换算 uv；
+    // 动态分辨率下 view 只占纹理的一角，uv 按纹理尺寸算，NDC 按 view 尺寸算
+    vec2 uv = gl_FragCoord.xy * u_deferred.zw;
+    vec2 local = gl_FragCoord.xy * u_viewTexel.xy;
+    float depth = texture2D(s_gbDepth, uv).x;
+    if (depth >= 1.0) discard; // 背景：保留主 view 的清屏色
+
+    vec4 gb0 = texture2D(s_gbAlbedo, uv);
+    vec4 gb1 = texture2D(s_gbNormal, uv);
+    vec3 emissive = texture2D(s_gbEmissive, uv).rgb;
+
+    vec3 ndc;
+    ndc.x = local.x * 2.0 - 1.0;
+    ndc.y = u_deferred.x > 0.5 ? local.y * 2.0 - 1.0 : 1.0 - local.y * 2.0;
+    ndc.z = u_deferred.y > 0.5 ? depth * 2.0 - 1.0 : depth;
+    vec4 wpos = mul(u_invViewProj, vec4(ndc, 1.0));
+
+    gl_FragColor = pbrShade(gb0.rgb * gb0.rgb, gb0.a, gb1.z, octDecode(gb1.xy * 2.0 - 1.0),
+                            wpos.xyz / wpos.w, emissive, gl_FragCoord);
+    // 写回深度：之后提交到主 view 的叠加物（网格线等）照常做深度测试
+    gl_FragDepth = depth;
+}
@@ -0,0 +1,6 @@
+#include "bgfx_shader.sh"
+
+// 深度预通道：空片元着色器（颜色写关闭，只留深度）
+void main()
+{
+}
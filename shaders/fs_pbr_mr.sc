@@ -1,76 +1,98 @@
 $input v_texcoord0, v_worldPos, v_normalWS
 #include "bgfx_shader.sh"
 
-uniform vec4 u_lightDir;
-uniform vec4 u_pointPosRad;
-uniform vec4 u_pointColInt;
-uniform vec4 u_viewPosExp;
+// 排列开关（CMake 以 --define 编译出 fs_pbr_mr_pXX.bin，XX = 下列位掩码，见 PbrPermutation.h）
+// bit0 PBR_MR_MAP  bit1 PBR_NORMAL_MAP  bit2 PBR_EMISSIVE_MAP
+// bit3 PBR_CLUSTERED    bit4 PBR_TWO_SIDED  bit5 PBR_TEX_ARRAY
+// PBR_GBUFFER=1 时编成延迟管线的 G-buffer 变体（fs_pbr_gb_pXX，只用材质位 + 数组位），不做光照
+#ifndef PBR_MR_MAP
+#define PBR_MR_MAP 0
+#endif
+#ifndef PBR_NORMAL_MAP
+#define PBR_NORMAL_MAP 0
+#endif
+#ifndef PBR_EMISSIVE_MAP
+#define PBR_EMISSIVE_MAP 0
+#endif
+#ifndef PBR_TWO_SIDED
+#define PBR_TWO_SIDED 0
+#endif
+#ifndef PBR_TEX_ARRAY
+#define PBR_TEX_ARRAY 0
+#endif
+#ifndef PBR_GBUFFER
+#define PBR_GBUFFER 0
+#endif
 
-uniform vec4 u_baseColorFactor;
-uniform vec4 u_mrFactor;
-uniform vec4 u_emissive;
-uniform vec4 u_matFlags;
+#include "pbr_common.sh"
 
+#if PBR_TEX_ARRAY
+// 小纹理打包进 2D 数组：同尺寸的材质共用一组绑定，层号在材质常量块里
+SAMPLER2DARRAY(s_baseColor, 0);
+SAMPLER2DARRAY(s_mr,        1);
+SAMPLER2DARRAY(s_normal,    2);
+SAMPLER2DARRAY(s_ao,        3);
+SAMPLER2DARRAY(s_emissive,  4);
+#define PBR_SAMPLE(_s, _layer) texture2DArray(_s, vec3(v_texcoord0, _layer))
+#else
 SAMPLER2D(s_baseColor, 0);
 SAMPLER2D(s_mr,        1);
 SAMPLER2D(s_normal,    2);
 SAMPLER2D(s_ao,        3);
 SAMPLER2D(s_emissive,  4);
+#define PBR_SAMPLE(_s, _layer) texture2D(_s, v_texcoord0)
+#endif
 
-vec3 srgbToLinear(vec3 c){ return pow(c, vec3_splat(2.2)); }
-vec3 F_Schlick(vec3 F0, float ct){ return F0 + (1.0 - F0) * pow(1.0 - ct, 5.0); }
-float D_GGX(float NoH, float a){ float a2=a*a; float d=(NoH*NoH)*(a2-1.0)+1.0; return a2/(3.14159265*d*d); }
-float V_SmithGGXCorrelated(float NoV,float NoL,float a){ float a2=a*a; float gv=NoL*sqrt((NoV-NoV*a2)*NoV+a2); float gl=NoV*sqrt((NoL-NoL*a2)*NoL+a2); return 0.5/(gv+gl); }
-vec3 tonemapACES(vec3 x){ const float A=2.51,B=0.03,C=2.43,D=0.59,E=0.14; return clamp((x*(A*x+B))/(x*(C*x+D)+E), 0.0, 1.0); }
+#if PBR_NORMAL_MAP
+// 没有切线属性：用屏幕空间导数重建切线空间（cotangent frame）
+vec3 perturbNormal(vec3 N, vec3 p, vec2 uv, vec3 tn)
+{
+    vec3 dp1 = dFdx(p);
+    vec3 dp2 = dFdy(p);
+    vec2 duv1 = dFdx(uv);
+    vec2 duv2 = dFdy(uv);
+    vec3 dp2perp = cross(dp2, N);
+    vec3 dp1perp = cross(N, dp1);
+    vec3 T = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 B = dp2perp * duv1.y + dp1perp * duv2.y;
+    float invMax = inversesqrt(max(max(dot(T,T), dot(B,B)), 1e-12));
+    return normalize(T * (tn.x * invMax) + B * (tn.y * invMax) + N * tn.z);
+}
+#endif
 
 void main()
 {
-    vec4 baseTex = texture2D(s_baseColor, v_texcoord0);
-    vec3 baseCol = srgbToLinear(baseTex.rgb) * u_baseColorFactor.rgb;
+    // baseColor 纹理以 sRGB 格式创建，采样时硬件已转到线性空间
+    vec3 baseCol = PBR_SAMPLE(s_baseColor, u_texLayers.x).rgb * u_baseColorFactor.rgb;
 
     float metallic  = u_mrFactor.x;
     float roughness = u_mrFactor.y;
-    vec2 mrTex = texture2D(s_mr, v_texcoord0).bg;
-    if ( (int(u_matFlags.x) & 2) != 0 ) { metallic = mrTex.y; roughness = mrTex.x; }
-    roughness = clamp(roughness, 0.045, 1.0);
+#if PBR_MR_MAP
+    vec2 mrTex = PBR_SAMPLE(s_mr, u_texLayers.y).bg;
+    metallic = mrTex.y; roughness = mrTex.x;
+#endif
 
     vec3 N = normalize(v_normalWS);
-    vec3 V = normalize(u_viewPosExp.xyz - v_worldPos);
-    float NoV = saturate(dot(N,V));
-    float a = roughness*roughness;
-    vec3 F0 = mix(vec3_splat(0.04), baseCol, metallic);
-
-    vec3 Ld = normalize(u_lightDir.xyz);
-    float NoLd = saturate(dot(N,Ld));
-    vec3 H = normalize(V+Ld);
-    float NoH = saturate(dot(N,H));
-    vec3 F = F_Schlick(F0, saturate(dot(H,V)));
-    float D = D_GGX(NoH,a);
-    float Vis = V_SmithGGXCorrelated(NoV,NoLd,a);
-    vec3 spec_d = F*D*Vis;
-    vec3 diff_d = (1.0 - F) * (1.0 - metallic) * baseCol / 3.14159265;
-    vec3 Lo_dir = (diff_d + spec_d) * NoLd;
-
-    vec3 Lp = normalize(u_pointPosRad.xyz - v_worldPos);
-    float NoLp = saturate(dot(N,Lp));
-    float dist = length(u_pointPosRad.xyz - v_worldPos);
-    float radius = u_pointPosRad.w;
-    float att = saturate(1.0 - dist / max(radius, 0.0001));
-    att = att*att*(3.0 - 2.0*att);
-    vec3 H2 = normalize(V+Lp);
-    float NoH2 = saturate(dot(N,H2));
-    vec3 F2 = F_Schlick(F0, saturate(dot(H2,V)));
-    float D2 = D_GGX(NoH2,a);
-    float Vis2 = V_SmithGGXCorrelated(NoV,NoLp,a);
-    vec3 spec_p = F2*D2*Vis2;
-    vec3 diff_p = (1.0 - F2) * (1.0 - metallic) * baseCol / 3.14159265;
-    vec3 Lo_point = (diff_p + spec_p) * u_pointColInt.rgb * u_pointColInt.a * NoLp * att;
+#if PBR_TWO_SIDED
+    if (!gl_FrontFacing) N = -N;
+#endif
+#if PBR_NORMAL_MAP
+    vec3 tn = PBR_SAMPLE(s_normal, u_texLayers.z).xyz * 2.0 - 1.0;
+    N = perturbNormal(N, v_worldPos, v_texcoord0, tn);
+#endif
 
-    vec3 ambient = baseCol * u_lightDir.w * (1.0 - metallic);
+    vec3 emissive = u_emissive.rgb;
+#if PBR_EMISSIVE_MAP
+    emissive *= PBR_SAMPLE(s_emissive, u_mrFactor.w).rgb;
+#endif
 
-    vec3 color = ambient + Lo_dir + Lo_point + u_emissive.rgb;
-    color *= u_viewPosExp.w;
-    color = tonemapACES(color);
-    color = pow(color, vec3_splat(1.0/2.2));
-    gl_FragColor = vec4(color,1.0);
+#if PBR_GBUFFER
+    // RT0 = sqrt(反照率) + 金属度（RGBA8，近似 gamma 2 省暗部精度）
+    // RT1 = 八面体法线 + 粗糙度（RGB10A2）  RT2 = 自发光（RG11B10F）
+    gl_FragData[0] = vec4(sqrt(baseCol), metallic);
+    gl_FragData[1] = vec4(octEncode(N) * 0.5 + 0.5, roughness, 0.0);
+    gl_FragData[2] = vec4(emissive, 0.0);
+#else
+    gl_FragColor = pbrShade(baseCol, metallic, roughness, N, v_worldPos, emissive, gl_FragCoord);
+#endif
 }
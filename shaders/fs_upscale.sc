@@ -0,0 +1,12 @@
+#include "bgfx_shader.sh"
+
+// 动态分辨率放大：场景画在纹理里与 gl_FragCoord 同原点的一角（占 u_upscale.xy 的比例），
+// 双线性拉伸到整个后台缓冲；u_upscale.zw 是 uv 上限（区域边缘内收半个 texel）
+SAMPLER2D(s_scene, 0);
+uniform vec4 u_upscale;
+
+void main()
+{
+    vec2 uv = min(gl_FragCoord.xy * u_viewTexel.xy * u_upscale.xy, u_upscale.zw);
+    gl_FragColor = texture2D(s_scene, uv);
+}
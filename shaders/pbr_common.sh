@@ -0,0 +1,205 @@
+// PBR（metallic-roughness）光照公共部分
+// 采样与排列开关（PBR_*）在 fs_pbr_mr.sc 里处理，这里只做着色
+
+#ifndef PBR_CLUSTERED
+#define PBR_CLUSTERED 0
+#endif
+#ifndef PBR_OBJECT_LIGHTS
+#define PBR_OBJECT_LIGHTS 0
+#endif
+
+uniform vec4 u_lightDir;
+uniform vec4 u_viewPosExp;
+
+// 材质常量块（PbrMaterialGPU::params，每次 draw 一次 setUniform 上传）
+// [0] baseColorFactor
+// [1] x=metallic y=roughness z=flags w=emissive 数组层号
+// [2] xyz=emissive
+// [3] 数组层号：baseColor, mr, normal, ao（仅 PBR_TEX_ARRAY 排列使用）
+uniform vec4 u_material[4];
+#define u_baseColorFactor u_material[0]
+#define u_mrFactor        u_material[1]
+#define u_matFlags        u_material[1].z
+#define u_emissive        u_material[2]
+#define u_texLayers       u_material[3]
+
+vec3 F_Schlick(vec3 F0, float ct){ return F0 + (1.0 - F0) * pow(1.0 - ct, 5.0); }
+float D_GGX(float NoH, float a){ float a2=a*a; float d=(NoH*NoH)*(a2-1.0)+1.0; return a2/(3.14159265*d*d); }
+float V_SmithGGXCorrelated(float NoV,float NoL,float a){ float a2=a*a; float gv=NoL*sqrt((NoV-NoV*a2)*NoV+a2); float gl=NoV*sqrt((NoL-NoL*a2)*NoL+a2); return 0.5/(gv+gl); }
+// 八面体法线编码（延迟管线的 G-buffer 用）：单位向量 ↔ [-1,1]²
+vec2 octEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 s = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * s;
+}
+vec3 octDecode(vec2 p)
+{
+    vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    float t = saturate(-n.z);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+vec3 tonemapACES(vec3 x){ const float A=2.51,B=0.03,C=2.43,D=0.59,E=0.14; return clamp((x*(A*x+B))/(x*(C*x+D)+E), 0.0, 1.0); }
+
+// 单个光源的 BRDF * NoL（未乘光强/衰减）
+vec3 brdfLight(vec3 N, vec3 V, vec3 L, vec3 baseCol, vec3 F0, float metallic, float a, float NoV)
+{
+    float NoL = saturate(dot(N,L));
+    vec3 H = normalize(V+L);
+    float NoH = saturate(dot(N,H));
+    vec3 F = F_Schlick(F0, saturate(dot(H,V)));
+    float D = D_GGX(NoH,a);
+    float Vis = V_SmithGGXCorrelated(NoV,NoL,a);
+    vec3 spec = F*D*Vis;
+    vec3 diff = (1.0 - F) * (1.0 - metallic) * baseCol / 3.14159265;
+    return (diff + spec) * NoL;
+}
+
+// 一盏局部光（点光/聚光），布局同 ClusteredLighting::packLight：
+// t0 = pos, radius；t1 = color*intensity, spotScale；t2 = dir, spotOffset
+vec3 localLight(vec4 t0, vec4 t1, vec4 t2, vec3 N, vec3 V, vec3 worldPos,
+                vec3 baseCol, vec3 F0, float metallic, float a, float NoV)
+{
+    vec3 toL = t0.xyz - worldPos;
+    float dist = length(toL);
+    vec3 L = toL / max(dist, 0.0001);
+    float att = saturate(1.0 - dist / max(t0.w, 0.0001));
+    att = att*att*(3.0 - 2.0*att);
+    // 点光 scale=0, offset=1 → 恒为 1
+    float spot = saturate(dot(-L, t2.xyz) * t1.w + t2.w);
+    att *= spot*spot;
+    return brdfLight(N, V, L, baseCol, F0, metallic, a, NoV) * t1.rgb * att;
+}
+
+#if PBR_CLUSTERED
+// 分簇光照（ClusteredLighting）：三张点采样数据纹理
+// s_lightData：每盏光 3 texel（pos,radius | color*intensity,spotScale | dir,spotOffset）
+// s_clusterGrid：x = 簇号 (tileY*tilesX + tileX)，y = slice；texel = (索引起点, 数量)
+// s_lightIndex：全局光索引表，按 kIndexTexWidth 折行
+SAMPLER2D(s_lightData,   5);
+SAMPLER2D(s_clusterGrid, 6);
+SAMPLER2D(s_lightIndex,  7);
+// [0] tilesX, tilesY, slices, indexTexWidth
+// [1] tilesX/宽, tilesY/高, 视口高, originBottomLeft
+// [2] near, slices/log(far/near)
+uniform vec4 u_cluster[3];
+
+#define PBR_MAX_LIGHTS_PER_CLUSTER 64
+
+vec3 clusteredLights(vec3 N, vec3 V, vec3 worldPos, vec4 fragCoord, vec3 baseCol, vec3 F0, float metallic, float a, float NoV)
+{
+    float viewZ = mul(u_view, vec4(worldPos, 1.0)).z;
+    float fy = u_cluster[1].w > 0.5 ? u_cluster[1].z - fragCoord.y : fragCoord.y; // 行 0 在屏幕顶部
+    float tx = clamp(floor(fragCoord.x * u_cluster[1].x), 0.0, u_cluster[0].x - 1.0);
+    float ty = clamp(floor(fy * u_cluster[1].y), 0.0, u_cluster[0].y - 1.0);
+    float sz = clamp(floor(log(max(viewZ, u_cluster[2].x) / u_cluster[2].x) * u_cluster[2].y), 0.0, u_cluster[0].z - 1.0);
+
+    vec2 cell = texelFetch(s_clusterGrid, ivec2(int(ty * u_cluster[0].x + tx), int(sz)), 0).xy;
+    int first = int(cell.x);
+    int count = int(cell.y);
+    int width = int(u_cluster[0].w);
+
+    vec3 Lo = vec3_splat(0.0);
+    for (int i = 0; i < PBR_MAX_LIGHTS_PER_CLUSTER; ++i)
+    {
+        if (i >= count) break;
+        int k = first + i;
+        int li = int(texelFetch(s_lightIndex, ivec2(k - (k / width) * width, k / width), 0).x);
+        vec4 t0 = texelFetch(s_lightData, ivec2(0, li), 0);
+        vec4 t1 = texelFetch(s_lightData, ivec2(1, li), 0);
+        vec4 t2 = texelFetch(s_lightData, ivec2(2, li), 0);
+
+        Lo += localLight(t0, t1, t2, N, V, worldPos, baseCol, F0, metallic, a, NoV);
+    }
+    return Lo;
+}
+#endif
+
+#if PBR_OBJECT_LIGHTS > 0
+// 逐物体光表（ObjectLights）：裁剪时选出的至多 8 盏，每盏 3 个 vec4
+uniform vec4 u_objLights[24];
+#endif
+
+// 方向光级联阴影（CascadedShadows）：4 级共用一张 2x2 深度图集，硬件比较 + 2x2 PCF
+SAMPLER2DSHADOW(s_shadowMap, 8);
+uniform mat4 u_shadowMtx[4];   // 世界 → 图集 uv + 深度
+uniform vec4 u_cascadeSplits;  // 各级的视空间远端距离
+uniform vec4 u_cascadeTexel;   // 各级一个 texel 的世界尺寸（法线偏移用）
+uniform vec4 u_shadowParams;   // x=深度偏移 y=法线偏移(texel 倍数) z=半个 texel(uv) w=开关
+
+float dirShadow(vec3 worldPos, vec3 N)
+{
+    if (u_shadowParams.w < 0.5) return 1.0; // 统一分支：关掉阴影时不采样
+    float viewZ = mul(u_view, vec4(worldPos, 1.0)).z;
+    vec4 past = step(u_cascadeSplits, vec4_splat(viewZ));
+    int c = int(past.x + past.y + past.z + past.w);
+    if (c >= 4) return 1.0;
+
+    float texel = c == 0 ? u_cascadeTexel.x : c == 1 ? u_cascadeTexel.y : c == 2 ? u_cascadeTexel.z : u_cascadeTexel.w;
+    vec4 sc = mul(u_shadowMtx[c], vec4(worldPos + N * (texel * u_shadowParams.y), 1.0));
+    vec3 p = sc.xyz / sc.w;
+    float z = p.z - u_shadowParams.x;
+    float h = u_shadowParams.z;
+    float vis = shadow2D(s_shadowMap, vec3(p.xy + vec2(-h, -h), z))
+              + shadow2D(s_shadowMap, vec3(p.xy + vec2( h, -h), z))
+              + shadow2D(s_shadowMap, vec3(p.xy + vec2(-h,  h), z))
+              + shadow2D(s_shadowMap, vec3(p.xy + vec2( h,  h), z));
+    return vis * 0.25;
+}
+
+// ===== 环境光 IBL（ImageBasedLighting）=====
+SAMPLERCUBE(s_envSpec, 9);
+SAMPLER2D(s_brdfLut, 10);
+uniform vec4 u_envSH[9];   // 已烘进余弦卷积与 1/π 的 3 阶球谐，rgb
+uniform vec4 u_iblParams;  // x = 强度（0 = 关）  y = roughness 1 对应的 mip
+
+// 漫反射辐照度 / π
+vec3 shIrradiance(vec3 n)
+{
+    vec3 r = u_envSH[0].rgb
+           + u_envSH[1].rgb * n.y + u_envSH[2].rgb * n.z + u_envSH[3].rgb * n.x
+           + u_envSH[4].rgb * (n.x*n.y) + u_envSH[5].rgb * (n.y*n.z) + u_envSH[6].rgb * (3.0*n.z*n.z - 1.0)
+           + u_envSH[7].rgb * (n.x*n.z) + u_envSH[8].rgb * (n.x*n.x - n.y*n.y);
+    return max(r, vec3_splat(0.0));
+}
+
+vec3 ambientIBL(vec3 N, vec3 V, vec3 baseCol, vec3 F0, float metallic, float roughness, float NoV)
+{
+    vec2 ab = texture2D(s_brdfLut, vec2(NoV, roughness)).xy;
+    vec3 specScale = F0 * ab.x + ab.y;
+    vec3 R = reflect(-V, N);
+    vec3 spec = textureCubeLod(s_envSpec, R, roughness * u_iblParams.y).rgb * specScale;
+    vec3 diff = (1.0 - specScale) * (1.0 - metallic) * baseCol * shIrradiance(N);
+    return (diff + spec) * u_iblParams.x;
+}
+
+// baseCol：线性空间；N：已归一化的世界空间法线；fragCoord：gl_FragCoord（分簇查表用）
+vec4 pbrShade(vec3 baseCol, float metallic, float roughness, vec3 N, vec3 worldPos, vec3 emissive, vec4 fragCoord)
+{
+    roughness = clamp(roughness, 0.045, 1.0);
+
+    vec3 V = normalize(u_viewPosExp.xyz - worldPos);
+    float NoV = saturate(dot(N,V));
+    float a = roughness*roughness;
+    vec3 F0 = mix(vec3_splat(0.04), baseCol, metallic);
+
+    vec3 Lo = brdfLight(N, V, normalize(u_lightDir.xyz), baseCol, F0, metallic, a, NoV) * dirShadow(worldPos, N);
+
+#if PBR_CLUSTERED
+    Lo += clusteredLights(N, V, worldPos, fragCoord, baseCol, F0, metallic, a, NoV);
+#elif PBR_OBJECT_LIGHTS > 0
+    for (int i = 0; i < PBR_OBJECT_LIGHTS; ++i)
+        Lo += localLight(u_objLights[i*3], u_objLights[i*3+1], u_objLights[i*3+2],
+                         N, V, worldPos, baseCol, F0, metallic, a, NoV);
+#endif
+
+    vec3 ambient = u_iblParams.x > 0.0 ? ambientIBL(N, V, baseCol, F0, metallic, roughness, NoV)
+                                       : baseCol * u_lightDir.w * (1.0 - metallic);
+
+    vec3 color = ambient + Lo + emissive;
+    color *= u_viewPosExp.w;
+    color = tonemapACES(color);
+    color = pow(color, vec3_splat(1.0/2.2));
+    return vec4(color,1.0);
+}
@@ -0,0 +1,9 @@
+$input  a_position
+
+#include "bgfx_shader.sh"
+
+// 深度预通道：只读位置流；表达式须与 vs_pbr 的 gl_Position 完全一致，主通道才能用 DEPTH_TEST_EQUAL
+void main()
+{
+    gl_Position = mul(u_modelViewProj, vec4(a_position, 1.0));
+}
@@ -0,0 +1,9 @@
+$input  a_position
+
+#include "bgfx_shader.sh"
+
+// 全屏三角形：顶点已是裁剪空间坐标（xy ∈ {-1, 3}），不经过任何矩阵
+void main()
+{
+    gl_Position = vec4(a_position.xy, 0.0, 1.0);
+}
@@ -8,6 +8,7 @@
 
 // 我们新增的帧计时器
 #include "core/FrameTimer.h"
+#include "core/FrameSnapshot.h"
 
 #ifdef _WIN32
 #define NOMINMAX
@@ -17,29 +18,21 @@
 #include "io/Exporter.h"
 namespace ke
 {
-    struct OrbitViewSnapshot
-    {
-        float eye[3]{0.0f, 0.0f, -2.5f};
-        float at[3]{0.0f, 0.0f, 0.0f};
-        float up[3]{0.0f, 1.0f, 0.0f};
-    };
-    OrbitViewSnapshot g_orbitView;  // 供 Renderer 读取
-    static OrbitController g_orbit; // 只在本翻译单元使用
+    DoubleBuffer<OrbitViewSnapshot> g_orbitView; // 主线程写，API 线程读
+    DoubleBuffer<LightingSnapshot>  g_lighting;
+    static OrbitController g_orbit; // 只在本翻译单元使用（主线程）
 }
 
 // 给 std::filesystem 起别名，写起来更简洁
 namespace fs = std::filesystem;
 
 // ===== 文件作用域静态对象（只在本 .cpp 可见） =====
-static ke::FrameTimer gTimer;    // 帧计时器（程序启动构造、退出析构）
-static double gPrintAccum = 0.0; // 打印节流器（累计到 1s 打印一次）
+static ke::FrameTimer gTimer;      // 帧计时器（API 线程，程序启动构造、退出析构）
+static ke::FrameTimer gInputTimer; // 输入 / 相机更新的计时器（主线程）
+static double gPrintAccum = 0.0;   // 打印节流器（累计到 1s 打印一次）
 
-// 点光参数（运行时可按键调整）
-static bool sPointOn = false;
-static float sPointPos[3] = {2.0f, 2.0f, 2.0f};
-static float sPointRadius = 5.0f;
-static float sPointColor[3] = {1.0f, 1.0f, 1.0f};
-static float sPointIntensity = 3.0f;
+// 主线程每次最多等 API 线程这么久的新帧，等不到也回来处理事件，窗口不会因为加载卡住
+static constexpr int32_t kRenderWaitMs = 16;
 
 // ===================================================
 
@@ -74,30 +67,18 @@ bool App::init(int width, int height, const char *title)
         return false;
     }
 
-    if (!renderer_.init(window_, width_, height_))
+    // 主线程：显示窗口、取原生句柄（SDL 窗口调用只在这里做）
+    if (!renderer_.attachWindow(window_, width_, height_))
     {
         return false;
     }
 
-    // （可选）调整 FPS 平滑灵敏度：0.05 更稳，0.30 更灵
-    gTimer.setSmoothing(0.15);
-
-    // 方向光
-    renderer_.setLightDir(-0.5f, -1.0f, -0.2f, 0.15f);
-
-    // 点光默认关闭；先把参数设置好，开关打开后立即生效
-    renderer_.setPointLightEnabled(false);
-    renderer_.setPointLight(
-        sPointPos[0], sPointPos[1], sPointPos[2], sPointRadius,
-        sPointColor[0], sPointColor[1], sPointColor[2], sPointIntensity);
+    // 在 bgfx::init 之前调一次：bgfx 不再自建渲染线程，主线程就是渲染线程
+    bgfx::renderFrame();
 
-    // 相机/渲染器默认状态
+    // 相机默认状态（输入与相机归主线程）
     camera_.setViewport(width_, height_);
     camera_.setMode(CameraMode::Perspective);
-    renderer_.setShowHelp(true);
-    renderer_.setDrawMode(DrawMode::Triangle);
-    renderer_.setUseTexture(false);
-    renderer_.setDebug(dbgFlags_);
 
     // 相机初始位姿
     camCtl_.SetPose({0.0f, 1.6f, 3.0f}, 0.0f, 0.0f);
@@ -107,25 +88,138 @@ bool App::init(int width, int height, const char *title)
     ke::g_orbit.setDistance(3.0f);
     ke::g_orbit.setDistanceRange(0.2f, 100.0f);
     ke::g_orbit.setPitchRangeDeg(-85.0f, +85.0f);
+    publishOrbitView();
+
+    // 点光默认关闭；参数先发布一份，API 线程第一帧转给渲染器
+    ke::g_lighting.publish();
+
+    // bgfx::init 要和渲染线程握手：等 API 线程初始化的同时继续驱动渲染线程
+    apiThread_ = std::thread(&App::apiMain, this);
+    while (apiState_.load() == ApiState::Starting)
+        bgfx::renderFrame(kRenderWaitMs);
+    if (apiState_.load() == ApiState::Failed)
+    {
+        apiThread_.join();
+        return false;
+    }
 
     return true;
 }
 
-void App::run()
+void App::apiMain()
 {
-    running_ = true;
+    if (!renderer_.init())
+    {
+        apiState_ = ApiState::Failed;
+        return;
+    }
 
+    // （可选）调整 FPS 平滑灵敏度：0.05 更稳，0.30 更灵
+    gTimer.setSmoothing(0.15);
+
+    // 方向光
+    renderer_.setLightDir(-0.5f, -1.0f, -0.2f, 0.15f);
+
+    // 渲染器默认状态
+    renderer_.setShowHelp(true);
+    renderer_.setDrawMode(DrawMode::Triangle);
+    renderer_.setUseTexture(false);
+    renderer_.setDebug(dbgFlags_);
+
+    running_ = true;
+    apiState_ = ApiState::Running;
     while (running_)
+        apiFrame();
+
+    scene_.clear(); // 先还网格引用，再关渲染器
+    // bgfx::shutdown 也要渲染线程配合：主线程在 run() 末尾一直 renderFrame 到 NoContext
+    renderer_.shutdown();
+    apiState_ = ApiState::Done;
+}
+
+void App::apiFrame()
+{
+    // ---- 主线程转来的事件 ----
+    std::vector<SDL_Event> events;
+    {
+        std::lock_guard<std::mutex> lock(eventsMutex_);
+        events.swap(events_);
+    }
+    for (const SDL_Event &e : events)
+    {
+        if (e.type == SDL_QUIT)
+            running_ = false;
+        else if (e.type == SDL_WINDOWEVENT)
+            renderer_.resize(e.window.data1, e.window.data2);
+        else if (e.type == SDL_KEYDOWN)
+            handleKeyDown(e.key.keysym.sym);
+    }
+
+    // ---- 计算 dt（秒）+ 每秒打印一次性能信息 ----
+    const double dt = gTimer.tick();  // 本帧耗时（秒）
+    angle_ += static_cast<float>(dt); // demo 自旋转
+
+    gPrintAccum += dt;
+    if (gPrintAccum >= 1.0)
+    {
+        spdlog::info("[Perf] FPS={:.1f}  FrameTime={:.3f} ms  Frames={}  Elapsed={:.1f}s",
+                     gTimer.fps(), gTimer.delta() * 1000.0, gTimer.frameCount(), gTimer.elapsed());
+        gPrintAccum = 0.0;
+    }
+
+    // ---- 主线程发布的快照：视角每帧取一份，灯光有变化才转交 ----
+    renderer_.setOrbitView(ke::g_orbitView.read());
+    ke::LightingSnapshot L;
+    if (ke::g_lighting.readIfChanged(L, lightSerial_))
+    {
+        renderer_.setPointLight(L.pointPos, L.pointRadius, L.pointColor, L.pointIntensity);
+        renderer_.setPointLightEnabled(L.pointOn);
+    }
+
+    // ---- 渲染路径（bgfx::frame 只交换命令缓冲，驱动提交在主线程的 renderFrame 里）----
+    if (draw_ == DrawMode::Mesh)
+    {
+        scene_.update(); // SRT → world，裁剪 / 提交读 world
+        renderer_.renderScene(scene_, camera_);
+    }
+    else
+    {
+        renderer_.renderFrame(camera_, lastDraws_, lastTris_, angle_);
+    }
+}
+
+void App::publishOrbitView()
+{
+    const auto e = ke::g_orbit.eye();
+    const auto a = ke::g_orbit.at();
+    const auto u = ke::g_orbit.up();
+    ke::OrbitViewSnapshot &v = ke::g_orbitView.back();
+    v.eye[0] = e.x;
+    v.eye[1] = e.y;
+    v.eye[2] = e.z;
+    v.at[0] = a.x;
+    v.at[1] = a.y;
+    v.at[2] = a.z;
+    v.up[0] = u.x;
+    v.up[1] = u.y;
+    v.up[2] = u.z;
+    ke::g_orbitView.publish();
+}
+
+void App::run()
+{
+    while (apiState_.load() == ApiState::Running)
     {
         // ---- 输入帧开始 ----
         input_.BeginFrame();
 
-        // ---- 事件处理 ----
+        // ---- 事件处理：输入 / 相机在本线程，其余转给 API 线程 ----
+        std::vector<SDL_Event> forward;
         SDL_Event e;
         while (SDL_PollEvent(&e))
         {
             if (e.type == SDL_QUIT)
-                running_ = false;
+                forward.push_back(e);
 
             if (e.type == SDL_WINDOWEVENT &&
                 (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ||
@@ -133,12 +227,12 @@ void App::run()
             {
                 width_ = e.window.data1;
                 height_ = e.window.data2;
-                renderer_.resize(width_, height_);
                 camera_.setViewport(width_, height_);
+                forward.push_back(e);
             }
 
-            if (e.type == SDL_KEYDOWN)
-                handleKeyDown(e.key.keysym.sym);
+            if (e.type == SDL_KEYDOWN && !handleInputKey(e.key.keysym.sym))
+                forward.push_back(e);
 
             input_.HandleSDLEvent(e);
 
@@ -173,61 +267,40 @@ void App::run()
             }
         }
 
-        // ---- 计算 dt（秒）+ 每秒打印一次性能信息 ----
-        const double dt = gTimer.tick();  // 本帧耗时（秒）
-        angle_ += static_cast<float>(dt); // demo 自旋转
-
-        gPrintAccum += dt;
-        if (gPrintAccum >= 1.0)
+        if (!forward.empty())
         {
-            spdlog::info("[Perf] FPS={:.1f}  FrameTime={:.3f} ms  Frames={}  Elapsed={:.1f}s",
-                         gTimer.fps(), gTimer.delta() * 1000.0, gTimer.frameCount(), gTimer.elapsed());
-            gPrintAccum = 0.0;
+            std::lock_guard<std::mutex> lock(eventsMutex_);
+            events_.insert(events_.end(), forward.begin(), forward.end());
         }
 
         // ---- 相机控制更新（与帧率无关，基于 dt）----
+        const double dt = gInputTimer.tick();
         camCtl_.Update(static_cast<float>(dt));
-        
-        // ---- 轨道相机更新 ----
-        ke::g_orbit.update(dt);
-
-        // 写出本帧视角（Renderer 会读取它来设定 view/proj）
-        {
-            const auto e = ke::g_orbit.eye();
-            const auto a = ke::g_orbit.at();
-            const auto u = ke::g_orbit.up();
-            ke::g_orbitView.eye[0] = e.x;
-            ke::g_orbitView.eye[1] = e.y;
-            ke::g_orbitView.eye[2] = e.z;
-            ke::g_orbitView.at[0] = a.x;
-            ke::g_orbitView.at[1] = a.y;
-            ke::g_orbitView.at[2] = a.z;
-            ke::g_orbitView.up[0] = u.x;
-            ke::g_orbitView.up[1] = u.y;
-            ke::g_orbitView.up[2] = u.z;
-
-            // （可选）把眼睛位置同步给 PBR 的 viewPos（已有接口）
-            renderer_.setViewPos(e.x, e.y, e.z);
-        }
 
-        // ---- 渲染路径 ----
-        if (draw_ == DrawMode::Mesh)
-        {
-            renderer_.renderScene(scene_, camera_);
-        }
-        else
-        {
-            renderer_.renderFrame(camera_, lastDraws_, lastTris_, angle_);
-        }
+        // ---- 轨道相机更新，发布本帧视角（API 线程下一帧取走）----
+        ke::g_orbit.update(dt);
+        publishOrbitView();
 
         // ---- 输入帧结束 ----
         input_.EndFrame();
+
+        // ---- 执行 API 线程上一帧交来的命令缓冲（驱动提交与 API 线程的下一帧重叠）----
+        bgfx::renderFrame(kRenderWaitMs);
     }
+
+    // API 线程退出主循环后在 bgfx::shutdown 里等渲染线程收尾
+    while (bgfx::renderFrame(kRenderWaitMs) != bgfx::RenderFrame::NoContext)
+    {
+    }
+    if (apiThread_.joinable())
+        apiThread_.join();
 }
 
 void App::shutdown()
 {
-    renderer_.shutdown();
+    // renderer_ 已在 API 线程里关闭（App::apiMain 末尾）
+    if (apiThread_.joinable())
+        apiThread_.join();
     if (window_)
     {
         SDL_DestroyWindow(window_);
@@ -236,6 +309,53 @@ void App::shutdown()
     SDL_Quit();
 }
 
+bool App::handleInputKey(SDL_Keycode key)
+{
+    // 点光参数改在后台缓冲里，改完发布；API 线程下一帧转给渲染器
+    ke::LightingSnapshot &L = ke::g_lighting.back();
+    switch (key)
+    {
+    case SDLK_o:
+        camera_.setMode(CameraMode::Ortho);
+        return true;
+
+    case SDLK_p:
+        camera_.setMode(CameraMode::Perspective);
+        return true;
+
+    // 点光控制
+    case SDLK_g:
+        L.pointOn = !L.pointOn;
+        if (L.pointOn)
+            spdlog::info("[Light] Point ON  pos=({:.2f},{:.2f},{:.2f}) R={:.2f} I={:.2f}",
+                         L.pointPos[0], L.pointPos[1], L.pointPos[2], L.pointRadius, L.pointIntensity);
+        else
+            spdlog::info("[Light] Point OFF");
+        break;
+    case SDLK_LEFTBRACKET:
+        L.pointRadius = std::max(0.1f, L.pointRadius - 0.5f);
+        spdlog::info("[Light] radius = {:.2f}", L.pointRadius);
+        break;
+    case SDLK_RIGHTBRACKET:
+        L.pointRadius += 0.5f;
+        spdlog::info("[Light] radius = {:.2f}", L.pointRadius);
+        break;
+    case SDLK_9:
+        L.pointIntensity = std::max(0.0f, L.pointIntensity - 0.25f);
+        spdlog::info("[Light] intensity = {:.2f}", L.pointIntensity);
+        break;
+    case SDLK_0:
+        L.pointIntensity += 0.25f;
+        spdlog::info("[Light] intensity = {:.2f}", L.pointIntensity);
+        break;
+
+    default:
+        return false;
+    }
+    ke::g_lighting.publish();
+    return true;
+}
+
 void App::handleKeyDown(SDL_Keycode key)
 {
     switch (key)
@@ -260,6 +380,36 @@ void App::handleKeyDown(SDL_Keycode key)
         renderer_.setDebug(dbgFlags_);
         break;
 
+    case SDLK_z:
+        renderer_.setDepthPrepass(!renderer_.depthPrepass());
+        spdlog::info("[Renderer] depth pre-pass {}", renderer_.depthPrepass() ? "ON" : "OFF");
+        break;
+
+    case SDLK_x:
+        renderer_.setShadows(!renderer_.shadows());
+        spdlog::info("[Renderer] cascaded shadows {}", renderer_.shadows() ? "ON" : "OFF");
+        break;
+    case SDLK_i:
+        if (!renderer_.environmentLoaded())
+        {
+            const std::string path = std::string(KE_ASSET_DIR) + "/env/environment.hdr";
+            bool ok = renderer_.loadEnvironment(path);
+            spdlog::info("[Renderer] load environment {} -> {}", path, ok ? "OK" : "FAILED");
+        }
+        else
+        {
+            renderer_.setImageBasedLighting(!renderer_.imageBasedLighting());
+            spdlog::info("[Renderer] IBL {}", renderer_.imageBasedLighting() ? "ON" : "OFF");
+        }
+        break;
+    case SDLK_f:
+        renderer_.setDeferredShading(!renderer_.deferredShading());
+        spdlog::info("[Renderer] shading path {}", renderer_.deferredShading() ? "Deferred" : "Forward");
+        break;
+    case SDLK_v:
+        renderer_.setDynamicResolution(!renderer_.dynamicResolution());
+        spdlog::info("[Renderer] dynamic resolution {}", renderer_.dynamicResolution() ? "ON" : "OFF");
+        break;
     case SDLK_h:
         showHelp_ = !showHelp_;
         renderer_.setShowHelp(showHelp_);
@@ -283,14 +433,6 @@ void App::handleKeyDown(SDL_Keycode key)
         renderer_.setUseTexture(useTex_);
         break;
 
-    case SDLK_o:
-        camera_.setMode(CameraMode::Ortho);
-        break;
-
-    case SDLK_p:
-        camera_.setMode(CameraMode::Perspective);
-        break;
-
     case SDLK_t:
         useTex_ = !useTex_;
         renderer_.setUseTexture(useTex_);
@@ -329,66 +471,6 @@ void App::handleKeyDown(SDL_Keycode key)
         break;
     }
 
-    // 点光控制
-    case SDLK_g:
-    {
-        sPointOn = !sPointOn;
-        renderer_.setPointLightEnabled(sPointOn);
-        if (sPointOn)
-        {
-            renderer_.setPointLight(
-                sPointPos[0], sPointPos[1], sPointPos[2], sPointRadius,
-                sPointColor[0], sPointColor[1], sPointColor[2], sPointIntensity);
-            spdlog::info("[Light] Point ON  pos=({:.2f},{:.2f},{:.2f}) R={:.2f} I={:.2f}",
-                         sPointPos[0], sPointPos[1], sPointPos[2], sPointRadius, sPointIntensity);
-        }
-        else
-        {
-            spdlog::info("[Light] Point OFF");
-        }
-        break;
-    }
-    case SDLK_LEFTBRACKET:
-    {
-        sPointRadius = std::max(0.1f, sPointRadius - 0.5f);
-        if (sPointOn)
-            renderer_.setPointLight(
-                sPointPos[0], sPointPos[1], sPointPos[2], sPointRadius,
-                sPointColor[0], sPointColor[1], sPointColor[2], sPointIntensity);
-        spdlog::info("[Light] radius = {:.2f}", sPointRadius);
-        break;
-    }
-    case SDLK_RIGHTBRACKET:
-    {
-        sPointRadius += 0.5f;
-        if (sPointOn)
-            renderer_.setPointLight(
-                sPointPos[0], sPointPos[1], sPointPos[2], sPointRadius,
-                sPointColor[0], sPointColor[1], sPointColor[2], sPointIntensity);
-        spdlog::info("[Light] radius = {:.2f}", sPointRadius);
-        break;
-    }
-    case SDLK_9:
-    {
-        sPointIntensity = std::max(0.0f, sPointIntensity - 0.25f);
-        if (sPointOn)
-            renderer_.setPointLight(
-                sPointPos[0], sPointPos[1], sPointPos[2], sPointRadius,
-                sPointColor[0], sPointColor[1], sPointColor[2], sPointIntensity);
-        spdlog::info("[Light] intensity = {:.2f}", sPointIntensity);
-        break;
-    }
-    case SDLK_0:
-    {
-        sPointIntensity += 0.25f;
-        if (sPointOn)
-            renderer_.setPointLight(
-                sPointPos[0], sPointPos[1], sPointPos[2], sPointRadius,
-                sPointColor[0], sPointColor[1], sPointColor[2], sPointIntensity);
-        spdlog::info("[Light] intensity = {:.2f}", sPointIntensity);
-        break;
-    }
-
     default:
         break;
     }
@@ -2,6 +2,10 @@
 #include <SDL.h>
 #include <string>
 #include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "gfx/Renderer.h"
 #include "gfx/camera/Camera.h"
 #include "scene/Scene.h" 
@@ -10,6 +14,10 @@
 #include "scene/Input.h"
 #include "scene/CameraController.h"
 
+// 线程分工（bgfx 多线程模式）：
+// - 主线程 = 渲染线程：SDL 事件 / 输入 / 相机控制，发布视角与灯光快照，循环调 bgfx::renderFrame()（驱动提交）
+// - API 线程：处理转发来的事件与按键命令，跑渲染器逻辑（裁剪、渲染图、提交）直到 bgfx::frame()
+// 两边只通过 events_（主 → API）和 ke::g_orbitView / ke::g_lighting 双缓冲快照交接
 class App {
 public:
     bool init(int width, int height, const char* title);
@@ -17,7 +25,13 @@ public:
     void shutdown();
 
 private:
-    void handleKeyDown(SDL_Keycode key);
+    enum class ApiState : uint8_t { Starting, Running, Failed, Done };
+
+    void apiMain();                    // API 线程入口
+    void apiFrame();                   // API 线程的一帧
+    bool handleInputKey(SDL_Keycode key); // 主线程：相机 / 灯光按键，处理了返回 true
+    void handleKeyDown(SDL_Keycode key);  // API 线程：渲染器命令
+    void publishOrbitView();
 
 private:
     SDL_Window* window_ = nullptr;
@@ -31,8 +45,14 @@ private:
     Input input_;
     CameraController camCtl_{ &camera_, &input_ };
 
+    // 线程
+    std::thread             apiThread_;
+    std::atomic<ApiState>   apiState_{ ApiState::Starting };
+    std::mutex              eventsMutex_;
+    std::vector<SDL_Event>  events_; // 主线程收到、要交给 API 线程的事件
+
     // 状态
-    bool running_   = false;
+    bool running_   = false; // API 线程的主循环
     bool showHelp_  = true;
     DrawMode draw_  = DrawMode::Triangle;
     bool useTex_    = false;
@@ -43,4 +63,5 @@ private:
     // 帧数据
     float angle_ = 0.0f;
     uint32_t lastDraws_ = 0, lastTris_ = 0;
+    uint64_t lightSerial_ = 0; // 上次转给渲染器的灯光快照序号（API 线程）
 };
@@ -0,0 +1,164 @@
+#include "core/ContentHash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace ke
+{
+    namespace
+    {
+        constexpr uint64_t kP1 = 0x9E3779B185EBCA87ull;
+        constexpr uint64_t kP2 = 0xC2B2AE3D27D4EB4Full;
+        constexpr uint64_t kP3 = 0x165667B19E3779F9ull;
+        constexpr uint64_t kP4 = 0x85EBCA77C2B2AE63ull;
+        constexpr uint64_t kP5 = 0x27D4EB2F165667C5ull;
+
+        inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+        // 小端读取（memcpy 由编译器折成一条 load）
+        inline uint64_t read64(const uint8_t* p)
+        {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            return v;
+        }
+        inline uint32_t read32(const uint8_t* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        inline uint64_t round(uint64_t acc, uint64_t input)
+        {
+            acc += input * kP2;
+            return rotl(acc, 31) * kP1;
+        }
+        inline uint64_t mergeRound(uint64_t acc, uint64_t val)
+        {
+            acc ^= round(0, val);
+            return acc * kP1 + kP4;
+        }
+    } // namespace
+
+    void ContentHasher::reset(uint64_t seed)
+    {
+        seed_ = seed;
+        acc_[0] = seed + kP1 + kP2;
+        acc_[1] = seed + kP2;
+        acc_[2] = seed;
+        acc_[3] = seed - kP1;
+        bufSize_ = 0;
+        total_ = 0;
+    }
+
+    void ContentHasher::update(const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        total_ += size;
+
+        // 先补满上次剩下的半个条带
+        if (bufSize_ > 0)
+        {
+            const size_t take = std::min<size_t>(32 - bufSize_, size);
+            std::memcpy(buf_ + bufSize_, p, take);
+            bufSize_ += uint32_t(take);
+            p += take;
+            if (bufSize_ < 32)
+                return;
+            for (int i = 0; i < 4; ++i)
+                acc_[i] = round(acc_[i], read64(buf_ + i * 8));
+            bufSize_ = 0;
+        }
+
+        // 32 字节一条带，四路累加器互不依赖
+        uint64_t v0 = acc_[0], v1 = acc_[1], v2 = acc_[2], v3 = acc_[3];
+        for (; end - p >= 32; p += 32)
+        {
+            v0 = round(v0, read64(p));
+            v1 = round(v1, read64(p + 8));
+            v2 = round(v2, read64(p + 16));
+            v3 = round(v3, read64(p + 24));
+        }
+        acc_[0] = v0;
+        acc_[1] = v1;
+        acc_[2] = v2;
+        acc_[3] = v3;
+
+        if (p < end)
+        {
+            std::memcpy(buf_, p, size_t(end - p));
+            bufSize_ = uint32_t(end - p);
+        }
+    }
+
+    uint64_t ContentHasher::digest() const
+    {
+        uint64_t h;
+        if (total_ >= 32)
+        {
+            h = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) + rotl(acc_[3], 18);
+            for (int i = 0; i < 4; ++i)
+                h = mergeRound(h, acc_[i]);
+        }
+        else
+        {
+            h = seed_ + kP5;
+        }
+        h += total_;
+
+        // 尾部不足一条带的字节
+        const uint8_t* p = buf_;
+        const uint8_t* end = buf_ + bufSize_;
+        for (; end - p >= 8; p += 8)
+            h = rotl(h ^ round(0, read64(p)), 27) * kP1 + kP4;
+        if (end - p >= 4)
+        {
+            h = rotl(h ^ (uint64_t(read32(p)) * kP1), 23) * kP2 + kP3;
+            p += 4;
+        }
+        for (; p < end; ++p)
+            h = rotl(h ^ (uint64_t(*p) * kP5), 11) * kP1;
+
+        h ^= h >> 33;
+        h *= kP2;
+        h ^= h >> 29;
+        h *= kP3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    uint64_t contentHash(const void* data, size_t size, uint64_t seed)
+    {
+        ContentHasher hasher(seed);
+        hasher.update(data, size);
+        return hasher.digest();
+    }
+
+    bool readFileHashed(const std::string& path, std::vector<uint8_t>& out, uint64_t& hash)
+    {
+        std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+        if (!ifs)
+            return false;
+        const std::streamoff size = ifs.tellg();
+        if (size < 0)
+            return false;
+        ifs.seekg(0);
+        out.resize(size_t(size));
+
+        // 按块读：每块刚进缓存就喂给哈希，读完文件哈希也就好了
+        constexpr size_t kChunk = 1u << 20;
+        ContentHasher hasher;
+        for (size_t off = 0; off < out.size(); off += kChunk)
+        {
+            const size_t n = std::min(kChunk, out.size() - off);
+            if (!ifs.read(reinterpret_cast<char*>(out.data() + off), std::streamsize(n)))
+                return false;
+            hasher.update(out.data() + off, n);
+        }
+        hash = hasher.digest();
+        return true;
+    }
+} // namespace ke
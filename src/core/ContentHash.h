@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ke
+{
+    // 资源内容哈希：XXH64（与 xxHash 参考实现逐位一致，每周期约 8 字节量级）
+    // - 流式：读文件时按块 update，读完即得哈希，不需要第二遍扫描
+    // - 用于按内容去重（不同路径 / 拷贝的同一份数据只占一份 GPU 资源），不用于安全校验
+    class ContentHasher
+    {
+    public:
+        explicit ContentHasher(uint64_t seed = 0) { reset(seed); }
+
+        void     reset(uint64_t seed = 0);
+        void     update(const void* data, size_t size);
+        uint64_t digest() const;
+
+    private:
+        uint64_t acc_[4]{};
+        uint8_t  buf_[32]{};
+        uint32_t bufSize_ = 0;
+        uint64_t total_ = 0;
+        uint64_t seed_ = 0;
+    };
+
+    uint64_t contentHash(const void* data, size_t size, uint64_t seed = 0);
+
+    // 把参数（色彩空间、翻转等）并进内容哈希，得到缓存键
+    inline uint64_t hashCombine(uint64_t h, uint64_t v)
+    {
+        return h ^ (v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+    }
+
+    // 整个文件读进 out，读的同时算好哈希；打不开 / 读失败返回 false
+    bool readFileHashed(const std::string& path, std::vector<uint8_t>& out, uint64_t& hash);
+} // namespace ke
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+namespace ke
+{
+    // 双缓冲快照：跨线程交接“每帧一份”的小块状态
+    // - 写线程（唯一）不加锁地改 back()，改完 publish()：交换前后台，并把新前台拷回后台作为下次修改的起点
+    // - 读线程 read() 拷走当前前台；锁只护住交换 / 拷贝这一瞬，写线程改 back() 时读线程不会等
+    template <typename T>
+    class DoubleBuffer
+    {
+    public:
+        T& back() noexcept { return slots_[front_ ^ 1u]; }
+
+        void publish()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            front_ ^= 1u;
+            ++serial_;
+            slots_[front_ ^ 1u] = slots_[front_];
+        }
+
+        T read() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return slots_[front_];
+        }
+
+        // 自 lastSerial 之后有新发布才拷出并更新 lastSerial；没有变化返回 false
+        bool readIfChanged(T& out, uint64_t& lastSerial) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (serial_ == lastSerial)
+                return false;
+            lastSerial = serial_;
+            out = slots_[front_];
+            return true;
+        }
+
+    private:
+        T                  slots_[2]{};
+        uint32_t           front_ = 0;
+        uint64_t           serial_ = 0;
+        mutable std::mutex mutex_;
+    };
+
+    // 轨道相机视角：主线程（输入）写，API 线程每帧读一次交给 Renderer
+    struct OrbitViewSnapshot
+    {
+        float eye[3]{0.0f, 0.0f, -2.5f};
+        float at[3]{0.0f, 0.0f, 0.0f};
+        float up[3]{0.0f, 1.0f, 0.0f};
+    };
+
+    // 运行时可按键调整的点光：主线程写，API 线程在有变化时转给 Renderer
+    struct LightingSnapshot
+    {
+        bool  pointOn = false;
+        float pointPos[3]{2.0f, 2.0f, 2.0f};
+        float pointRadius = 5.0f;
+        float pointColor[3]{1.0f, 1.0f, 1.0f};
+        float pointIntensity = 3.0f;
+    };
+
+    extern DoubleBuffer<OrbitViewSnapshot> g_orbitView; // 由 App.cpp 定义
+    extern DoubleBuffer<LightingSnapshot>  g_lighting;
+} // namespace ke
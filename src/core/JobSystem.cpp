@@ -0,0 +1,126 @@
+#include "core/JobSystem.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace ke
+{
+    bool JobSystem::init(uint32_t numWorkers)
+    {
+        if (!workers_.empty())
+            return true;
+
+        if (numWorkers == 0)
+        {
+            const uint32_t hw = std::thread::hardware_concurrency();
+            numWorkers = hw > 1 ? hw - 1 : 1;
+        }
+
+        quit_ = false;
+        workers_.reserve(numWorkers);
+        for (uint32_t i = 0; i < numWorkers; ++i)
+            workers_.emplace_back([this] { workerLoop(); });
+        return true;
+    }
+
+    void JobSystem::shutdown()
+    {
+        if (workers_.empty())
+            return;
+
+        waitIdle();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_)
+            t.join();
+        workers_.clear();
+    }
+
+    void JobSystem::submit(Job job)
+    {
+        if (workers_.empty())
+        {
+            job(); // 未初始化：退化为同步执行
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    void JobSystem::parallelFor(uint32_t count, uint32_t grain,
+                                const std::function<void(uint32_t, uint32_t)>& fn)
+    {
+        if (count == 0)
+            return;
+        grain = std::max(1u, grain);
+        const uint32_t chunks = (count + grain - 1) / grain;
+        if (chunks == 1 || workers_.empty())
+        {
+            fn(0, count);
+            return;
+        }
+
+        // 所有参与者从同一个原子计数器领块；调用线程也领，避免在工作线程里调用时死锁
+        struct Shared
+        {
+            std::atomic<uint32_t> next{0};
+            std::atomic<uint32_t> done{0};
+        };
+        auto shared = std::make_shared<Shared>();
+        auto runChunks = [shared, chunks, grain, count, &fn]
+        {
+            for (uint32_t c = shared->next.fetch_add(1); c < chunks; c = shared->next.fetch_add(1))
+            {
+                const uint32_t begin = c * grain;
+                fn(begin, std::min(count, begin + grain));
+                shared->done.fetch_add(1, std::memory_order_release);
+            }
+        };
+
+        const uint32_t helpers = std::min(numWorkers(), chunks - 1);
+        for (uint32_t i = 0; i < helpers; ++i)
+            submit(runChunks);
+
+        runChunks();
+        while (shared->done.load(std::memory_order_acquire) < chunks)
+            std::this_thread::yield();
+    }
+
+    void JobSystem::waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idleCv_.wait(lock, [this] { return queue_.empty() && running_ == 0; });
+    }
+
+    void JobSystem::workerLoop()
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return quit_ || !queue_.empty(); });
+                if (quit_ && queue_.empty())
+                    return;
+                job = std::move(queue_.front());
+                queue_.pop_front();
+                ++running_;
+            }
+
+            job();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --running_;
+                if (queue_.empty() && running_ == 0)
+                    idleCv_.notify_all();
+            }
+        }
+    }
+} // namespace ke
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ke
+{
+    // 简易线程池：后台任务（解码/流送等）+ 并行 for（调用线程也参与干活）
+    // 约定：任务里不能调用 bgfx API（bgfx 只允许在 API 线程调用），结果交回主线程再上传
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+
+        JobSystem() = default;
+        ~JobSystem() { shutdown(); }
+
+        JobSystem(const JobSystem&)            = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        // numWorkers = 0：按硬件线程数 - 1（至少 1 个）
+        bool init(uint32_t numWorkers = 0);
+        void shutdown(); // 等待队列清空后退出全部线程
+
+        // 投递一个异步任务（未 init 时直接在调用线程执行）
+        void submit(Job job);
+
+        // 把 [0, count) 切成每块 grain 个，分给工作线程与调用线程；返回时全部完成
+        void parallelFor(uint32_t count, uint32_t grain,
+                         const std::function<void(uint32_t begin, uint32_t end)>& fn);
+
+        // 阻塞到队列为空且没有正在执行的任务
+        void waitIdle();
+
+        uint32_t numWorkers() const noexcept { return static_cast<uint32_t>(workers_.size()); }
+
+    private:
+        void workerLoop();
+
+        std::vector<std::thread> workers_;
+        std::deque<Job>          queue_;
+        std::mutex               mutex_;
+        std::condition_variable  cv_;     // 有新任务 / 需要退出
+        std::condition_variable  idleCv_; // 队列清空且无任务在跑
+        uint32_t                 running_ = 0;
+        bool                     quit_    = false;
+    };
+} // namespace ke
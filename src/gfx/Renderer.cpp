@@ -7,10 +7,15 @@
 #include <bx/math.h>
 #include <spdlog/spdlog.h>
 #include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
 
 #include "gfx/shaders/shader_utils.h"
 #include "gfx/texture/TextureLoader.h"
 #include "io/gltf/GltfLoader.h" // 用你的加载器
+#include "scene/Scene.h"
+#include "core/ContentHash.h"
 #include "material/PbrMaterial.h"
 
 // 简易 HUD：打印当前通路与光照/统计
@@ -145,6 +150,53 @@ static inline void mulPos_(float out[4], const float m[16], float x, float y, fl
     out[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
     out[3] = m[3] * x + m[7] * y + m[11] * z + m[15];
 }
+// 某个 view 上一帧的 CPU/GPU 耗时（毫秒）；需要 BGFX_DEBUG_PROFILER，没有数据时返回 false
+// 按 view 名字找：渲染图每帧重新分配 view id，上一帧的 id 不一定还是同一个通道
+static bool viewTimesMs_(const char *viewName, double &cpuMs, double &gpuMs)
+{
+    const bgfx::Stats *st = bgfx::getStats();
+    for (uint16_t i = 0; st && i < st->numViews; ++i)
+    {
+        const bgfx::ViewStats &vs = st->viewStats[i];
+        if (std::strcmp(vs.name, viewName) != 0)
+            continue;
+        cpuMs = double(vs.cpuTimeEnd - vs.cpuTimeBegin) * 1000.0 / double(st->cpuTimerFreq);
+        gpuMs = st->gpuTimerFreq > 0 ? double(vs.gpuTimeEnd - vs.gpuTimeBegin) * 1000.0 / double(st->gpuTimerFreq) : 0.0;
+        return true;
+    }
+    return false;
+}
+
+// 局部包围盒 → 世界空间包围球（按最大轴缩放放大半径）
+static void worldSphere_(const float model[16], const float bmin[3], const float bmax[3], float c[3], float &r)
+{
+    float p[4];
+    mulPos_(p, model, 0.5f * (bmin[0] + bmax[0]), 0.5f * (bmin[1] + bmax[1]), 0.5f * (bmin[2] + bmax[2]));
+    c[0] = p[0];
+    c[1] = p[1];
+    c[2] = p[2];
+    const float ex = 0.5f * (bmax[0] - bmin[0]), ey = 0.5f * (bmax[1] - bmin[1]), ez = 0.5f * (bmax[2] - bmin[2]);
+    const float sx = std::sqrt(model[0] * model[0] + model[1] * model[1] + model[2] * model[2]);
+    const float sy = std::sqrt(model[4] * model[4] + model[5] * model[5] + model[6] * model[6]);
+    const float sz = std::sqrt(model[8] * model[8] + model[9] * model[9] + model[10] * model[10]);
+    r = std::sqrt(ex * ex + ey * ey + ez * ez) * std::max(sx, std::max(sy, sz));
+}
+
+// 包围球在屏幕上的投影直径（像素），用于纹理流送估算纹素密度（fovY 固定 60°）
+static float screenDiameterPx_(const float model[16], const float bmin[3], const float bmax[3],
+                               const float eye[3], float viewportH)
+{
+    float c[3], r;
+    worldSphere_(model, bmin, bmax, c, r);
+
+    const float dx = c[0] - eye[0], dy = c[1] - eye[1], dz = c[2] - eye[2];
+    const float d = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (d <= r)
+        return viewportH; // 相机在包围球内：按整屏算
+    const float tanHalfFov = 0.57735027f; // tan(30°)
+    return r / (d * tanHalfFov) * viewportH;
+}
+
 static bool aabbVisible_(const float pv[16], const float model[16],
                          const float bmin[3], const float bmax[3],
                          bool homogeneousDepth)
@@ -212,35 +264,26 @@ static bool aabbVisible_(const float pv[16], const float model[16],
     return true; // 没有任何一个平面把所有角点都排除 => 有交/在内，可见
 }
 
-namespace ke
+// 深度预通道用的位置流：每顶点 12 字节，预通道只读这一条流（position 在 MeshVertex 的最前 3 个 float）
+static bgfx::VertexBufferHandle createPositionStream_(const MeshData &md)
 {
-    struct OrbitViewSnapshot
+    bgfx::VertexLayout layout;
+    layout.begin()
+        .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+        .end();
+
+    const bgfx::Memory *mem = bgfx::alloc(static_cast<uint32_t>(md.vertices.size() * 3 * sizeof(float)));
+    float *dst = reinterpret_cast<float *>(mem->data);
+    for (size_t i = 0; i < md.vertices.size(); ++i)
     {
-        float eye[3];
-        float at[3];
-        float up[3];
-    };
-    extern OrbitViewSnapshot g_orbitView; // 由 App.cpp 定义并每帧写入
+        const float *p = reinterpret_cast<const float *>(&md.vertices[i]);
+        dst[i * 3 + 0] = p[0];
+        dst[i * 3 + 1] = p[1];
+        dst[i * 3 + 2] = p[2];
+    }
+    return bgfx::createVertexBuffer(mem, layout);
 }
 
-// 仅用于本文件的小结构：记录已上传到GPU的网格
-struct LoadedMesh
-{
-    bgfx::VertexBufferHandle vbh{BGFX_INVALID_HANDLE};
-    bgfx::IndexBufferHandle ibh{BGFX_INVALID_HANDLE};
-    bgfx::TextureHandle tex{BGFX_INVALID_HANDLE}; // 兼容旧路径
-    PbrMatHandle material{};                      // PBR 材质句柄
-    uint32_t indexCount{0};                       // 索引数(统计用)
-    float model[16]{};                            // 模型矩阵(M)
-
-    // 物体空间AABB（加载时计算）
-    float bmin[3]{0.0f, 0.0f, 0.0f};
-    float bmax[3]{0.0f, 0.0f, 0.0f};
-};
-
-// 渲染器内部缓存（兼容层，不侵入你的 Scene）
-static std::vector<LoadedMesh> s_loadedMeshes;
-
 // bgfx::Color0 使用 ABGR（AABBGGRR）。用工具函数避免手写容易出错。
 static inline uint32_t packABGR(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255)
 {
@@ -267,10 +310,15 @@ static void *sdlNativeWindow(SDL_Window *win)
 
 // ========== 生命周期 ==========
 bool Renderer::init(SDL_Window *window, int width, int height)
+{
+    return attachWindow(window, width, height) && init();
+}
+
+bool Renderer::attachWindow(SDL_Window *window, int width, int height)
 {
     if (!window)
     {
-        spdlog::error("Renderer::init: window is null");
+        spdlog::error("Renderer::attachWindow: window is null");
         return false;
     }
 
@@ -292,17 +340,27 @@ bool Renderer::init(SDL_Window *window, int width, int height)
     width_ = (uint32_t)w;
     height_ = (uint32_t)h;
 
-    void *nwh = sdlNativeWindow(window);
-    spdlog::info("Renderer::init: HWND={}", (void *)nwh);
-    if (!nwh)
+    nwh_ = sdlNativeWindow(window);
+    spdlog::info("Renderer::attachWindow: HWND={}", nwh_);
+    if (!nwh_)
+    {
+        spdlog::error("Renderer::attachWindow: native handle is null");
+        return false;
+    }
+    return true;
+}
+
+bool Renderer::init()
+{
+    if (!nwh_)
     {
-        spdlog::error("Renderer::init: native handle is null");
+        spdlog::error("Renderer::init: no window attached");
         return false;
     }
 
     bgfx::PlatformData pd{};
     pd.ndt = nullptr;
-    pd.nwh = nwh;
+    pd.nwh = nwh_;
     pd.context = nullptr;
     pd.backBuffer = nullptr;
     pd.backBufferDS = nullptr;
@@ -317,16 +375,25 @@ bool Renderer::init(SDL_Window *window, int width, int height)
     init.resolution.height = height_;
     init.resolution.reset = BGFX_RESET_VSYNC;
     init.platformData = pd;
+    // 着色器/程序二进制落盘缓存：第二次启动起跳过驱动编译
+    shaderCache_.init();
+    init.callback = &shaderCache_;
 
     if (!bgfx::init(init))
     {
-        spdlog::error("bgfx::init failed ({}x{}), HWND={}", width_, height_, (void *)nwh);
+        spdlog::error("bgfx::init failed ({}x{}), HWND={}", width_, height_, nwh_);
         return false;
     }
 
+    const bgfx::Caps *caps = bgfx::getCaps();
+    shaderCache_.setDevice(bgfx::getRendererType(), caps->vendorId, caps->deviceId);
+
     bgfx::setViewRect(viewId_, 0, 0, width_, height_);
     bgfx::setViewClear(viewId_, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0x303030ff, 1.0f, 0);
 
+    // 热重载可用时，包外的新产物优先（包只在重新链接时更新）；要在第一次加载着色器之前设好
+    ke_preferLooseShaders(shaderWatcher_.init(ke_shaderOutputDir()));
+
     if (!createPipelines())
         spdlog::error("createPipelines failed");
     if (!createGeometry())
@@ -334,35 +401,62 @@ bool Renderer::init(SDL_Window *window, int width, int height)
     if (!createTexture())
         spdlog::warn("createTexture failed");
 
-    pbr_.init();
-    matMgr_.init();
-
-    spdlog::info("Renderer init OK ({}x{}), hwnd={}", width_, height_, (void *)nwh);
+    pbr_.init(resCache_.programs());
+    jobs_.init();
+    resCache_.init();
+    resCache_.programs().setJobSystem(&jobs_); // 热重载在后台读着色器
+    resCache_.textures().setJobSystem(&jobs_); // 材质贴图异步解码
+    resCache_.textures().setStreaming(true, 64);
+    texStreamer_.init(resCache_.textures(), jobs_);
+    matMgr_.init(resCache_.textures());
+    resCache_.meshes().setMaterials(&matMgr_); // 网格归零时连同默认材质一起释放
+    texArrays_.init(jobs_, resCache_.textures());
+    matMgr_.setTextureArrays(&texArrays_); // 材质释放时归还数组组的引用
+    pbr_.setMaterialRegistry(&matMgr_.registry());
+    pbr_.setTextureArrays(&texArrays_);
+    clusters_.init(jobs_);
+    objLights_.init();
+    pbr_.setObjectLights(&objLights_);
+    shadows_.init();
+    pbr_.setShadows(&shadows_);
+    ibl_.init(jobs_);
+    pbr_.setImageBasedLighting(&ibl_);
+    deferred_.init(resCache_.programs(), pbr_);
+    dynRes_.init(resCache_.programs());
+    graph_.init(viewId_, kGraphViews);
+
+    spdlog::info("Renderer init OK ({}x{}, {}), hwnd={}", width_, height_,
+                 (bgfx::getCaps()->supported & BGFX_CAPS_RENDERER_MULTITHREADED) ? "MT" : "ST", nwh_);
     return true;
 }
 
 void Renderer::shutdown()
 {
-    // 清掉兼容层里缓存的网格
-    for (auto &m : s_loadedMeshes)
-    {
-        if (bgfx::isValid(m.vbh))
-            bgfx::destroy(m.vbh);
-        if (bgfx::isValid(m.ibh))
-            bgfx::destroy(m.ibh);
-        // 纹理由 ResourceCache 复用/释放，这里只销毁临时生成的棋盘纹理
-    }
-    s_loadedMeshes.clear();
+    // 网格缓冲不管还有没有实体引用都在这里销毁（材质随后由 matMgr_ 统一清）
+    resCache_.meshes().shutdown();
 
     destroyTexture();
     destroyGeometry();
     destroyPipelines();
+    shaderWatcher_.shutdown();
+    ke_preferLooseShaders(false);
 
+    graph_.shutdown(); // 临时目标池 + 缓存的帧缓冲（导入的阴影图集归 shadows_）
+    deferred_.shutdown();
+    dynRes_.shutdown();
     pbr_.shutdown();
+    texStreamer_.shutdown(); // 先等在途解码结束，再销毁纹理
+    texArrays_.shutdown();
+    clusters_.shutdown();
+    objLights_.shutdown();
+    shadows_.shutdown();
+    ibl_.shutdown();
     matMgr_.shutdown();
     resCache_.clear();
+    jobs_.shutdown();
 
     bgfx::shutdown();
+    ke_closeShaderArchive(); // 着色器经 makeRef 引用映射内存，bgfx 关闭后才能解除映射
 }
 
 void Renderer::resize(int width, int height)
@@ -375,7 +469,8 @@ void Renderer::resize(int width, int height)
 
 void Renderer::setDebug(uint32_t flags)
 {
-    bgfx::setDebug(flags);
+    debugFlags_ = flags;
+    bgfx::setDebug(flags | (showHelp_ ? BGFX_DEBUG_PROFILER : 0));
 }
 
 // ========== 灯光（转发给 ForwardPBR::lighting） ==========
@@ -410,6 +505,35 @@ void Renderer::setExposure(float e)
     pbr_.lighting().viewPos_exposure.w = e;
 }
 
+uint32_t Renderer::addPointLight(const float pos[3], float radius, const float color[3], float intensity)
+{
+    return clusters_.addPointLight({pos[0], pos[1], pos[2]}, radius, {color[0], color[1], color[2]}, intensity);
+}
+uint32_t Renderer::addSpotLight(const float pos[3], const float dir[3], float radius,
+                                float innerDeg, float outerDeg, const float color[3], float intensity)
+{
+    return clusters_.addSpotLight({pos[0], pos[1], pos[2]}, {dir[0], dir[1], dir[2]}, radius,
+                                  innerDeg, outerDeg, {color[0], color[1], color[2]}, intensity);
+}
+void Renderer::removeLight(uint32_t id)
+{
+    clusters_.removeLight(id);
+}
+void Renderer::clearLights()
+{
+    clusters_.clearLights();
+}
+
+void Renderer::setTextureArrayPacking(bool b)
+{
+    texArrays_.setEnabled(b);
+}
+
+void Renderer::setTextureBudget(uint64_t bytes)
+{
+    resCache_.textures().setBudget(bytes);
+}
+
 // ========== PBR（先留接口，稍后正式接入） ==========
 PbrMatHandle Renderer::createPbrMaterial(const PbrMaterialDesc &d)
 {
@@ -419,6 +543,11 @@ PbrMatHandle Renderer::createPbrMaterial(const PbrMaterialDesc &d)
     return h;
 }
 
+void Renderer::destroyPbrMaterial(PbrMatHandle h)
+{
+    matMgr_.destroy(h);
+}
+
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/type_ptr.hpp>
 void Renderer::drawMeshPBR(const float *modelMtx,
@@ -427,35 +556,37 @@ void Renderer::drawMeshPBR(const float *modelMtx,
                            PbrMatHandle h,
                            uint8_t viewId)
 {
+    const PbrMaterialGPU *mat = matMgr_.tryGet(h);
+    if (!mat)
+        return;
     glm::mat4 M = glm::make_mat4(modelMtx);
-    pbr_.draw(M, vbh, ibh, matMgr_.get(h), viewId);
+    pbr_.draw(M, vbh, ibh, *mat, viewId);
 }
 
 // ========== 内置 shader/几何 ==========
 bool Renderer::createPipelines()
 {
-    programSimple_ = ke_loadProgramDx11("vs_simple.bin", "fs_simple.bin");
-    programTex_ = ke_loadProgramDx11("vs_tex.bin", "fs_tex.bin");
-    programMesh_ = ke_loadProgramDx11("vs_mesh.bin", "fs_mesh.bin");
+    // 走共享的 ProgramRegistry：引用全部归还后才真正销毁，热重载时会重新读盘
+    ProgramRegistry &reg = resCache_.programs();
+    refSimple_ = reg.acquire("vs_simple.bin", "fs_simple.bin");
+    refTex_ = reg.acquire("vs_tex.bin", "fs_tex.bin");
+    refMesh_ = reg.acquire("vs_mesh.bin", "fs_mesh.bin");
+    programSimple_ = reg.handle(refSimple_);
+    programTex_ = reg.handle(refTex_);
+    programMesh_ = reg.handle(refMesh_);
     return true;
 }
 void Renderer::destroyPipelines()
 {
-    if (bgfx::isValid(programSimple_))
+    ProgramRegistry &reg = resCache_.programs();
+    for (ProgramRef *r : {&refSimple_, &refTex_, &refMesh_})
     {
-        bgfx::destroy(programSimple_);
-        programSimple_ = BGFX_INVALID_HANDLE;
-    }
-    if (bgfx::isValid(programTex_))
-    {
-        bgfx::destroy(programTex_);
-        programTex_ = BGFX_INVALID_HANDLE;
-    }
-    if (bgfx::isValid(programMesh_))
-    {
-        bgfx::destroy(programMesh_);
-        programMesh_ = BGFX_INVALID_HANDLE;
+        reg.release(*r);
+        *r = {};
     }
+    programSimple_ = BGFX_INVALID_HANDLE;
+    programTex_ = BGFX_INVALID_HANDLE;
+    programMesh_ = BGFX_INVALID_HANDLE;
 }
 
 bool Renderer::createGeometry()
@@ -578,109 +709,53 @@ bool Renderer::loadTextureFromFile(const std::string &path)
     return false;
 }
 
-// ========== glTF → Renderer 内部缓存 ==========
-bool Renderer::loadMeshFromGltf(const std::string &path)
+// ========== glTF → Scene ==========
+MeshHandle Renderer::uploadGltfMesh(const std::string &path, PbrMatHandle &material, std::string &baseColorPath)
 {
-    // 同上：无 Scene 引用，直接加载到内部缓存
+    MeshRegistry &meshes = resCache_.meshes();
+
+    // 1) 载入 glTF 网格（仅 baseColor、normal 两条路径）
     MeshData md;
-    std::string baseColorPath, normalPath;
+    std::string normalPath;
     if (!loadGltfMesh(path, md, &baseColorPath, &normalPath))
     {
         spdlog::error("[Renderer] glTF load failed: {}", path);
-        return false;
+        return {};
     }
     if (md.vertices.empty() || md.indices.empty())
     {
         spdlog::error("[Renderer] glTF mesh empty: {}", path);
-        return false;
-    }
-
-    bgfx::VertexLayout layout;
-    layout.begin()
-        .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
-        .add(bgfx::Attrib::Normal, 3, bgfx::AttribType::Float)
-        .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
-        .end();
-
-    const uint32_t vsize = static_cast<uint32_t>(md.vertices.size() * sizeof(MeshVertex));
-    const bgfx::Memory *vm = bgfx::copy(md.vertices.data(), vsize);
-    bgfx::VertexBufferHandle vbh = bgfx::createVertexBuffer(vm, layout);
-
-    const uint32_t isize = static_cast<uint32_t>(md.indices.size() * sizeof(uint16_t));
-    const bgfx::Memory *im = bgfx::copy(md.indices.data(), isize);
-    bgfx::IndexBufferHandle ibh = bgfx::createIndexBuffer(im);
-
-    if (!bgfx::isValid(vbh) || !bgfx::isValid(ibh))
-    {
-        spdlog::error("[Renderer] create VB/IB failed for {}", path);
-        return false;
-    }
-
-    // AABB
-    float bmin[3] = {+FLT_MAX, +FLT_MAX, +FLT_MAX};
-    float bmax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
-    for (size_t i = 0; i < md.vertices.size(); ++i)
-    {
-        const float *p = reinterpret_cast<const float *>(&md.vertices[i]);
-        bmin[0] = std::min(bmin[0], p[0]);
-        bmax[0] = std::max(bmax[0], p[0]);
-        bmin[1] = std::min(bmin[1], p[1]);
-        bmax[1] = std::max(bmax[1], p[1]);
-        bmin[2] = std::min(bmin[2], p[2]);
-        bmax[2] = std::max(bmax[2], p[2]);
+        return {};
     }
 
+    // 2) 组装 PBR 材质（BaseColor sRGB；Normal 线性）；每条路径一份，贴图相同时由纹理缓存去重
     PbrMaterialDesc mdesc{};
     mdesc.baseColorFactor = {1.0f, 1.0f, 1.0f, 1.0f};
     mdesc.metallic = 0.0f;
     mdesc.roughness = 0.9f;
     mdesc.emissive = {0.0f, 0.0f, 0.0f};
-    mdesc.texBaseColor = baseColorPath;
-    mdesc.texNormal = normalPath;
+    mdesc.texBaseColor = baseColorPath; // sRGB
+    mdesc.texNormal = normalPath;       // Linear
     mdesc.twoSided = true;
 
-    PbrMatHandle mat = createPbrMaterial(mdesc);
-
-    LoadedMesh lm;
-    lm.vbh = vbh;
-    lm.ibh = ibh;
-    lm.material = mat;
-    lm.indexCount = static_cast<uint32_t>(md.indices.size());
-    bx::mtxIdentity(lm.model);
-    lm.bmin[0] = bmin[0];
-    lm.bmin[1] = bmin[1];
-    lm.bmin[2] = bmin[2];
-    lm.bmax[0] = bmax[0];
-    lm.bmax[1] = bmax[1];
-    lm.bmax[2] = bmax[2];
-
-    s_loadedMeshes.push_back(lm);
-
-    spdlog::info("[Renderer] loadMeshFromGltf OK: vtx={}, idx={}, base='{}' norm='{}'",
-                 static_cast<uint32_t>(md.vertices.size()),
-                 static_cast<uint32_t>(md.indices.size()),
-                 baseColorPath, normalPath);
-    return true;
-}
-
-bool Renderer::addMeshFromGltfToScene(const std::string &path, Scene & /*unused*/)
-{
-    // 1) 载入 glTF 网格（仅 baseColor、normal 两条路径）
-    MeshData md;
-    std::string baseColorPath;
-    std::string normalPath;
-    if (!loadGltfMesh(path, md, &baseColorPath, &normalPath))
+    material = createPbrMaterial(mdesc);
+
+    // 3) 几何内容哈希：文件拷贝 / 另一条路径下的同一份几何不再上传，新路径登记成别名
+    //    先喂顶点数与索引数：两段字节直接拼接时，挪动分界也能得到同样的字节流
+    ke::ContentHasher hasher;
+    const uint64_t counts[2] = {md.vertices.size(), md.indices.size()};
+    hasher.update(counts, sizeof(counts));
+    hasher.update(md.vertices.data(), md.vertices.size() * sizeof(MeshVertex));
+    hasher.update(md.indices.data(), md.indices.size() * sizeof(md.indices[0]));
+    const uint64_t content = hasher.digest();
+    if (const MeshHandle h = meshes.findContent(content); h.valid())
     {
-        spdlog::error("[Renderer] glTF load failed: {}", path);
-        return false;
-    }
-    if (md.vertices.empty() || md.indices.empty())
-    {
-        spdlog::error("[Renderer] glTF mesh empty: {}", path);
-        return false;
+        meshes.addAlias(h, path, material, baseColorPath);
+        spdlog::info("[Renderer] glTF mesh deduplicated by content: {} -> mesh #{} ({:016x})", path, h.index, content);
+        return h;
     }
 
-    // 2) 顶点布局：pos/normal/uv
+    // 4) 顶点布局：pos/normal/uv
     bgfx::VertexLayout layout;
     layout.begin()
         .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
@@ -699,10 +774,12 @@ bool Renderer::addMeshFromGltfToScene(const std::string &path, Scene & /*unused*
     if (!bgfx::isValid(vbh) || !bgfx::isValid(ibh))
     {
         spdlog::error("[Renderer] create VB/IB failed for {}", path);
-        return false;
+        destroyPbrMaterial(material);
+        material = {};
+        return {};
     }
 
-    // 3) 计算物体空间AABB（假设 position 在 MeshVertex 的最前 3 个 float）
+    // 5) 计算物体空间AABB（假设 position 在 MeshVertex 的最前 3 个 float）
     float bmin[3] = {+FLT_MAX, +FLT_MAX, +FLT_MAX};
     float bmax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
     for (size_t i = 0; i < md.vertices.size(); ++i)
@@ -716,101 +793,333 @@ bool Renderer::addMeshFromGltfToScene(const std::string &path, Scene & /*unused*
         bmax[2] = std::max(bmax[2], p[2]);
     }
 
-    // 4) 组装 PBR 材质（BaseColor sRGB；Normal 线性）
-    PbrMaterialDesc mdesc{};
-    mdesc.baseColorFactor = {1.0f, 1.0f, 1.0f, 1.0f};
-    mdesc.metallic = 0.0f;
-    mdesc.roughness = 0.9f;
-    mdesc.emissive = {0.0f, 0.0f, 0.0f};
-    mdesc.texBaseColor = baseColorPath; // sRGB
-    mdesc.texNormal = normalPath;       // Linear
-    mdesc.twoSided = true;
+    // 6) 登记进网格表：缓冲与材质归它，引用归零后延迟销毁
+    MeshGPU gm;
+    gm.vbh = vbh;
+    gm.vbhPos = createPositionStream_(md);
+    gm.ibh = ibh;
+    gm.indexCount = static_cast<uint32_t>(md.indices.size());
+    gm.vertexCount = static_cast<uint32_t>(md.vertices.size());
+    gm.bytes = uint64_t(vsize) + uint64_t(gm.vertexCount) * 3 * sizeof(float) + isize;
+    std::copy(bmin, bmin + 3, gm.bmin);
+    std::copy(bmax, bmax + 3, gm.bmax);
+    auto ex = std::make_shared<MeshExportData>();
+    ex->cpuVertices.reserve(md.vertices.size());
+    for (const MeshVertex &v : md.vertices)
+        ex->cpuVertices.push_back({v.px, v.py, v.pz, v.nx, v.ny, v.nz, v.u, v.v});
+    ex->cpuIndices.assign(md.indices.begin(), md.indices.end());
+    gm.cpu = std::move(ex);
+
+    spdlog::info("[Renderer] glTF mesh uploaded: vtx={}, idx={}, base='{}' norm='{}'",
+                 gm.vertexCount, gm.indexCount, baseColorPath, normalPath);
+    return meshes.create(path, content, std::move(gm), material, baseColorPath);
+}
+
+bool Renderer::addMeshFromGltfToScene(const std::string &path, Scene &scene)
+{
+    MeshRegistry &meshes = resCache_.meshes();
+    scene.meshes = &meshes;
+
+    // 同一文件已经在表里：不读盘不上传，新实体共用缓冲与材质
+    PbrMatHandle mat;
+    std::string baseColorPath;
+    MeshHandle h = meshes.find(path, &mat, &baseColorPath);
+    if (!h.valid())
+        h = uploadGltfMesh(path, mat, baseColorPath);
+    const MeshGPU *gm = meshes.tryGet(h);
+    if (!gm)
+        return false;
 
-    PbrMatHandle mat = createPbrMaterial(mdesc);
-
-    // 5) 缓存
-    LoadedMesh lm;
-    lm.vbh = vbh;
-    lm.ibh = ibh;
-    lm.material = mat;
-    lm.indexCount = static_cast<uint32_t>(md.indices.size());
-    bx::mtxIdentity(lm.model);
-    lm.bmin[0] = bmin[0];
-    lm.bmin[1] = bmin[1];
-    lm.bmin[2] = bmin[2];
-    lm.bmax[0] = bmax[0];
-    lm.bmax[1] = bmax[1];
-    lm.bmax[2] = bmax[2];
-
-    s_loadedMeshes.push_back(lm);
-
-    spdlog::info("[Renderer] addMeshFromGltfToScene OK: vtx={}, idx={}, base='{}' norm='{}'",
-                 static_cast<uint32_t>(md.vertices.size()),
-                 static_cast<uint32_t>(md.indices.size()),
-                 baseColorPath, normalPath);
+    SceneRender r;
+    r.mesh = h; // 这份引用交给实体
+    r.material = mat;
+    SceneBounds b;
+    std::copy(gm->bmin, gm->bmin + 3, b.min);
+    std::copy(gm->bmax, gm->bmax + 3, b.max);
+    scene.add(r, b, {gm->cpu, baseColorPath});
+    ++staticSerial_; // 静态投射体变了：缓存的阴影级要重画
+
+    spdlog::info("[Renderer] addMeshFromGltfToScene OK: {} (mesh #{}, {} refs in registry)",
+                 path, h.index, meshes.stats().refs);
     return true;
 }
 
-// ========== Scene 渲染（遍历内部缓存与光照Uniform） ==========
-void Renderer::renderScene(const Scene &, Camera &)
+// ========== Scene 渲染（遍历场景的 SoA 数组与光照Uniform） ==========
+void Renderer::renderScene(const Scene &scene, Camera &)
 {
     float view[16], proj[16];
 
-    // 1) 相机（Orbit）与投影
+    // 1) 相机（Orbit）与投影；各通道在自己的 view 上设置矩阵
     {
-        const bx::Vec3 eye = {ke::g_orbitView.eye[0], ke::g_orbitView.eye[1], ke::g_orbitView.eye[2]};
-        const bx::Vec3 at = {ke::g_orbitView.at[0], ke::g_orbitView.at[1], ke::g_orbitView.at[2]};
-        const bx::Vec3 up = {ke::g_orbitView.up[0], ke::g_orbitView.up[1], ke::g_orbitView.up[2]};
+        const bx::Vec3 eye = {orbit_.eye[0], orbit_.eye[1], orbit_.eye[2]};
+        const bx::Vec3 at = {orbit_.at[0], orbit_.at[1], orbit_.at[2]};
+        const bx::Vec3 up = {orbit_.up[0], orbit_.up[1], orbit_.up[2]};
         bx::mtxLookAt(view, eye, at, up);
         const float aspect = (height_ > 0) ? float(width_) / float(height_) : 1.0f;
         bx::mtxProj(proj, 60.0f, aspect, 0.1f, 100.0f, bgfx::getCaps()->homogeneousDepth);
-        bgfx::setViewTransform(viewId_, view, proj);
         setViewPos(eye.x, eye.y, eye.z);
     }
 
-    bgfx::touch(viewId_);
+    // 动态分辨率：按上一帧 GPU 耗时定本帧场景尺寸；场景各通道都画到同一块区域
+    dynRes_.update((uint16_t)width_, (uint16_t)height_);
+    uint16_t rect[4];
+    dynRes_.viewRect(rect);
+    const uint16_t rw = rect[2], rh = rect[3];
+
+    // 延迟着色时 G-buffer 本身就是深度通道，不再做预通道
+    const bool deferred = deferredShading();
+    const bool prepass = depthPrepass_ && !deferred;
+
+    updateShaders();
+
+    // 纹理：上传后台解码完的贴图、换入上一帧请求的 mip，材质重新解析句柄
+    resCache_.textures().update();
+    texStreamer_.update();
+    matMgr_.collectGarbage();
+    resCache_.meshes().collectGarbage();
+    matMgr_.syncTextures();
+    texArrays_.update(matMgr_, resCache_.textures());
+
+    // 2) 光照：方向光 / 环境等帧级 uniform 由 ForwardPBR::bindLighting 随 draw 上传
+    //    局部光：旧的单点光也并进去，和其余局部光走同一条路径（分簇 / 逐物体光表二选一）
+    //    延迟光照是全屏一次，只能查簇表
+    const bool clustered = deferred ? clusters_.supported() : clusteredLighting();
+    {
+        const auto &L = pbr_.lighting();
+        ClusteredLighting::Light legacy;
+        legacy.pos = {L.pointPos_radius.x, L.pointPos_radius.y, L.pointPos_radius.z};
+        legacy.radius = L.pointPos_radius.w;
+        legacy.color = {L.pointCol_intensity.x, L.pointCol_intensity.y, L.pointCol_intensity.z};
+        legacy.intensity = L.pointCol_intensity.w;
+        if (clustered)
+            clusters_.update(view, proj, rw, rh, 0.1f, 100.0f, &legacy);
+        else
+            objLights_.build(clusters_, &legacy);
+        pbr_.setClusteredLighting(clustered ? &clusters_ : nullptr);
+    }
 
-    // 2) 光照 uniform
-    static bgfx::UniformHandle u_lightDir = BGFX_INVALID_HANDLE;
-    static bgfx::UniformHandle u_pointPosRad = BGFX_INVALID_HANDLE;
-    static bgfx::UniformHandle u_pointColInt = BGFX_INVALID_HANDLE;
-    if (!bgfx::isValid(u_lightDir))
-        u_lightDir = bgfx::createUniform("u_lightDir", bgfx::UniformType::Vec4);
-    if (!bgfx::isValid(u_pointPosRad))
-        u_pointPosRad = bgfx::createUniform("u_pointPosRad", bgfx::UniformType::Vec4);
-    if (!bgfx::isValid(u_pointColInt))
-        u_pointColInt = bgfx::createUniform("u_pointColInt", bgfx::UniformType::Vec4);
-
-    bgfx::setUniform(u_lightDir, &pbr_.lighting().lightDir_ambient, 1);
-    bgfx::setUniform(u_pointPosRad, &pbr_.lighting().pointPos_radius, 1);
-    bgfx::setUniform(u_pointColInt, &pbr_.lighting().pointCol_intensity, 1);
-
-    // 3) Grid（可选保留）
-    if (bgfx::isValid(programSimple_))
-        drawDebugGrid_(viewId_, programSimple_, 10, 0.5f, 0.0f, 5, 0x40FFFFFF, 0x80FFFFFF);
-
-    // 4) 视锥裁剪：PV = P * V
+    // 3) 级联阴影：每级各自裁剪投射体，缓存住的远级本帧不加通道
+    const uint32_t entityCount = scene.size();
+    const SceneRender *rend = scene.render.data();
+    const SceneMat4 *world = scene.world.data();
+    const SceneBounds *bounds = scene.bounds.data();
+    const MeshRegistry &meshes = resCache_.meshes(); // 实体只存句柄，缓冲按句柄取（同一网格的实体取到同一份）
+    struct CasterRef
+    {
+        uint32_t entity;
+        const MeshGPU *mesh;
+    };
+    std::vector<CasterRef> meshOf;
+    if (shadows_.enabled())
+    {
+        std::vector<CascadedShadows::Caster> casters;
+        casters.reserve(entityCount);
+        bool staticMoved = entityCount != shadowEntities_; // 删实体同样会留下旧影子
+        shadowEntities_ = entityCount;
+        for (uint32_t i = 0; i < entityCount; ++i)
+        {
+            const SceneRender &r = rend[i];
+            const MeshGPU *gm = meshes.tryGet(r.mesh);
+            if (!gm || !matMgr_.tryGet(r.material))
+                continue;
+            CascadedShadows::Caster c;
+            worldSphere_(world[i].m, bounds[i].min, bounds[i].max, c.center, c.radius);
+            c.dynamic = r.dynamic || scene.moved[i]; // 本帧变换重算过：所在级不能用缓存
+            // 静态投射体挪了位置：旧位置的影子还烘在别的缓存级里，只标 dynamic 清不掉，整体作废
+            if (scene.moved[i] && !r.dynamic)
+                staticMoved = true;
+            casters.push_back(c);
+            meshOf.push_back({i, gm});
+        }
+
+        // 着色器把 u_lightDir 当作指向光源的 L，光线传播方向是它的反方向
+        const auto &L = pbr_.lighting().lightDir_ambient;
+        CascadedShadows::Frame sf{};
+        sf.view = view;
+        sf.fovY = 60.0f;
+        sf.aspect = (height_ > 0) ? float(width_) / float(height_) : 1.0f;
+        sf.zNear = 0.1f;
+        sf.shadowFar = 50.0f;
+        sf.lightDir[0] = -L.x;
+        sf.lightDir[1] = -L.y;
+        sf.lightDir[2] = -L.z;
+        if (staticMoved)
+            ++staticSerial_;
+        sf.staticSerial = staticSerial_;
+        shadows_.update(sf, casters);
+    }
+
+    // 4) 视锥裁剪：PV = P * V；可见网格先收集，由下面的通道提交
     float pv[16];
     bx::mtxMul(pv, proj, view);
     const bool hd = bgfx::getCaps()->homogeneousDepth;
 
-    // 5) 提交可见网格（走 PBR）
+    struct Visible
+    {
+        uint32_t entity;
+        const MeshGPU *mesh;
+        const PbrMaterialGPU *mat;
+        ObjectLights::List lights; // 逐物体光表模式才填
+        bool prepassed;            // 预通道画过深度：主通道用 DEPTH_TEST_EQUAL
+    };
     uint32_t draws = 0, tris = 0, culled = 0;
-    for (const auto &m : s_loadedMeshes)
+    std::vector<Visible> visible;
+    std::vector<DrawItem> deferredItems; // 延迟路径交给 DeferredPBR 的 G-buffer 通道
+    if (deferred)
+        deferredItems.reserve(entityCount);
+    else
+        visible.reserve(entityCount);
+    for (uint32_t i = 0; i < entityCount; ++i)
     {
-        if (!bgfx::isValid(m.vbh) || !bgfx::isValid(m.ibh))
-            continue;
-
-        // 裁剪测试
-        if (!aabbVisible_(pv, m.model, m.bmin, m.bmax, hd))
+        const SceneRender &r = rend[i];
+        const MeshGPU *gm = meshes.tryGet(r.mesh);
+        if (!gm)
+            continue; // 纯变换节点 / 网格已释放
+
+        // 裁剪测试：只读 world + bounds 两条数组
+        const float *model = world[i].m;
+        if (!aabbVisible_(pv, model, bounds[i].min, bounds[i].max, hd))
         {
             ++culled;
             continue;
         }
 
-        drawMeshPBR(m.model, m.vbh, m.ibh, m.material, viewId_);
+        const PbrMaterialGPU *mat = matMgr_.tryGet(r.material);
+        if (!mat)
+            continue; // 材质已销毁（过期句柄）
+
+        texStreamer_.requestMaterial(*mat, screenDiameterPx_(model, bounds[i].min, bounds[i].max, orbit_.eye, float(rh)));
         ++draws;
-        tris += m.indexCount / 3;
+        tris += gm->indexCount / 3;
+
+        if (deferred)
+        {
+            DrawItem item;
+            item.vbh = gm->vbh;
+            item.ibh = gm->ibh;
+            item.numIndices = gm->indexCount;
+            std::copy(model, model + 16, item.model);
+            item.material = mat;
+            deferredItems.push_back(item);
+            continue;
+        }
+
+        Visible v{i, gm, mat, {}, false};
+        // 逐物体光表：按包围球挑最有影响的几盏
+        if (!clustered)
+        {
+            float c[3], rad;
+            worldSphere_(model, bounds[i].min, bounds[i].max, c, rad);
+            objLights_.gather(c, rad, v.lights);
+        }
+        visible.push_back(v);
+    }
+
+    // 5) 渲染图：声明本帧的通道与目标，剔除/排序/分配 view 与临时目标后依次执行
+    graph_.reset();
+    const RGResource backbuffer = graph_.importBackbuffer();
+    RGResource color = backbuffer, depth = backbuffer;
+    if (dynRes_.active())
+    {
+        color = graph_.createTexture("Scene.Color", dynRes_.colorDesc());
+        depth = graph_.createTexture("Scene.Depth", dynRes_.depthDesc());
+    }
+    RGResource atlas;
+    if (shadows_.enabled())
+        atlas = graph_.importTexture("ShadowAtlas", shadows_.atlas());
+
+    for (uint32_t c = 0; shadows_.enabled() && c < CascadedShadows::kCascades; ++c)
+    {
+        if (!shadows_.renders(c))
+            continue;
+        graph_.addPass(
+            "Shadow cascade",
+            [atlas](RenderGraphBuilder &b)
+            { b.write(atlas); },
+            [this, c, &meshOf, rend, world](const RenderContext &rc)
+            {
+                shadows_.setupView(c, rc.view);
+                for (uint32_t ci : shadows_.casters(c))
+                {
+                    const CasterRef &cr = meshOf[ci];
+                    const MeshGPU &m = *cr.mesh;
+                    pbr_.drawDepth(glm::make_mat4(world[cr.entity].m), bgfx::isValid(m.vbhPos) ? m.vbhPos : m.vbh, m.ibh,
+                                   *matMgr_.tryGet(rend[cr.entity].material), uint8_t(rc.view));
+                }
+            });
+    }
+
+    // 场景目标的第一个写者：清颜色 + 深度，之后的通道都不再清屏
+    sceneClear_.setTargets(color, depth);
+    graph_.addPass("Clear", sceneClear_);
+
+    const auto sceneTargets = [=](RenderGraphBuilder &b)
+    {
+        b.write(color);
+        b.write(depth);
+        b.viewRect(rect[0], rect[1], rect[2], rect[3]);
+    };
+    if (prepass)
+    {
+        graph_.addPass(
+            "Depth pre-pass", sceneTargets,
+            [&](const RenderContext &rc)
+            {
+                bgfx::setViewTransform(rc.view, view, proj);
+                for (Visible &v : visible)
+                {
+                    const MeshGPU &m = *v.mesh;
+                    v.prepassed = pbr_.drawDepth(glm::make_mat4(world[v.entity].m), bgfx::isValid(m.vbhPos) ? m.vbhPos : m.vbh,
+                                                 m.ibh, *v.mat, uint8_t(rc.view));
+                }
+            });
+    }
+
+    if (deferred)
+    {
+        deferred_.addPasses(graph_, color, depth, rect, atlas);
+    }
+    else
+    {
+        graph_.addPass(
+            "PBR",
+            [=](RenderGraphBuilder &b)
+            {
+                b.read(atlas);
+                sceneTargets(b);
+            },
+            [&](const RenderContext &rc)
+            {
+                bgfx::setViewTransform(rc.view, view, proj);
+                for (const Visible &v : visible)
+                {
+                    pbr_.setDepthEqual(v.prepassed);
+                    pbr_.draw(glm::make_mat4(world[v.entity].m), v.mesh->vbh, v.mesh->ibh, *v.mat, uint8_t(rc.view),
+                              clustered ? nullptr : &v.lights);
+                }
+                pbr_.setDepthEqual(false);
+            });
+    }
+
+    // Grid（可选保留）：单独一个叠加通道，排在前向主通道 / 延迟光照之后
+    graph_.addPass(
+        "Debug grid", sceneTargets,
+        [&](const RenderContext &rc)
+        {
+            bgfx::setViewTransform(rc.view, view, proj);
+            if (bgfx::isValid(programSimple_))
+                drawDebugGrid_(uint8_t(rc.view), programSimple_, 10, 0.5f, 0.0f, 5, 0x40FFFFFF, 0x80FFFFFF);
+        });
+
+    // 场景画在缩小的离屏目标上时放大回后台缓冲
+    dynRes_.addUpscalePass(graph_, color, backbuffer);
+
+    graph_.compile();
+    {
+        const RenderContext rc{viewId_, view, proj,
+                               {orbit_.eye[0], orbit_.eye[1], orbit_.eye[2]},
+                               float(SDL_GetTicks()) * 0.001f, deferredItems};
+        graph_.execute(rc);
     }
 
     // 6) HUD
@@ -818,10 +1127,11 @@ void Renderer::renderScene(const Scene &, Camera &)
     {
         const auto &L = pbr_.lighting();
         bgfx::dbgTextClear();
-        bgfx::dbgTextPrintf(0, 0, 0x0f, "Path: Scene (PBR + Culling)");
-        bgfx::dbgTextPrintf(0, 1, 0x0f, "Draws: %u  Tris: %u  Culled: %u", draws, tris, culled);
+        bgfx::dbgTextPrintf(0, 0, 0x0f, "Path: Scene (%s PBR + Culling)", deferred ? "Deferred" : "Forward");
+        bgfx::dbgTextPrintf(0, 1, 0x0f, "Draws: %u  Tris: %u  Culled: %u  Xform: %u/%u updated", draws, tris, culled,
+                            scene.lastUpdated(), scene.size());
         bgfx::dbgTextPrintf(0, 2, 0x0f, "Eye: (%.2f, %.2f, %.2f)",
-                            ke::g_orbitView.eye[0], ke::g_orbitView.eye[1], ke::g_orbitView.eye[2]);
+                            orbit_.eye[0], orbit_.eye[1], orbit_.eye[2]);
         bgfx::dbgTextPrintf(0, 3, 0x0f, "DirL: (%.2f, %.2f, %.2f)  amb=%.2f",
                             L.lightDir_ambient.x, L.lightDir_ambient.y, L.lightDir_ambient.z, L.lightDir_ambient.w);
         const bool pOn = (L.pointPos_radius.w > 0.0f) && (L.pointCol_intensity.w > 0.0f);
@@ -830,6 +1140,78 @@ void Renderer::renderScene(const Scene &, Camera &)
                             L.pointPos_radius.x, L.pointPos_radius.y, L.pointPos_radius.z, L.pointPos_radius.w,
                             L.pointCol_intensity.w);
         bgfx::dbgTextPrintf(0, 5, 0x0f, "Exposure: %.2f", L.viewPos_exposure.w);
+        const auto &ts = resCache_.textures().stats();
+        bgfx::dbgTextPrintf(0, 6, 0x0f, "Tex: %u (%u idle)  %.1f/%.1f MB  hit=%llu miss=%llu evict=%llu  dedup=%u (-%.1f MB)",
+                            ts.entries, ts.unreferenced,
+                            ts.bytesResident / (1024.0 * 1024.0), ts.budgetBytes / (1024.0 * 1024.0),
+                            (unsigned long long)ts.hits, (unsigned long long)ts.misses,
+                            (unsigned long long)ts.evictions, ts.aliases, ts.bytesDeduped / (1024.0 * 1024.0));
+        const auto &ss = texStreamer_.stats();
+        bgfx::dbgTextPrintf(0, 7, 0x0f, "Stream: %u tex  loading=%u  inflight=%u  in=%llu out=%llu",
+                            ss.streamable, ts.loading, ss.inFlight,
+                            (unsigned long long)ss.streamedIn, (unsigned long long)ss.streamedOut);
+        const auto &as = texArrays_.stats();
+        bgfx::dbgTextPrintf(0, 8, 0x0f, "TexArr: %s  groups=%u layers=%u mats=%u pending=%u  %.1f MB",
+                            texArrays_.enabled() ? "ON " : "OFF", as.groups, as.layers, as.materials, as.pending,
+                            as.bytes / (1024.0 * 1024.0));
+        const auto &ps = resCache_.programs().stats();
+        const auto sc = shaderCache_.stats();
+        bgfx::dbgTextPrintf(0, 9, 0x0f, "Programs: %u  shaders=%u  hit=%llu miss=%llu  | BinCache: hit=%llu miss=%llu %.1f MB",
+                            ps.programs, ps.shaders, (unsigned long long)ps.hits, (unsigned long long)ps.misses,
+                            (unsigned long long)sc.hits, (unsigned long long)sc.misses, sc.bytes / (1024.0 * 1024.0));
+        if (clustered)
+        {
+            const auto &cs = clusters_.stats();
+            bgfx::dbgTextPrintf(0, 10, 0x0f, "Lights: Clustered %u/%u visible  clusters=%u idx=%u max=%u%s  %.2f ms",
+                                cs.visible, cs.lights, cs.clustersUsed, cs.indices,
+                                cs.maxPerCluster, cs.overflow ? " (overflow)" : "", cs.cpuMs);
+        }
+        else
+        {
+            const auto &os = objLights_.stats();
+            bgfx::dbgTextPrintf(0, 10, 0x0f, "Lights: PerObject %u (global %u)  objects=%u  avg=%.2f  clipped=%u",
+                                os.lights, os.global, os.objects,
+                                os.objects ? float(os.assigned) / float(os.objects) : 0.0f, os.clipped);
+        }
+        double preCpu = 0.0, preGpu = 0.0, mainCpu = 0.0, mainGpu = 0.0;
+        const bool havePre = prepass && viewTimesMs_("Depth pre-pass", preCpu, preGpu);
+        viewTimesMs_(deferred ? "Deferred lighting" : "PBR", mainCpu, mainGpu);
+        double gbCpu = 0.0, gbGpu = 0.0;
+        if (deferred && viewTimesMs_("G-buffer", gbCpu, gbGpu))
+            bgfx::dbgTextPrintf(0, 11, 0x0f, "Deferred: gbuffer gpu=%.2f cpu=%.2f ms (%u draws)  | lighting gpu=%.2f cpu=%.2f ms",
+                                gbGpu, gbCpu, deferred_.stats().draws, mainGpu, mainCpu);
+        else if (havePre)
+            bgfx::dbgTextPrintf(0, 11, 0x0f, "Z-Prepass: ON   pre gpu=%.2f cpu=%.2f ms  | main gpu=%.2f cpu=%.2f ms",
+                                preGpu, preCpu, mainGpu, mainCpu);
+        else
+            bgfx::dbgTextPrintf(0, 11, 0x0f, "Z-Prepass: %s  main gpu=%.2f cpu=%.2f ms",
+                                depthPrepass_ ? "ON " : "OFF", mainGpu, mainCpu);
+        const auto &shs = shadows_.stats();
+        bgfx::dbgTextPrintf(0, 12, 0x0f, "Shadows: %s  casters %u%s %u%s %u%s %u%s  redraws=%u",
+                            shadows_.enabled() ? "ON " : (shadows_.supported() ? "OFF" : "N/A"),
+                            shs.casters[0], shs.cached[0] ? "(c)" : "", shs.casters[1], shs.cached[1] ? "(c)" : "",
+                            shs.casters[2], shs.cached[2] ? "(c)" : "", shs.casters[3], shs.cached[3] ? "(c)" : "",
+                            shs.redraws);
+        const auto &is = ibl_.stats();
+        if (ibl_.loaded())
+            bgfx::dbgTextPrintf(0, 13, 0x0f, "IBL: %s  %016llx %s  sh=%.1f spec=%.1f lut=%.1f ms",
+                                ibl_.enabled() ? "ON " : "OFF", (unsigned long long)is.hash,
+                                is.fromCache ? "cached" : "computed", is.shMs, is.specMs, is.lutMs);
+        else
+            bgfx::dbgTextPrintf(0, 13, 0x0f, "IBL: %s", ibl_.supported() ? "no environment (I to load)" : "N/A");
+        const auto &ds = dynRes_.stats();
+        bgfx::dbgTextPrintf(0, 14, 0x0f, "DynRes: %s  scale=%.2f  %ux%u  frame=%.2f ms (%s) target=%.1f  changes=%u",
+                            dynRes_.enabled() ? "ON " : (dynRes_.supported() ? "OFF" : "N/A"),
+                            ds.scale, ds.width, ds.height, ds.frameMs, ds.gpuTimed ? "gpu" : "no gpu timer, hold",
+                            dynRes_.targetFrameMs(), ds.changes);
+        const auto &gs = graph_.stats();
+        bgfx::dbgTextPrintf(0, 15, 0x0f, "Graph: passes %u (culled %u)  transient %u -> %u tex (aliased %u)  pool %u  %.1f MB",
+                            gs.passes, gs.culled, gs.transients, gs.physical, gs.aliased, gs.pooled,
+                            gs.bytes / (1024.0 * 1024.0));
+        const auto &ms = meshes.stats();
+        bgfx::dbgTextPrintf(0, 16, 0x0f, "Meshes: %u shared by %u entities  hit=%llu miss=%llu  pending=%u  %.1f MB  dedup=%u (-%.1f MB)",
+                            ms.meshes, ms.refs, (unsigned long long)ms.hits, (unsigned long long)ms.misses,
+                            ms.pending, ms.bytes / (1024.0 * 1024.0), ms.aliases, ms.bytesDeduped / (1024.0 * 1024.0));
     }
 
     // 7) 结束
@@ -845,9 +1227,9 @@ void Renderer::renderFrame(Camera &, uint32_t &outDraws, uint32_t &outTris, floa
     // --- 相机（Orbit 快照） ---
     float view[16], proj[16];
     {
-        const bx::Vec3 eye = {ke::g_orbitView.eye[0], ke::g_orbitView.eye[1], ke::g_orbitView.eye[2]};
-        const bx::Vec3 at = {ke::g_orbitView.at[0], ke::g_orbitView.at[1], ke::g_orbitView.at[2]};
-        const bx::Vec3 up = {ke::g_orbitView.up[0], ke::g_orbitView.up[1], ke::g_orbitView.up[2]};
+        const bx::Vec3 eye = {orbit_.eye[0], orbit_.eye[1], orbit_.eye[2]};
+        const bx::Vec3 at = {orbit_.at[0], orbit_.at[1], orbit_.at[2]};
+        const bx::Vec3 up = {orbit_.up[0], orbit_.up[1], orbit_.up[2]};
 
         bx::mtxLookAt(view, eye, at, up);
         const float aspect = (height_ > 0) ? (float)width_ / (float)height_ : 1.0f;
@@ -855,7 +1237,15 @@ void Renderer::renderFrame(Camera &, uint32_t &outDraws, uint32_t &outTris, floa
         bgfx::setViewTransform(viewId_, view, proj);
     }
 
+    // 场景路径的渲染图会改写 viewId_ 起的 view（目标 / 清屏 / 模式），演示路径始终画到后台缓冲
+    bgfx::setViewName(viewId_, "Demo");
+    bgfx::setViewFrameBuffer(viewId_, BGFX_INVALID_HANDLE);
+    bgfx::setViewRect(viewId_, 0, 0, width_, height_);
+    bgfx::setViewMode(viewId_, bgfx::ViewMode::Default);
+    bgfx::setViewClear(viewId_, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0x303030ff, 1.0f, 0);
+
     bgfx::touch(viewId_);
+    updateShaders();
 
     // --- 状态：双面渲染，避免旋转时“消失” ---
     static const uint64_t kStateDemoNoCull =
@@ -932,7 +1322,7 @@ void Renderer::renderFrame(Camera &, uint32_t &outDraws, uint32_t &outTris, floa
         bgfx::dbgTextPrintf(0, 0, 0x0f, "Path: Demo (%s)", drawMode_ == DrawMode::Triangle ? "Triangle" : "Quad");
         bgfx::dbgTextPrintf(0, 1, 0x0f, "Draws: %u  Tris: %u", outDraws, outTris);
         bgfx::dbgTextPrintf(0, 2, 0x0f, "Eye: (%.2f, %.2f, %.2f)",
-                            ke::g_orbitView.eye[0], ke::g_orbitView.eye[1], ke::g_orbitView.eye[2]);
+                            orbit_.eye[0], orbit_.eye[1], orbit_.eye[2]);
         bgfx::dbgTextPrintf(0, 3, 0x0f, "Exposure: %.2f", L.viewPos_exposure.w);
         bgfx::dbgTextPrintf(0, 5, 0x0a, "[F3] wireframe   [ [ / ] ] exposure   [G] point light");
     }
@@ -940,12 +1330,40 @@ void Renderer::renderFrame(Camera &, uint32_t &outDraws, uint32_t &outTris, floa
     bgfx::frame();
 }
 
-void Renderer::setShowHelp(bool b) { showHelp_ = b; }
+void Renderer::setShowHelp(bool b)
+{
+    showHelp_ = b;
+    setDebug(debugFlags_);
+}
 void Renderer::setUseTexture(bool b) { useTexture_ = b; }
 
 bool Renderer::hotReloadShaders()
 {
-    destroyPipelines();
-    bool ok = createPipelines();
-    return ok;
+    resCache_.programs().reloadAll(ke_shaderOutputDir());
+    return true;
+}
+
+void Renderer::updateShaders()
+{
+    ProgramRegistry &reg = resCache_.programs();
+
+    std::vector<std::string> changed;
+    shaderWatcher_.poll(changed);
+    if (!changed.empty())
+        reg.reload(shaderWatcher_.dir(), changed);
+    reg.update();
+
+    if (programGen_ == reg.generation())
+        return;
+    programGen_ = reg.generation();
+    // 换过 program 的只有句柄值，引用不变：重新取一遍
+    programSimple_ = reg.handle(refSimple_);
+    programTex_ = reg.handle(refTex_);
+    programMesh_ = reg.handle(refMesh_);
+    for (uint32_t i = 0; i < matMgr_.count(); ++i)
+    {
+        auto &gpu = const_cast<PbrMaterialGPU &>(matMgr_.at(i));
+        gpu.program = BGFX_INVALID_HANDLE;
+        pbr_.attachProgramTo(gpu);
+    }
 }
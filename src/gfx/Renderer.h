@@ -31,6 +31,19 @@ class Camera;
 #include "gfx/pipeline/ForwardPBR.h"
 #include "gfx/material/PbrMaterial.h"
 #include "resource/ResourceCache.h"
+#include "gfx/texture/TextureStreamer.h"
+#include "gfx/texture/TextureArrayPacker.h"
+#include "core/JobSystem.h"
+#include "core/FrameSnapshot.h"
+#include "gfx/shaders/ShaderCache.h"
+#include "gfx/shaders/ShaderWatcher.h"
+#include "gfx/lighting/ClusteredLighting.h"
+#include "gfx/lighting/CascadedShadows.h"
+#include "gfx/lighting/ImageBasedLighting.h"
+#include "gfx/pipeline/DeferredPBR.h"
+#include "gfx/pipeline/DynamicResolution.h"
+#include "gfx/pipeline/RenderGraph.h"
+#include "gfx/pipeline/ClearPass.h"
 
 // 渲染模式（演示路径用）
 enum class DrawMode : uint8_t
@@ -46,15 +59,19 @@ class Renderer
 {
 public:
   // ===== 生命周期 =====
+  // 多线程 bgfx：attachWindow 在主线程（渲染线程）调，显示窗口并取原生句柄；
+  // init / shutdown 及以下全部接口只在 API 线程调。单线程时用三参数的 init 一步完成
   bool init(SDL_Window *window, int width, int height);
+  bool attachWindow(SDL_Window *window, int width, int height);
+  bool init();
   void shutdown();
   void resize(int width, int height);
   void setShowHelp(bool b);
   void setUseTexture(bool b);
-  bool hotReloadShaders();
+  bool hotReloadShaders(); // 后台重读全部已加载的着色器，下一帧边界生效（不阻塞）
 
   // ===== 调试/视图 =====
-  void setDebug(uint32_t flags);
+  void setDebug(uint32_t flags); // HUD 打开时额外开 BGFX_DEBUG_PROFILER（分 view 计时）
   void setViewId(uint8_t id) { viewId_ = id; }
   uint8_t viewId() const { return viewId_; }
 
@@ -67,9 +84,46 @@ public:
                      const float color[3], float intensity);
   void setViewPos(float x, float y, float z);
   void setExposure(float e);
+  // 本帧的轨道相机视角（App 每帧从双缓冲快照里取一份交进来）
+  void setOrbitView(const ke::OrbitViewSnapshot &v)
+  {
+    orbit_ = v;
+    setViewPos(v.eye[0], v.eye[1], v.eye[2]);
+  }
+
+  // ===== 局部光（分簇前向，数量不限于 1 盏；id 删除后复用）=====
+  uint32_t addPointLight(const float pos[3], float radius, const float color[3], float intensity);
+  uint32_t addSpotLight(const float pos[3], const float dir[3], float radius,
+                        float innerDeg, float outerDeg, const float color[3], float intensity);
+  void removeLight(uint32_t id);
+  void clearLights();
+  // true：分簇（默认，需浮点纹理）；false：逐物体光表（每个网格至多 8 盏，per-draw uniform）
+  void setClusteredLighting(bool b) { clusteredLighting_ = b; }
+  bool clusteredLighting() const { return clusteredLighting_ && clusters_.supported(); }
 
   // ===== 材质 / PBR 绘制 =====
   PbrMatHandle createPbrMaterial(const PbrMaterialDesc &d);
+  void destroyPbrMaterial(PbrMatHandle h); // 句柄立即失效；引用它的网格跳过绘制
+  void setTextureBudget(uint64_t bytes); // 纹理显存预算（超出时淘汰无人引用的纹理）
+  void setTextureArrayPacking(bool b);   // 小纹理打包进 2D 数组（只影响之后扫描到的材质）
+  // 深度预通道：先用位置流写深度，主 PBR 通道 DEPTH_TEST_EQUAL 且不写深度（每像素只着色一次）
+  void setDepthPrepass(bool b) { depthPrepass_ = b; }
+  bool depthPrepass() const { return depthPrepass_; }
+  // 方向光级联阴影（设备不支持深度比较纹理时无效）
+  void setShadows(bool b) { shadows_.setEnabled(b); }
+  bool shadows() const { return shadows_.enabled(); }
+  // 环境光 IBL：equirect HDR，首次加载预计算并落盘缓存，之后同一文件直接读缓存
+  bool loadEnvironment(const std::string &hdrPath) { return ibl_.load(hdrPath); }
+  bool environmentLoaded() const { return ibl_.loaded(); }
+  void setImageBasedLighting(bool b) { ibl_.setEnabled(b); }
+  bool imageBasedLighting() const { return ibl_.enabled(); }
+  // 延迟着色：G-buffer + 全屏光照（走 RenderPass 接口）；开启时局部光一律分簇，深度预通道不生效
+  void setDeferredShading(bool b) { deferredShading_ = b; }
+  bool deferredShading() const { return deferredShading_ && deferred_.supported(); }
+  // 动态分辨率：按 GPU 帧耗时缩放场景渲染尺寸，再放大到窗口（没有 GPU 计时时保持不动）
+  void setDynamicResolution(bool b) { dynRes_.setEnabled(b); }
+  bool dynamicResolution() const { return dynRes_.enabled(); }
+  // 没有包围盒可用：逐物体光表模式下只受方向光（场景网格在 renderScene 里按包围球挑光）
   void drawMeshPBR(const float *modelMtx /*column-major 4x4*/,
                    bgfx::VertexBufferHandle vbh,
                    bgfx::IndexBufferHandle ibh,
@@ -80,11 +134,11 @@ public:
   void setDrawMode(DrawMode m) { drawMode_ = m; }
   DrawMode drawMode() const { return drawMode_; }
   bool loadTextureFromFile(const std::string &path);
-  bool loadMeshFromGltf(const std::string &path); // 若未实现，返回 false
   void buildMeshLayout();                         // 顶点声明（演示路径）
   void renderFrame(Camera &cam, uint32_t &outDraws, uint32_t &outTris, float angle);
-  bool addMeshFromGltfToScene(const std::string &path, Scene &scene); // 占位
-  void renderScene(const Scene &scene, Camera &cam);                  // 占位
+  // 场景里加一个实体；同一文件只上传一次（MeshRegistry 共享缓冲），再加载只多一份引用
+  bool addMeshFromGltfToScene(const std::string &path, Scene &scene);
+  void renderScene(const Scene &scene, Camera &cam);                  // scene.update() 之后调用
 
 private:
   bool showHelp_ = false;
@@ -93,22 +147,32 @@ private:
   void *nativeWindowHandle(SDL_Window *win);
   bool createPipelines();
   void destroyPipelines();
+  void updateShaders(); // 每帧：收集改动的 .bin → 后台读取 → 帧边界换上新 program
   bool createGeometry();
   void destroyGeometry();
   bool createTexture();
   void destroyTexture();
   bgfx::TextureHandle createCheckerTexRGBA8(uint16_t w, uint16_t h, uint16_t cell);
+  // 读 glTF → 建材质 → 几何按内容去重，没有同样的才上传；都登记进 MeshRegistry
+  MeshHandle uploadGltfMesh(const std::string &path, PbrMatHandle &material, std::string &baseColorPath);
 
 private:
   // 基本状态
   uint32_t width_ = 0;
   uint32_t height_ = 0;
   uint8_t viewId_ = 0;
+  uint32_t debugFlags_ = 0;
+  void *nwh_ = nullptr; // attachWindow 取到的原生窗口句柄
+  ke::OrbitViewSnapshot orbit_;
+
+  // 深度预通道：渲染图里排在主通道之前（同一组目标）
+  bool depthPrepass_ = false;
 
   // 旧演示路径：程序/布局/几何/纹理
   bgfx::ProgramHandle programSimple_ = BGFX_INVALID_HANDLE;
   bgfx::ProgramHandle programTex_ = BGFX_INVALID_HANDLE;
   bgfx::ProgramHandle programMesh_ = BGFX_INVALID_HANDLE;
+  ProgramRef refSimple_, refTex_, refMesh_; // 上面三个句柄在 ProgramRegistry 里的引用
 
   bgfx::VertexLayout layout_; // 顶点布局（演示路径）
   bgfx::VertexBufferHandle vbhTri_ = BGFX_INVALID_HANDLE;
@@ -124,6 +188,41 @@ private:
   ForwardPBR pbr_;
   PbrMaterialManager matMgr_;
 
-  // 简易资源缓存（纹理等）
+  // 引擎级资源缓存（纹理缓存 / 网格表由它持有，材质与场景共享）
   ResourceCache resCache_;
+
+  // 后台任务池（纹理解码等）+ 纹理 mip 流送
+  ke::JobSystem jobs_;
+  TextureStreamer texStreamer_;
+  TextureArrayPacker texArrays_;
+
+  // bgfx 回调：着色器/程序二进制磁盘缓存（须比 bgfx 活得久）
+  ShaderCache shaderCache_;
+
+  // 着色器热重载：监视 shaderc 输出目录；programGen_ 落后于 registry 时重新取裸句柄
+  ShaderWatcher shaderWatcher_;
+  uint32_t programGen_ = 0;
+
+  // 分簇光照：每帧按相机分簇，ForwardPBR 的 PBR_CLUSTERED 排列查表
+  ClusteredLighting clusters_;
+  ObjectLights objLights_; // 不用分簇时：裁剪阶段按包围球给每个网格挑光
+  bool clusteredLighting_ = true;
+
+  // 级联阴影：要重画的级各是渲染图的一个通道；staticSerial_ 在静态网格增删 / 移动时递增
+  CascadedShadows shadows_;
+  ImageBasedLighting ibl_;
+  uint32_t staticSerial_ = 0;
+  uint32_t shadowEntities_ = 0; // 上一帧的实体数：变了说明有增删
+
+  // 延迟管线：G-buffer + 光照两个通道
+  DeferredPBR deferred_;
+  bool deferredShading_ = false;
+
+  // 动态分辨率：离屏场景目标是渲染图的临时目标，放大是最后一个通道
+  DynamicResolution dynRes_;
+
+  // 渲染图：场景路径每帧重建；view 从 viewId_ 起按执行顺序分配，临时目标池跨帧复用
+  static constexpr uint16_t kGraphViews = 32;
+  RenderGraph graph_;
+  ClearPass sceneClear_{{0.188f, 0.188f, 0.188f, 1.0f}}; // 0x303030ff
 };
@@ -0,0 +1,250 @@
+#include "CascadedShadows.h"
+#include <bx/math.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+static void normalize3(float v[3]) {
+    const float len = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (len > 0.0f) { v[0] /= len; v[1] /= len; v[2] /= len; }
+}
+static void cross3(float r[3], const float a[3], const float b[3]) {
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+bool CascadedShadows::init() {
+    s_shadowMap     = bgfx::createUniform("s_shadowMap",     bgfx::UniformType::Sampler);
+    u_shadowMtx     = bgfx::createUniform("u_shadowMtx",     bgfx::UniformType::Mat4, kCascades);
+    u_cascadeSplits = bgfx::createUniform("u_cascadeSplits", bgfx::UniformType::Vec4);
+    u_cascadeTexel  = bgfx::createUniform("u_cascadeTexel",  bgfx::UniformType::Vec4);
+    u_shadowParams  = bgfx::createUniform("u_shadowParams",  bgfx::UniformType::Vec4);
+
+    const bgfx::Caps* caps = bgfx::getCaps();
+    m_supported = caps && (caps->supported & BGFX_CAPS_TEXTURE_COMPARE_LEQUAL) != 0
+               && (caps->formats[bgfx::TextureFormat::D16] & BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER) != 0;
+    if (!m_supported) {
+        spdlog::warn("[CSM] depth compare textures not supported, shadows disabled");
+        return false;
+    }
+
+    // 2x2 图集：设备允许 4096 就每级 2048，否则每级 1024
+    m_cascadeSize = caps->limits.maxTextureSize >= 4096 ? 2048 : 1024;
+    const uint16_t atlas = uint16_t(m_cascadeSize * 2);
+    m_atlas = bgfx::createTexture2D(atlas, atlas, false, 1, bgfx::TextureFormat::D16,
+                                    BGFX_TEXTURE_RT | BGFX_SAMPLER_COMPARE_LEQUAL | BGFX_SAMPLER_UVW_CLAMP);
+    if (!bgfx::isValid(m_atlas)) {
+        spdlog::error("[CSM] shadow atlas {}x{} creation failed", atlas, atlas);
+        m_supported = false;
+        return false;
+    }
+    m_enabled = true;
+    return true;
+}
+
+void CascadedShadows::shutdown() {
+    if (bgfx::isValid(m_atlas)) bgfx::destroy(m_atlas);
+    m_atlas = BGFX_INVALID_HANDLE;
+    for (bgfx::UniformHandle* u : { &s_shadowMap, &u_shadowMtx, &u_cascadeSplits, &u_cascadeTexel, &u_shadowParams }) {
+        if (bgfx::isValid(*u)) bgfx::destroy(*u);
+        *u = BGFX_INVALID_HANDLE;
+    }
+    for (auto& c : m_cascades) c.valid = false;
+    m_supported = m_enabled = false;
+    m_stats = {};
+}
+
+void CascadedShadows::fitCascade(uint32_t c, const float sphere[4], bool padded, float zMin, float zMax) {
+    Cascade& cs = m_cascades[c];
+    const float r = padded ? sphere[3] * kCachePadding : sphere[3];
+    // 中心按 texel 对齐：相机平移时阴影边缘不闪
+    const float texel = 2.0f * r / m_cascadeSize;
+    const float cx = std::floor(sphere[0] / texel) * texel;
+    const float cy = std::floor(sphere[1] / texel) * texel;
+
+    float* b = cs.bounds;
+    b[0] = cx - r; b[1] = cx + r;
+    b[2] = cy - r; b[3] = cy + r;
+    b[4] = zMin - 0.5f; b[5] = zMax + 0.5f;
+    bx::mtxOrtho(cs.proj, b[0], b[1], b[2], b[3], b[4], b[5], 0.0f, bgfx::getCaps()->homogeneousDepth);
+    cs.texelWorld = texel;
+    cs.center[0] = sphere[0];
+    cs.center[1] = sphere[1];
+    cs.radius = r;
+}
+
+void CascadedShadows::update(const Frame& f, const std::vector<Caster>& casters) {
+    for (uint32_t c = 0; c < kCascades; ++c) {
+        m_render[c] = false;
+        m_lists[c].clear();
+        m_stats.casters[c] = 0;
+        m_stats.cached[c] = false;
+    }
+    if (!m_enabled) return;
+
+    // 光空间基：原点在世界原点，只有旋转；平移全放进各级的正交框
+    float lz[3] = { f.lightDir[0], f.lightDir[1], f.lightDir[2] };
+    normalize3(lz);
+    const float up[3] = { 0.0f, std::fabs(lz[1]) > 0.99f ? 0.0f : 1.0f, std::fabs(lz[1]) > 0.99f ? 1.0f : 0.0f };
+    float lx[3], ly[3];
+    cross3(lx, up, lz);
+    normalize3(lx);
+    cross3(ly, lz, lx);
+    float lightView[16] = {
+        lx[0], ly[0], lz[0], 0.0f,
+        lx[1], ly[1], lz[1], 0.0f,
+        lx[2], ly[2], lz[2], 0.0f,
+        0.0f,  0.0f,  0.0f,  1.0f,
+    };
+    auto toLight = [&](const float p[3], float out[3]) {
+        out[0] = p[0] * lx[0] + p[1] * lx[1] + p[2] * lx[2];
+        out[1] = p[0] * ly[0] + p[1] * ly[1] + p[2] * ly[2];
+        out[2] = p[0] * lz[0] + p[1] * lz[1] + p[2] * lz[2];
+    };
+
+    // 光方向 / 静态集合变了：所有缓存作废
+    const float dotL = lz[0] * m_lastLightDir[0] + lz[1] * m_lastLightDir[1] + lz[2] * m_lastLightDir[2];
+    if (dotL < 0.99999f || f.staticSerial != m_lastStaticSerial) {
+        for (auto& c : m_cascades) c.valid = false;
+        std::copy(lz, lz + 3, m_lastLightDir);
+        m_lastStaticSerial = f.staticSerial;
+    }
+
+    // 投射体转到光空间；顺便得到场景在光方向上的深度范围（正交近/远平面）
+    std::vector<float> ls(casters.size() * 4);
+    float zMin = 1e30f, zMax = -1e30f;
+    for (size_t i = 0; i < casters.size(); ++i) {
+        toLight(casters[i].center, &ls[i * 4]);
+        ls[i * 4 + 3] = casters[i].radius;
+        zMin = std::min(zMin, ls[i * 4 + 2] - casters[i].radius);
+        zMax = std::max(zMax, ls[i * 4 + 2] + casters[i].radius);
+    }
+    if (casters.empty()) { zMin = -1.0f; zMax = 1.0f; }
+
+    // 切分：对数与均匀按 kSplitLambda 混合
+    const float n = f.zNear, fa = std::max(f.shadowFar, n * 2.0f);
+    for (uint32_t i = 1; i <= kCascades; ++i) {
+        const float t = float(i) / kCascades;
+        m_splits[i - 1] = kSplitLambda * n * std::pow(fa / n, t) + (1.0f - kSplitLambda) * (n + (fa - n) * t);
+    }
+
+    // 相机基（bx view：列 0/1/2 是 right/up/forward）
+    const float* V = f.view;
+    const float right[3] = { V[0], V[4], V[8] }, camUp[3] = { V[1], V[5], V[9] }, fwd[3] = { V[2], V[6], V[10] };
+    float eye[3];
+    for (int k = 0; k < 3; ++k) eye[k] = -(V[12] * right[k] + V[13] * camUp[k] + V[14] * fwd[k]);
+    const float tanY = std::tan(f.fovY * 0.5f * 3.14159265f / 180.0f), tanX = tanY * f.aspect;
+
+    const bool homogeneous = bgfx::getCaps()->homogeneousDepth;
+    const bool bottomLeft  = bgfx::getCaps()->originBottomLeft;
+
+    for (uint32_t c = 0; c < kCascades; ++c) {
+        Cascade& cs = m_cascades[c];
+        std::copy(lightView, lightView + 16, cs.lightView);
+
+        // 该段视锥的包围球（世界 → 光空间），半径取整到 1/16 让 texel 尺寸逐帧不变
+        const float dn = c == 0 ? n : m_splits[c - 1], df = m_splits[c];
+        float ctr[3] = { 0, 0, 0 }, corners[8][3];
+        for (int k = 0; k < 8; ++k) {
+            const float d = (k & 4) ? df : dn;
+            const float sx = (k & 1) ? tanX : -tanX, sy = (k & 2) ? tanY : -tanY;
+            for (int a = 0; a < 3; ++a) {
+                corners[k][a] = eye[a] + fwd[a] * d + right[a] * sx * d + camUp[a] * sy * d;
+                ctr[a] += corners[k][a] * 0.125f;
+            }
+        }
+        float r = 0.0f;
+        for (auto& p : corners)
+            r = std::max(r, std::sqrt((p[0] - ctr[0]) * (p[0] - ctr[0]) + (p[1] - ctr[1]) * (p[1] - ctr[1]) +
+                                      (p[2] - ctr[2]) * (p[2] - ctr[2])));
+        r = std::ceil(r * 16.0f) / 16.0f;
+        float sphere[4];
+        toLight(ctr, sphere);
+        sphere[3] = r;
+
+        const bool cacheable = c >= kFirstCachedCascade;
+        bool keep = false;
+        if (cacheable && cs.valid) {
+            // 当前段仍落在缓存的（放大过的）投影框里
+            keep = std::fabs(sphere[0] - cs.center[0]) + r <= cs.radius &&
+                   std::fabs(sphere[1] - cs.center[1]) + r <= cs.radius;
+        }
+        if (keep) {
+            // 只需确认框里没有动态投射体
+            bool dynamicInside = false;
+            const float* b = cs.bounds;
+            for (size_t i = 0; i < casters.size() && !dynamicInside; ++i) {
+                if (!casters[i].dynamic) continue;
+                const float* p = &ls[i * 4];
+                dynamicInside = p[0] + p[3] >= b[0] && p[0] - p[3] <= b[1] && p[1] + p[3] >= b[2] && p[1] - p[3] <= b[3];
+            }
+            if (!dynamicInside) {
+                m_stats.cached[c] = true;
+                continue;
+            }
+            keep = false; // 有动态物体：按当前深度范围重拟合
+        }
+        if (!keep) fitCascade(c, sphere, cacheable, zMin, zMax);
+
+        // 光空间矩形裁剪 + 远级小物体剔除
+        const float* b = cs.bounds;
+        const float minDiameter = c > 0 ? kMinCasterTexels * cs.texelWorld : 0.0f;
+        bool hasDynamic = false;
+        for (size_t i = 0; i < casters.size(); ++i) {
+            const float* p = &ls[i * 4];
+            if (p[0] + p[3] < b[0] || p[0] - p[3] > b[1] || p[1] + p[3] < b[2] || p[1] - p[3] > b[3]) continue;
+            if (2.0f * p[3] < minDiameter) continue;
+            m_lists[c].push_back(uint32_t(i));
+            hasDynamic = hasDynamic || casters[i].dynamic;
+        }
+        m_render[c] = true;
+        m_stats.casters[c] = uint32_t(m_lists[c].size());
+        if (cacheable) {
+            // 画进了动态物体的内容下一帧不能沿用
+            cs.valid = !hasDynamic;
+            ++m_stats.redraws;
+        }
+    }
+
+    // 着色器用矩阵：世界 → 图集 uv + 深度
+    const float sy = bottomLeft ? 0.5f : -0.5f;
+    const float sz = homogeneous ? 0.5f : 1.0f, tz = homogeneous ? 0.5f : 0.0f;
+    for (uint32_t c = 0; c < kCascades; ++c) {
+        const Cascade& cs = m_cascades[c];
+        const uint32_t qx = c & 1, qy = c >> 1;
+        // view rect 以左上为原点；GL 纹理 v 轴朝上，行要倒过来数
+        const float ox = qx * 0.5f;
+        const float oy = bottomLeft ? 1.0f - (qy + 1) * 0.5f : qy * 0.5f;
+        const float crop[16] = {
+            0.25f, 0.0f,      0.0f, 0.0f,
+            0.0f,  sy * 0.5f, 0.0f, 0.0f,
+            0.0f,  0.0f,      sz,   0.0f,
+            0.25f + ox, 0.25f + oy, tz, 1.0f,
+        };
+        float vp[16];
+        bx::mtxMul(vp, cs.lightView, cs.proj);
+        bx::mtxMul(m_shadowMtx[c], vp, crop);
+        m_texel[c] = cs.texelWorld;
+    }
+}
+
+void CascadedShadows::setupView(uint32_t cascade, bgfx::ViewId view) const {
+    const Cascade& cs = m_cascades[cascade];
+    const uint32_t qx = cascade & 1, qy = cascade >> 1;
+    bgfx::setViewRect(view, uint16_t(qx * m_cascadeSize), uint16_t(qy * m_cascadeSize), m_cascadeSize, m_cascadeSize);
+    bgfx::setViewTransform(view, cs.lightView, cs.proj);
+    bgfx::setViewClear(view, BGFX_CLEAR_DEPTH, 0, 1.0f, 0);
+}
+
+void CascadedShadows::bind(uint8_t stage) const {
+    // x = 深度偏移  y = 法线偏移（texel 倍数）  z = 1 / 图集尺寸  w = 开关
+    const float params[4] = { 0.0015f, 1.5f, m_cascadeSize ? 0.5f / m_cascadeSize : 0.0f, m_enabled ? 1.0f : 0.0f };
+    if (m_enabled) {
+        bgfx::setTexture(stage, s_shadowMap, m_atlas);
+        bgfx::setUniform(u_shadowMtx, m_shadowMtx, kCascades);
+        bgfx::setUniform(u_cascadeSplits, m_splits);
+        bgfx::setUniform(u_cascadeTexel, m_texel);
+    }
+    if (bgfx::isValid(u_shadowParams)) bgfx::setUniform(u_shadowParams, params);
+}
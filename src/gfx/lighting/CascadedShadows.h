@@ -0,0 +1,103 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <vector>
+
+// 名称速记：CascadedShadows = 方向光级联阴影（CSM），4 级共用一张 2x2 深度图集
+// - 视锥按对数/均匀混合切成 4 段，每段取包围球做正交投影（旋转不变）+ 按 texel 对齐，避免抖动
+// - 每级是渲染图里的一个通道（写同一张导入的图集），各自按光空间矩形裁剪投射体；
+//   远级跳过投影后不足几个 texel 的小物体
+// - 远级（kFirstCachedCascade 起）只要其中没有动态投射体就缓存：投影框放大留余量，
+//   光方向 / 静态集合变化或相机走出余量时才重画；否则整级不提交
+// - 投射体用深度预通道的位置流 + 空片元着色器（ForwardPBR::drawDepth）
+class CascadedShadows {
+public:
+    static constexpr uint32_t kCascades = 4;
+    static constexpr uint32_t kFirstCachedCascade = 2;
+    static constexpr float    kCachePadding = 1.25f;  // 缓存级的投影框放大倍数
+    static constexpr float    kMinCasterTexels = 2.0f; // 远级小于这么多 texel 的投射体不画
+    static constexpr float    kSplitLambda = 0.75f;   // 0 = 均匀切分，1 = 对数切分
+
+    struct Caster {
+        float center[3];
+        float radius;
+        bool  dynamic;
+    };
+
+    struct Frame {
+        const float* view;   // 相机 view（bx 约定）
+        float fovY;          // 度
+        float aspect;
+        float zNear;
+        float shadowFar;     // 阴影覆盖到的视空间距离
+        float lightDir[3];   // 光线传播方向（从光源射向场景）
+        uint32_t staticSerial; // 静态投射体集合的版本号（增删/移动静态网格时递增）
+    };
+
+    struct Stats {
+        uint32_t casters[kCascades] = {}; // 每级本帧提交的投射体（缓存级为 0）
+        bool     cached[kCascades] = {};  // 本帧直接沿用缓存
+        uint32_t redraws = 0;             // 累计重画的缓存级次数
+    };
+
+    bool init();
+    void shutdown();
+
+    void setEnabled(bool b) { m_enabled = b && m_supported; }
+    bool enabled() const { return m_enabled; }
+    bool supported() const { return m_supported; }
+
+    // 图集（深度比较纹理）：跨帧保留缓存级，作为导入资源交给渲染图
+    bgfx::TextureHandle atlas() const { return m_atlas; }
+
+    // 每帧（主线程，绘制前）：拟合各级投影、裁剪投射体、决定哪些级要重画
+    void update(const Frame& f, const std::vector<Caster>& casters);
+    // 要重画的级在自己的通道里调用：图集上的 rect + 光空间矩阵 + 清深度（帧缓冲由渲染图设置）
+    void setupView(uint32_t cascade, bgfx::ViewId view) const;
+
+    // 本帧要重画的级，及其投射体（下标指向 update 传入的数组）
+    bool renders(uint32_t cascade) const { return m_enabled && m_render[cascade]; }
+    const std::vector<uint32_t>& casters(uint32_t cascade) const { return m_lists[cascade]; }
+
+    // 绑定图集 + 阴影矩阵/参数；每个 PBR draw 调一次（关闭时只上传“关”标志）
+    void bind(uint8_t stage) const;
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Cascade {
+        float lightView[16];
+        float proj[16];
+        float bounds[6];      // 光空间正交框：l r b t n f
+        float texelWorld = 0; // 一个 texel 对应的世界尺寸
+        // 缓存
+        bool  valid = false;
+        float center[2] = { 0, 0 };
+        float radius = 0;
+    };
+
+    void fitCascade(uint32_t c, const float sphere[4], bool padded, float zMin, float zMax);
+
+    bool m_supported = false;
+    bool m_enabled = false;
+    uint16_t m_cascadeSize = 0;
+
+    Cascade m_cascades[kCascades];
+    bool    m_render[kCascades] = {};
+    std::vector<uint32_t> m_lists[kCascades];
+    float    m_lastLightDir[3] = { 0, 0, 0 };
+    uint32_t m_lastStaticSerial = UINT32_MAX;
+
+    float m_shadowMtx[kCascades][16];
+    float m_splits[4] = { 0, 0, 0, 0 };
+    float m_texel[4] = { 0, 0, 0, 0 };
+
+    bgfx::TextureHandle     m_atlas = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_shadowMap      = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle u_shadowMtx      = BGFX_INVALID_HANDLE; // mat4[4]
+    bgfx::UniformHandle u_cascadeSplits  = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle u_cascadeTexel   = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle u_shadowParams   = BGFX_INVALID_HANDLE;
+
+    Stats m_stats;
+};
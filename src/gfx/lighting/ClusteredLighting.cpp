@@ -0,0 +1,312 @@
+#include "ClusteredLighting.h"
+#include "core/JobSystem.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KE_CLUSTER_SSE 1
+#else
+#define KE_CLUSTER_SSE 0
+#endif
+
+static_assert(ClusteredLighting::kTilesPerSlice % 4 == 0, "slice 内簇数须是 4 的倍数（SIMD 一次测 4 个）");
+static_assert(ClusteredLighting::kMaxLights <= 0xffff, "簇内光索引用 uint16 存");
+
+static bool formatOk(const bgfx::Caps* caps, bgfx::TextureFormat::Enum f) {
+    return (caps->formats[f] & BGFX_CAPS_FORMAT_TEXTURE_2D) != 0;
+}
+
+bool ClusteredLighting::init(ke::JobSystem& jobs) {
+    m_jobs = &jobs;
+    const bgfx::Caps* caps = bgfx::getCaps();
+    m_supported = caps && formatOk(caps, bgfx::TextureFormat::RGBA32F)
+               && formatOk(caps, bgfx::TextureFormat::RG32F) && formatOk(caps, bgfx::TextureFormat::R32F);
+    if (!m_supported) {
+        spdlog::warn("[Clustered] float textures not supported, local lights disabled");
+        return false;
+    }
+
+    const uint64_t flags = BGFX_SAMPLER_POINT | BGFX_SAMPLER_UVW_CLAMP;
+    m_texLights = bgfx::createTexture2D(3, kMaxLights, false, 1, bgfx::TextureFormat::RGBA32F, flags);
+    m_texGrid   = bgfx::createTexture2D(kTilesPerSlice, kSlices, false, 1, bgfx::TextureFormat::RG32F, flags);
+    m_texIndex  = bgfx::createTexture2D(kIndexTexWidth, kIndexTexHeight, false, 1, bgfx::TextureFormat::R32F, flags);
+    s_lightData   = bgfx::createUniform("s_lightData",   bgfx::UniformType::Sampler);
+    s_clusterGrid = bgfx::createUniform("s_clusterGrid", bgfx::UniformType::Sampler);
+    s_lightIndex  = bgfx::createUniform("s_lightIndex",  bgfx::UniformType::Sampler);
+    u_cluster     = bgfx::createUniform("u_cluster",     bgfx::UniformType::Vec4, 3);
+
+    m_bounds.resize(kSlices);
+    m_clusterLights.resize(size_t(kClusters) * kMaxLightsPerCluster);
+    m_clusterCount.resize(kClusters);
+    m_lightData.resize(size_t(kMaxLights) * 12);
+    m_gridData.resize(size_t(kClusters) * 2);
+    m_indexData.resize(size_t(kIndexTexWidth) * kIndexTexHeight);
+    std::memset(m_boundsKey, 0, sizeof(m_boundsKey));
+    return true;
+}
+
+void ClusteredLighting::shutdown() {
+    for (bgfx::TextureHandle* t : { &m_texLights, &m_texGrid, &m_texIndex }) {
+        if (bgfx::isValid(*t)) bgfx::destroy(*t);
+        *t = BGFX_INVALID_HANDLE;
+    }
+    for (bgfx::UniformHandle* u : { &s_lightData, &s_clusterGrid, &s_lightIndex, &u_cluster }) {
+        if (bgfx::isValid(*u)) bgfx::destroy(*u);
+        *u = BGFX_INVALID_HANDLE;
+    }
+    m_supported = false;
+    m_stats = {};
+}
+
+// ===== 光源管理 =====
+uint32_t ClusteredLighting::addPointLight(const glm::vec3& pos, float radius, const glm::vec3& color, float intensity) {
+    Light l;
+    l.pos = pos;
+    l.radius = radius;
+    l.color = color;
+    l.intensity = intensity;
+    uint32_t id;
+    if (!m_free.empty()) { id = m_free.back(); m_free.pop_back(); m_lights[id] = l; m_alive[id] = 1; }
+    else { id = (uint32_t)m_lights.size(); m_lights.push_back(l); m_alive.push_back(1); }
+    return id;
+}
+
+uint32_t ClusteredLighting::addSpotLight(const glm::vec3& pos, const glm::vec3& dir, float radius,
+                                         float innerDeg, float outerDeg, const glm::vec3& color, float intensity) {
+    const uint32_t id = addPointLight(pos, radius, color, intensity);
+    Light& l = m_lights[id];
+    // 锥测试在外角 >= 90° 时失效：夹到 89°
+    outerDeg = std::clamp(outerDeg, 1.0f, 89.0f);
+    innerDeg = std::clamp(innerDeg, 0.0f, outerDeg);
+    const float len = std::sqrt(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+    l.dir = len > 0.0f ? dir / len : glm::vec3(0.0f, -1.0f, 0.0f);
+    l.cosInner = std::cos(innerDeg * 0.01745329252f);
+    l.cosOuter = std::cos(outerDeg * 0.01745329252f);
+    l.spot = true;
+    return id;
+}
+
+void ClusteredLighting::removeLight(uint32_t id) {
+    if (id >= m_lights.size() || !m_alive[id]) return;
+    m_alive[id] = 0;
+    m_free.push_back(id);
+}
+
+void ClusteredLighting::clearLights() {
+    m_lights.clear();
+    m_alive.clear();
+    m_free.clear();
+}
+
+ClusteredLighting::Light* ClusteredLighting::light(uint32_t id) {
+    return id < m_lights.size() && m_alive[id] ? &m_lights[id] : nullptr;
+}
+
+void ClusteredLighting::packLight(const Light& l, float out[12]) {
+    // 点光 scale=0, offset=1：着色器里锥衰减恒为 1
+    const float scale  = l.spot ? 1.0f / std::max(l.cosInner - l.cosOuter, 1e-4f) : 0.0f;
+    const float offset = l.spot ? -l.cosOuter * scale : 1.0f;
+    const float t[12] = { l.pos.x, l.pos.y, l.pos.z, l.radius,
+                          l.color.x * l.intensity, l.color.y * l.intensity, l.color.z * l.intensity, scale,
+                          l.dir.x, l.dir.y, l.dir.z, offset };
+    std::copy(t, t + 12, out);
+}
+
+// ===== 簇几何 =====
+void ClusteredLighting::rebuildBounds(const float proj[16], float zNear, float zFar) {
+    const float key[4] = { proj[0], proj[5], zNear, zFar };
+    if (std::memcmp(key, m_boundsKey, sizeof(key)) == 0) return;
+    std::memcpy(m_boundsKey, key, sizeof(key));
+
+    // 对称透视（bx::mtxProj）：视空间 x = ndcX * z / proj[0]，y = ndcY * z / proj[5]
+    const float ratio = zFar / zNear;
+    for (uint32_t z = 0; z < kSlices; ++z) {
+        const float zn = zNear * std::pow(ratio, float(z) / kSlices);
+        const float zf = zNear * std::pow(ratio, float(z + 1) / kSlices);
+        SliceBounds& b = m_bounds[z];
+        for (uint32_t ty = 0; ty < kTilesY; ++ty) {
+            // 第 0 行在屏幕顶部（NDC y = +1）
+            const float ny0 = 1.0f - 2.0f * float(ty) / kTilesY;
+            const float ny1 = 1.0f - 2.0f * float(ty + 1) / kTilesY;
+            for (uint32_t tx = 0; tx < kTilesX; ++tx) {
+                const float nx0 = -1.0f + 2.0f * float(tx) / kTilesX;
+                const float nx1 = -1.0f + 2.0f * float(tx + 1) / kTilesX;
+                const float xs[4] = { nx0 * zn / proj[0], nx1 * zn / proj[0], nx0 * zf / proj[0], nx1 * zf / proj[0] };
+                const float ys[4] = { ny0 * zn / proj[5], ny1 * zn / proj[5], ny0 * zf / proj[5], ny1 * zf / proj[5] };
+                const uint32_t i = ty * kTilesX + tx;
+                b.minX[i] = *std::min_element(xs, xs + 4);
+                b.maxX[i] = *std::max_element(xs, xs + 4);
+                b.minY[i] = *std::min_element(ys, ys + 4);
+                b.maxY[i] = *std::max_element(ys, ys + 4);
+                b.minZ[i] = zn;
+                b.maxZ[i] = zf;
+            }
+        }
+    }
+}
+
+// ===== 分簇 =====
+void ClusteredLighting::binSlice(uint32_t slice) {
+    const SliceBounds& b = m_bounds[slice];
+    uint16_t* counts = m_clusterCount.data() + size_t(slice) * kTilesPerSlice;
+    uint16_t* lists  = m_clusterLights.data() + size_t(slice) * kTilesPerSlice * kMaxLightsPerCluster;
+    std::fill(counts, counts + kTilesPerSlice, uint16_t(0));
+    m_sliceOverflow[slice] = 0;
+
+    auto accept = [&](uint32_t i, uint32_t li, const ViewLight& L) {
+        if (L.spot) {
+            // 锥 vs 簇包围球（Wronski）
+            const float cx = 0.5f * (b.minX[i] + b.maxX[i]), hx = 0.5f * (b.maxX[i] - b.minX[i]);
+            const float cy = 0.5f * (b.minY[i] + b.maxY[i]), hy = 0.5f * (b.maxY[i] - b.minY[i]);
+            const float cz = 0.5f * (b.minZ[i] + b.maxZ[i]), hz = 0.5f * (b.maxZ[i] - b.minZ[i]);
+            const float rs = std::sqrt(hx * hx + hy * hy + hz * hz);
+            const float vx = cx - L.x, vy = cy - L.y, vz = cz - L.z;
+            const float vlenSq = vx * vx + vy * vy + vz * vz;
+            const float v1len = vx * L.dx + vy * L.dy + vz * L.dz;
+            const float closest = L.cosOuter * std::sqrt(std::max(vlenSq - v1len * v1len, 0.0f)) - v1len * L.sinOuter;
+            if (closest > rs || v1len > rs + L.r || v1len < -rs) return;
+        }
+        if (counts[i] >= kMaxLightsPerCluster) { m_sliceOverflow[slice] = 1; return; }
+        lists[i * kMaxLightsPerCluster + counts[i]++] = (uint16_t)li;
+    };
+
+    for (uint32_t li : m_sliceLights[slice]) {
+        const ViewLight& L = m_viewLights[li];
+#if KE_CLUSTER_SSE
+        // 球 vs AABB，一次 4 个簇：d = max(min - c, 0) + max(c - max, 0)，|d|² <= r²
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 cx = _mm_set1_ps(L.x), cy = _mm_set1_ps(L.y), cz = _mm_set1_ps(L.z);
+        const __m128 r2 = _mm_set1_ps(L.r * L.r);
+        for (uint32_t i = 0; i < kTilesPerSlice; i += 4) {
+            const __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(b.minX + i), cx), zero),
+                                         _mm_max_ps(_mm_sub_ps(cx, _mm_load_ps(b.maxX + i)), zero));
+            const __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(b.minY + i), cy), zero),
+                                         _mm_max_ps(_mm_sub_ps(cy, _mm_load_ps(b.maxY + i)), zero));
+            const __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(b.minZ + i), cz), zero),
+                                         _mm_max_ps(_mm_sub_ps(cz, _mm_load_ps(b.maxZ + i)), zero));
+            const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            const int mask = _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+            if (!mask) continue;
+            for (uint32_t k = 0; k < 4; ++k)
+                if (mask & (1 << k)) accept(i + k, li, L);
+        }
+#else
+        const float r2 = L.r * L.r;
+        for (uint32_t i = 0; i < kTilesPerSlice; ++i) {
+            const float dx = std::max(b.minX[i] - L.x, 0.0f) + std::max(L.x - b.maxX[i], 0.0f);
+            const float dy = std::max(b.minY[i] - L.y, 0.0f) + std::max(L.y - b.maxY[i], 0.0f);
+            const float dz = std::max(b.minZ[i] - L.z, 0.0f) + std::max(L.z - b.maxZ[i], 0.0f);
+            if (dx * dx + dy * dy + dz * dz <= r2) accept(i, li, L);
+        }
+#endif
+    }
+}
+
+void ClusteredLighting::update(const float view[16], const float proj[16], uint16_t width, uint16_t height,
+                               float zNear, float zFar, const Light* extra) {
+    if (!m_supported) return;
+    const auto t0 = std::chrono::steady_clock::now();
+    rebuildBounds(proj, zNear, zFar);
+
+    // 1) 收集光源：转到视空间，丢掉完全在 [near, far] 之外的；同时填光源数据（世界空间）
+    m_viewLights.clear();
+    for (auto& s : m_sliceLights) s.clear();
+    const float sliceScale = kSlices / std::log(zFar / zNear);
+    auto sliceOf = [&](float z) {
+        const float s = std::floor(std::log(std::max(z, zNear) / zNear) * sliceScale);
+        return (uint32_t)std::clamp(s, 0.0f, float(kSlices - 1));
+    };
+
+    uint32_t total = 0;
+    bool overflow = false;
+    auto addLight = [&](const Light& l) {
+        ++total;
+        if (l.radius <= 0.0f || l.intensity <= 0.0f) return;
+        const float vx = l.pos.x * view[0] + l.pos.y * view[4] + l.pos.z * view[8]  + view[12];
+        const float vy = l.pos.x * view[1] + l.pos.y * view[5] + l.pos.z * view[9]  + view[13];
+        const float vz = l.pos.x * view[2] + l.pos.y * view[6] + l.pos.z * view[10] + view[14];
+        if (vz + l.radius < zNear || vz - l.radius > zFar) return;
+        if (m_viewLights.size() >= kMaxLights) { overflow = true; return; }
+
+        ViewLight v{};
+        v.x = vx; v.y = vy; v.z = vz; v.r = l.radius;
+        v.spot = l.spot;
+        if (l.spot) {
+            v.dx = l.dir.x * view[0] + l.dir.y * view[4] + l.dir.z * view[8];
+            v.dy = l.dir.x * view[1] + l.dir.y * view[5] + l.dir.z * view[9];
+            v.dz = l.dir.x * view[2] + l.dir.y * view[6] + l.dir.z * view[10];
+            v.cosOuter = l.cosOuter;
+            v.sinOuter = std::sqrt(std::max(1.0f - l.cosOuter * l.cosOuter, 0.0f));
+        }
+        const uint32_t li = (uint32_t)m_viewLights.size();
+        m_viewLights.push_back(v);
+        for (uint32_t z = sliceOf(vz - l.radius), z1 = sliceOf(vz + l.radius); z <= z1; ++z)
+            m_sliceLights[z].push_back(li);
+
+        packLight(l, m_lightData.data() + size_t(li) * 12);
+    };
+    for (size_t i = 0; i < m_lights.size(); ++i)
+        if (m_alive[i]) addLight(m_lights[i]);
+    if (extra) addLight(*extra);
+
+    // 2) 按 slice 并行分簇：每个 slice 的簇只由一个任务写，不用加锁
+    if (!m_viewLights.empty())
+        m_jobs->parallelFor(kSlices, 1, [this](uint32_t begin, uint32_t end) {
+            for (uint32_t z = begin; z < end; ++z) binSlice(z);
+        });
+
+    // 3) 压紧：簇表 (起点, 数量) + 全局索引表
+    const uint32_t capacity = uint32_t(kIndexTexWidth) * kIndexTexHeight;
+    uint32_t cursor = 0, used = 0, maxPer = 0;
+    for (uint32_t c = 0; c < kClusters; ++c) {
+        uint32_t n = m_viewLights.empty() ? 0 : m_clusterCount[c];
+        if (cursor + n > capacity) { n = capacity - cursor; overflow = true; }
+        const uint16_t* src = m_clusterLights.data() + size_t(c) * kMaxLightsPerCluster;
+        for (uint32_t k = 0; k < n; ++k) m_indexData[cursor + k] = float(src[k]);
+        m_gridData[c * 2 + 0] = float(cursor);
+        m_gridData[c * 2 + 1] = float(n);
+        cursor += n;
+        used += n > 0;
+        maxPer = std::max(maxPer, n);
+    }
+    for (uint32_t z = 0; z < kSlices && !m_viewLights.empty(); ++z) overflow = overflow || m_sliceOverflow[z];
+
+    // 4) 上传（只传用到的行）
+    const uint32_t visible = (uint32_t)m_viewLights.size();
+    if (visible > 0) {
+        bgfx::updateTexture2D(m_texLights, 0, 0, 0, 0, 3, (uint16_t)visible,
+                              bgfx::copy(m_lightData.data(), visible * 12 * sizeof(float)));
+        bgfx::updateTexture2D(m_texGrid, 0, 0, 0, 0, kTilesPerSlice, kSlices,
+                              bgfx::copy(m_gridData.data(), (uint32_t)(m_gridData.size() * sizeof(float))));
+        const uint16_t rows = (uint16_t)std::max<uint32_t>(1, (cursor + kIndexTexWidth - 1) / kIndexTexWidth);
+        bgfx::updateTexture2D(m_texIndex, 0, 0, 0, 0, kIndexTexWidth, rows,
+                              bgfx::copy(m_indexData.data(), uint32_t(rows) * kIndexTexWidth * sizeof(float)));
+    }
+
+    const float params[12] = {
+        float(kTilesX), float(kTilesY), float(kSlices), float(kIndexTexWidth),
+        float(kTilesX) / std::max<float>(width, 1.0f), float(kTilesY) / std::max<float>(height, 1.0f),
+        float(height), bgfx::getCaps()->originBottomLeft ? 1.0f : 0.0f,
+        zNear, sliceScale, 0.0f, 0.0f,
+    };
+    std::copy(params, params + 12, m_params);
+
+    m_stats.lights = total;
+    m_stats.visible = visible;
+    m_stats.clustersUsed = used;
+    m_stats.indices = cursor;
+    m_stats.maxPerCluster = maxPer;
+    m_stats.overflow = overflow;
+    m_stats.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void ClusteredLighting::bind(uint8_t firstStage) const {
+    bgfx::setTexture(firstStage + 0, s_lightData,   m_texLights);
+    bgfx::setTexture(firstStage + 1, s_clusterGrid, m_texGrid);
+    bgfx::setTexture(firstStage + 2, s_lightIndex,  m_texIndex);
+    bgfx::setUniform(u_cluster, m_params, 3);
+}
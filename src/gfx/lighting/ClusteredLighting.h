@@ -0,0 +1,134 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <glm/vec3.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ke { class JobSystem; }
+
+// 名称速记：ClusteredLighting = 分簇前向光照（点光/聚光），CPU 侧分簇
+// - 视锥切成 kTilesX × kTilesY × kSlices 个簇（froxel）；深度按指数切片
+// - 每帧：光源转到视空间 → 按 slice 并行（JobSystem）→ 每个 slice 内 4 个簇一组做 SIMD 球/AABB 测试，
+//   聚光再做一次锥/簇包围球测试 → 压紧成“每簇 (起点, 数量) + 全局索引表”
+// - 上传为三张点采样纹理：光源数据 RGBA32F（3 texel/光）、簇表 RG32F、索引表 R32F；
+//   片元着色器（PBR_CLUSTERED 排列）只遍历自己簇里的光
+// - 设备不支持浮点纹理时整体关闭（active() 为 false），只剩方向光
+class ClusteredLighting {
+public:
+    static constexpr uint16_t kTilesX = 16;
+    static constexpr uint16_t kTilesY = 9;
+    static constexpr uint16_t kSlices = 24;
+    static constexpr uint32_t kTilesPerSlice = uint32_t(kTilesX) * kTilesY;
+    static constexpr uint32_t kClusters = kTilesPerSlice * kSlices;
+    static constexpr uint32_t kMaxLights = 1024;           // 每帧可见光上限
+    static constexpr uint32_t kMaxLightsPerCluster = 64;
+    static constexpr uint16_t kIndexTexWidth  = 1024;
+    static constexpr uint16_t kIndexTexHeight = 64;        // 索引表容量 = 宽 × 高
+
+    struct Light {
+        glm::vec3 pos{0.0f};
+        float     radius = 1.0f;
+        glm::vec3 color{1.0f};
+        float     intensity = 1.0f;
+        // 聚光：spot=true 时生效；角度存 cos
+        glm::vec3 dir{0.0f, -1.0f, 0.0f};
+        float     cosInner = 1.0f;
+        float     cosOuter = 0.0f;
+        bool      spot = false;
+    };
+
+    struct Stats {
+        uint32_t lights = 0;        // 场景里的光
+        uint32_t visible = 0;       // 与视锥深度范围相交、进了本帧列表的光
+        uint32_t clustersUsed = 0;  // 至少有一盏光的簇
+        uint32_t indices = 0;       // 索引表用量
+        uint32_t maxPerCluster = 0; // 单簇最多光数
+        bool     overflow = false;  // 有簇/索引表被截断
+        double   cpuMs = 0.0;       // 分簇 + 打包耗时
+    };
+
+    bool init(ke::JobSystem& jobs);
+    void shutdown();
+
+    // 光源管理：返回稳定 id（删除后会被复用）
+    uint32_t addPointLight(const glm::vec3& pos, float radius, const glm::vec3& color, float intensity);
+    uint32_t addSpotLight(const glm::vec3& pos, const glm::vec3& dir, float radius,
+                          float innerDeg, float outerDeg, const glm::vec3& color, float intensity);
+    void removeLight(uint32_t id);
+    void clearLights();
+    Light* light(uint32_t id); // 可直接改参数；无效 id 返回 nullptr
+
+    // 遍历全部有效光（逐物体光表等其它光照路径共用这份光源列表）
+    template <class Fn> void forEachLight(Fn&& fn) const {
+        for (std::size_t i = 0; i < m_lights.size(); ++i)
+            if (m_alive[i]) fn(m_lights[i]);
+    }
+
+    // 一盏光的 GPU 布局（3 个 vec4）：pos,radius | color*intensity,spotScale | dir,spotOffset
+    static void packLight(const Light& l, float out[12]);
+
+    // 每帧（主线程，绘制前）：按当前相机分簇并上传。view/proj 为 bx 约定（左手、列主序）
+    // extra：额外的一盏光（如 Lighting 的旧点光），可为空
+    void update(const float view[16], const float proj[16], uint16_t width, uint16_t height,
+                float zNear, float zFar, const Light* extra = nullptr);
+
+    bool supported() const { return m_supported; }
+    bool active() const { return m_supported && m_stats.visible > 0; }
+
+    // 绑定三张纹理（firstStage 起连续 3 个）+ 簇参数；每个 draw 调一次
+    void bind(uint8_t firstStage) const;
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct SliceBounds { // 一个 slice 内全部簇的视空间 AABB（SoA，便于 4 个一组测试）
+        alignas(16) float minX[kTilesPerSlice], minY[kTilesPerSlice], minZ[kTilesPerSlice];
+        alignas(16) float maxX[kTilesPerSlice], maxY[kTilesPerSlice], maxZ[kTilesPerSlice];
+    };
+    struct ViewLight { // 视空间里的一盏光（本帧）
+        float x, y, z, r;
+        float dx, dy, dz;
+        float cosOuter, sinOuter;
+        bool  spot;
+    };
+
+    void rebuildBounds(const float proj[16], float zNear, float zFar);
+    void binSlice(uint32_t slice);
+
+    ke::JobSystem* m_jobs = nullptr;
+    bool m_supported = false;
+
+    std::vector<Light>    m_lights;
+    std::vector<uint8_t>  m_alive;
+    std::vector<uint32_t> m_free;
+
+    // 簇几何（投影/近远平面变了才重算）
+    float m_boundsKey[4] = { 0, 0, 0, 0 }; // proj[0], proj[5], near, far
+    std::vector<SliceBounds> m_bounds;      // kSlices 个
+
+    // 本帧数据
+    std::vector<ViewLight> m_viewLights;
+    std::vector<uint32_t>  m_sliceLights[kSlices]; // 每个 slice 要测试的光
+    std::vector<uint16_t>  m_clusterLights;        // kClusters × kMaxLightsPerCluster
+    std::vector<uint16_t>  m_clusterCount;         // kClusters
+    uint8_t                m_sliceOverflow[kSlices] = {};
+
+    std::vector<float> m_lightData; // 3 texel × 4 float / 光
+    std::vector<float> m_gridData;  // kClusters × 2
+    std::vector<float> m_indexData; // kIndexTexWidth × kIndexTexHeight
+
+    bgfx::TextureHandle m_texLights = BGFX_INVALID_HANDLE;
+    bgfx::TextureHandle m_texGrid   = BGFX_INVALID_HANDLE;
+    bgfx::TextureHandle m_texIndex  = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_lightData   = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_clusterGrid = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_lightIndex  = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle u_cluster     = BGFX_INVALID_HANDLE; // vec4[3]，布局同 m_params
+    // [0] tilesX, tilesY, slices, 索引纹理宽
+    // [1] tilesX/视口宽, tilesY/视口高, 视口高, originBottomLeft
+    // [2] near, slices/log(far/near), 0, 0
+    float m_params[12] = {};
+
+    Stats m_stats;
+};
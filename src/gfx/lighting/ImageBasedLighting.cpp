@@ -0,0 +1,566 @@
+#include "ImageBasedLighting.h"
+#include "core/JobSystem.h"
+#include <SDL.h>
+#include <bx/math.h>
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KE_IBL_SSE 1
+#else
+#define KE_IBL_SSE 0
+#endif
+
+namespace fs = std::filesystem;
+
+static constexpr float kPi = 3.14159265358979f;
+static constexpr uint32_t kCacheVersion = 1;
+static constexpr uint32_t kMagicEnv = 0x4249454B; // "KEIB"
+static constexpr uint32_t kMagicLut = 0x544C454B; // "KELT"
+
+// ===== 4 分量小向量：texel 都是 RGBA32F，一次读一个 =====
+#if KE_IBL_SSE
+using F4 = __m128;
+static inline F4 f4load(const float* p) { return _mm_loadu_ps(p); }
+static inline F4 f4splat(float s) { return _mm_set1_ps(s); }
+static inline F4 f4zero() { return _mm_setzero_ps(); }
+static inline F4 f4add(F4 a, F4 b) { return _mm_add_ps(a, b); }
+static inline F4 f4mul(F4 a, F4 b) { return _mm_mul_ps(a, b); }
+static inline F4 f4madd(F4 a, F4 b, F4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline void f4store(float* p, F4 v) { _mm_storeu_ps(p, v); }
+#else
+struct F4 { float v[4]; };
+static inline F4 f4load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+static inline F4 f4splat(float s) { return { { s, s, s, s } }; }
+static inline F4 f4zero() { return f4splat(0.0f); }
+static inline F4 f4add(F4 a, F4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+static inline F4 f4mul(F4 a, F4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+static inline F4 f4madd(F4 a, F4 b, F4 c) { for (int i = 0; i < 4; ++i) c.v[i] += a.v[i] * b.v[i]; return c; }
+static inline void f4store(float* p, F4 v) { std::memcpy(p, v.v, sizeof(v.v)); }
+#endif
+
+static uint64_t fnv1a(const void* data, size_t size, uint64_t h = 0xcbf29ce484222325ull) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; ++i) { h ^= p[i]; h *= 0x100000001b3ull; }
+    return h;
+}
+
+static float msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static uint8_t specMipCount() {
+    uint8_t n = 1;
+    for (uint16_t s = ImageBasedLighting::kSpecSize; s > 1; s >>= 1) ++n;
+    return n;
+}
+
+// Hammersley 低差异序列
+static void hammersley(uint32_t i, uint32_t n, float& x, float& y) {
+    uint32_t b = i;
+    b = (b << 16) | (b >> 16);
+    b = ((b & 0x55555555u) << 1) | ((b & 0xAAAAAAAAu) >> 1);
+    b = ((b & 0x33333333u) << 2) | ((b & 0xCCCCCCCCu) >> 2);
+    b = ((b & 0x0F0F0F0Fu) << 4) | ((b & 0xF0F0F0F0u) >> 4);
+    b = ((b & 0x00FF00FFu) << 8) | ((b & 0xFF00FF00u) >> 8);
+    x = (float(i) + 0.5f) / float(n);
+    y = float(b) * 2.3283064365386963e-10f;
+}
+
+// GGX 重要性采样：切线空间的半角向量（z = 法线）
+static void sampleGGX(float x, float y, float a, float h[3]) {
+    const float phi = 2.0f * kPi * x;
+    const float cosT = std::sqrt((1.0f - y) / (1.0f + (a * a - 1.0f) * y));
+    const float sinT = std::sqrt(std::max(0.0f, 1.0f - cosT * cosT));
+    h[0] = sinT * std::cos(phi);
+    h[1] = sinT * std::sin(phi);
+    h[2] = cosT;
+}
+
+// 方向 ↔ equirect uv：v=0 为 +Y，u 绕 Y 轴一圈
+static void dirToUv(const float d[3], float& u, float& v) {
+    u = 0.5f + std::atan2(d[2], d[0]) * (0.5f / kPi);
+    v = std::acos(std::min(1.0f, std::max(-1.0f, d[1]))) / kPi;
+}
+
+// 立方体面 texel 中心 → 方向（GL/D3D 通用的面朝向；u、v ∈ [-1,1]，v 向下）
+static void cubeDir(uint32_t face, float u, float v, float d[3]) {
+    switch (face) {
+    case 0:  d[0] =  1; d[1] = -v; d[2] = -u; break;
+    case 1:  d[0] = -1; d[1] = -v; d[2] =  u; break;
+    case 2:  d[0] =  u; d[1] =  1; d[2] =  v; break;
+    case 3:  d[0] =  u; d[1] = -1; d[2] = -v; break;
+    case 4:  d[0] =  u; d[1] = -v; d[2] =  1; break;
+    default: d[0] = -u; d[1] = -v; d[2] = -1; break;
+    }
+    const float inv = 1.0f / std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    d[0] *= inv; d[1] *= inv; d[2] *= inv;
+}
+
+// 双线性：u 环绕、v 夹紧
+template <typename LevelT>
+static F4 sampleBilinear(const LevelT& l, float u, float v) {
+    const float x = u * l.w - 0.5f, y = v * l.h - 0.5f;
+    const float fx0 = std::floor(x), fy0 = std::floor(y);
+    const float fx = x - fx0, fy = y - fy0;
+    int x0 = int(fx0) % l.w; if (x0 < 0) x0 += l.w;
+    const int x1 = (x0 + 1) % l.w;
+    const int y0 = std::max(0, std::min(l.h - 1, int(fy0)));
+    const int y1 = std::max(0, std::min(l.h - 1, int(fy0) + 1));
+    const float* r0 = &l.rgba[size_t(y0) * l.w * 4];
+    const float* r1 = &l.rgba[size_t(y1) * l.w * 4];
+    const F4 top = f4madd(f4load(r0 + x0 * 4), f4splat(1.0f - fx), f4mul(f4load(r0 + x1 * 4), f4splat(fx)));
+    const F4 bot = f4madd(f4load(r1 + x0 * 4), f4splat(1.0f - fx), f4mul(f4load(r1 + x1 * 4), f4splat(fx)));
+    return f4madd(top, f4splat(1.0f - fy), f4mul(bot, f4splat(fy)));
+}
+
+// 三线性：在相邻两级 equirect 之间插值
+template <typename LevelT>
+static F4 sampleLod(const std::vector<LevelT>& levels, float u, float v, float lod) {
+    lod = std::max(0.0f, std::min(float(levels.size() - 1), lod));
+    const uint32_t l0 = uint32_t(lod);
+    const uint32_t l1 = std::min<uint32_t>(l0 + 1, uint32_t(levels.size() - 1));
+    const float t = lod - float(l0);
+    const F4 a = sampleBilinear(levels[l0], u, v);
+    if (t <= 0.0f || l0 == l1) return a;
+    return f4madd(a, f4splat(1.0f - t), f4mul(sampleBilinear(levels[l1], u, v), f4splat(t)));
+}
+
+// 半精度最大有限值；HDR 里更亮的像素（太阳等）不夹住会变成 +inf，卷积 / 采样后扩散成整片坏值
+static constexpr float kHalfMax = 65504.0f;
+
+static void toHalf4(F4 c, uint16_t* out) {
+    float f[4];
+    f4store(f, c);
+    for (int i = 0; i < 4; ++i) // max 写成 (0, x)：NaN 也落到 0
+        out[i] = bx::halfFromFloat(std::min(std::max(0.0f, f[i]), kHalfMax));
+}
+
+bool ImageBasedLighting::init(ke::JobSystem& jobs, const std::string& cacheRoot) {
+    m_jobs = &jobs;
+    const bgfx::Caps* caps = bgfx::getCaps();
+    m_supported = caps && (caps->formats[bgfx::TextureFormat::RGBA16F] & BGFX_CAPS_FORMAT_TEXTURE_CUBE)
+               && (caps->formats[bgfx::TextureFormat::RG16F] & BGFX_CAPS_FORMAT_TEXTURE_2D);
+    if (!m_supported) {
+        spdlog::warn("[IBL] RGBA16F cube / RG16F textures not supported, using flat ambient");
+        return false;
+    }
+
+    if (!cacheRoot.empty()) {
+        m_dir = fs::path(cacheRoot);
+    } else {
+        char* pref = SDL_GetPrefPath("K-ENGINE", "KEngine");
+        m_dir = (pref ? fs::path(pref) : fs::current_path()) / "iblcache";
+        if (pref) SDL_free(pref);
+    }
+    std::error_code ec;
+    fs::create_directories(m_dir, ec);
+    if (ec) {
+        spdlog::warn("[IBL] cannot create {}: {}, results will not be cached", m_dir.string(), ec.message());
+        m_dir.clear();
+    }
+
+    s_envSpec   = bgfx::createUniform("s_envSpec",   bgfx::UniformType::Sampler);
+    s_brdfLut   = bgfx::createUniform("s_brdfLut",   bgfx::UniformType::Sampler);
+    u_envSH     = bgfx::createUniform("u_envSH",     bgfx::UniformType::Vec4, 9);
+    u_iblParams = bgfx::createUniform("u_iblParams", bgfx::UniformType::Vec4);
+    return true;
+}
+
+void ImageBasedLighting::shutdown() {
+    for (bgfx::TextureHandle* t : { &m_specCube, &m_lut }) {
+        if (bgfx::isValid(*t)) bgfx::destroy(*t);
+        *t = BGFX_INVALID_HANDLE;
+    }
+    for (bgfx::UniformHandle* u : { &s_envSpec, &s_brdfLut, &u_envSH, &u_iblParams }) {
+        if (bgfx::isValid(*u)) bgfx::destroy(*u);
+        *u = BGFX_INVALID_HANDLE;
+    }
+    m_supported = false;
+    m_enabled = false;
+    m_stats = {};
+}
+
+// ===== 磁盘缓存 =====
+namespace {
+struct CacheHeader {
+    uint32_t magic = 0;
+    uint32_t version = kCacheVersion;
+    uint64_t size = 0;     // 负载字节数
+    uint64_t checksum = 0; // 负载的 FNV-1a 64
+};
+}
+
+bool ImageBasedLighting::readCache(const fs::path& file, uint32_t magic, std::vector<uint8_t>& payload) const {
+    if (m_dir.empty()) return false;
+    std::ifstream ifs(file, std::ios::binary | std::ios::ate);
+    if (!ifs) return false;
+    const uint64_t fileSize = (uint64_t)ifs.tellg();
+    ifs.seekg(0);
+    CacheHeader hdr;
+    bool ok = fileSize >= sizeof(hdr) && ifs.read((char*)&hdr, sizeof(hdr))
+           && hdr.magic == magic && hdr.version == kCacheVersion && fileSize == sizeof(hdr) + hdr.size;
+    if (ok) {
+        payload.resize(hdr.size);
+        ok = ifs.read((char*)payload.data(), hdr.size) && fnv1a(payload.data(), payload.size()) == hdr.checksum;
+    }
+    if (!ok) {
+        ifs.close();
+        spdlog::warn("[IBL] stale or corrupt cache {}, recomputing", file.filename().string());
+        std::error_code ec;
+        fs::remove(file, ec);
+    }
+    return ok;
+}
+
+void ImageBasedLighting::writeCache(const fs::path& file, uint32_t magic, const std::vector<uint8_t>& payload) const {
+    if (m_dir.empty()) return;
+    CacheHeader hdr;
+    hdr.magic = magic;
+    hdr.size = payload.size();
+    hdr.checksum = fnv1a(payload.data(), payload.size());
+
+    fs::path tmp = file;
+    tmp += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs.write((const char*)&hdr, sizeof(hdr)) || !ofs.write((const char*)payload.data(), payload.size())) {
+            ofs.close();
+            fs::remove(tmp, ec);
+            return;
+        }
+    }
+    fs::rename(tmp, file, ec);
+    if (ec) fs::remove(tmp, ec);
+}
+
+// ===== 预计算 =====
+void ImageBasedLighting::buildPyramid(std::vector<Level>& levels) const {
+    // 2x2 盒式缩小到宽 8 为止；equirect 各级的 texel 立体角大致按 4 倍递增，可直接按 log2 选级
+    while (levels.back().w > 8 && levels.back().h > 4) {
+        const Level& src = levels.back();
+        Level dst;
+        dst.w = src.w / 2;
+        dst.h = src.h / 2;
+        dst.rgba.resize(size_t(dst.w) * dst.h * 4);
+        m_jobs->parallelFor((uint32_t)dst.h, 8, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t y = begin; y < end; ++y) {
+                const float* r0 = &src.rgba[size_t(2 * y) * src.w * 4];
+                const float* r1 = &src.rgba[size_t(std::min<int>(2 * y + 1, src.h - 1)) * src.w * 4];
+                float* out = &dst.rgba[size_t(y) * dst.w * 4];
+                for (int x = 0; x < dst.w; ++x) {
+                    const int x1 = std::min(2 * x + 1, src.w - 1);
+                    F4 s = f4add(f4add(f4load(r0 + 8 * x), f4load(r0 + 4 * x1)),
+                                 f4add(f4load(r1 + 8 * x), f4load(r1 + 4 * x1)));
+                    f4store(out + 4 * x, f4mul(s, f4splat(0.25f)));
+                }
+            }
+        });
+        levels.push_back(std::move(dst));
+    }
+}
+
+void ImageBasedLighting::projectSH(const std::vector<Level>& levels, float outSH[9][4]) const {
+    // 低频信号：用不超过 kShMaxWidth 的那一级投影就够了
+    size_t li = 0;
+    while (li + 1 < levels.size() && uint32_t(levels[li].w) > kShMaxWidth) ++li;
+    const Level& l = levels[li];
+
+    std::mutex mutex;
+    F4 total[9];
+    for (F4& t : total) t = f4zero();
+
+    m_jobs->parallelFor((uint32_t)l.h, 4, [&](uint32_t begin, uint32_t end) {
+        F4 acc[9];
+        for (F4& a : acc) a = f4zero();
+        for (uint32_t y = begin; y < end; ++y) {
+            const float theta = (float(y) + 0.5f) / float(l.h) * kPi;
+            const float sinT = std::sin(theta), cosT = std::cos(theta);
+            const float dOmega = (2.0f * kPi / float(l.w)) * (kPi / float(l.h)) * sinT;
+            const float* row = &l.rgba[size_t(y) * l.w * 4];
+            for (int x = 0; x < l.w; ++x) {
+                const float phi = ((float(x) + 0.5f) / float(l.w) - 0.5f) * 2.0f * kPi;
+                const float dx = sinT * std::cos(phi), dy = cosT, dz = sinT * std::sin(phi);
+                const float basis[9] = {
+                    0.282095f,
+                    0.488603f * dy, 0.488603f * dz, 0.488603f * dx,
+                    1.092548f * dx * dy, 1.092548f * dy * dz, 0.315392f * (3.0f * dz * dz - 1.0f),
+                    1.092548f * dx * dz, 0.546274f * (dx * dx - dy * dy),
+                };
+                const F4 c = f4mul(f4load(row + 4 * x), f4splat(dOmega));
+                for (int i = 0; i < 9; ++i) acc[i] = f4madd(c, f4splat(basis[i]), acc[i]);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < 9; ++i) total[i] = f4add(total[i], acc[i]);
+    });
+
+    // 辐照度 E(n) = Σ Â_l L_lm Y_lm(n)；着色器要的是 E/π（Lambert），把 Â_l/π 与 Y 的常数一起烘进系数，
+    // 着色器只需 c0 + c1*y + c2*z + c3*x + c4*xy + c5*yz + c6*(3z²-1) + c7*xz + c8*(x²-y²)
+    static const float kBand[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f,
+                                    0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+    static const float kBasis[9] = { 0.282095f, 0.488603f, 0.488603f, 0.488603f,
+                                     1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f };
+    for (int i = 0; i < 9; ++i) {
+        f4store(outSH[i], f4mul(total[i], f4splat(kBand[i] * kBasis[i])));
+        outSH[i][3] = 0.0f;
+    }
+}
+
+void ImageBasedLighting::prefilterSpecular(const std::vector<Level>& levels, std::vector<uint16_t>& out) const {
+    const uint8_t mips = specMipCount();
+    const float saSrc = 4.0f * kPi / (float(levels[0].w) * float(levels[0].h)); // equirect mip0 的平均 texel 立体角
+
+    // 每级的采样集（切线空间 L、权重 NoL、源 lod），与 texel 无关，先算好
+    struct Sample { float l[3]; float w; float lod; };
+    std::vector<std::vector<Sample>> sets(mips);
+    for (uint8_t m = 1; m < mips; ++m) {
+        const float rough = std::min(1.0f, float(m) / float(kRoughMips - 1));
+        const float a = rough * rough;
+        for (uint32_t i = 0; i < kSpecSamples; ++i) {
+            float x, y, h[3];
+            hammersley(i, kSpecSamples, x, y);
+            sampleGGX(x, y, a, h);
+            // 假设 N = V = R：L = 2(N·H)H - N
+            Sample s;
+            s.l[0] = 2.0f * h[2] * h[0];
+            s.l[1] = 2.0f * h[2] * h[1];
+            s.l[2] = 2.0f * h[2] * h[2] - 1.0f;
+            if (s.l[2] <= 0.0f) continue;
+            s.w = s.l[2];
+            // pdf(L) = D(NoH) * NoH / (4 VoH) = D / 4；按样本覆盖的立体角选源 mip（+1 偏置压噪点）
+            const float a2 = a * a;
+            const float d = h[2] * h[2] * (a2 - 1.0f) + 1.0f;
+            const float pdf = a2 / (kPi * d * d) * 0.25f;
+            const float saSample = 1.0f / (float(kSpecSamples) * pdf + 1e-6f);
+            s.lod = std::max(0.0f, 0.5f * std::log2(saSample / saSrc) + 1.0f);
+            sets[m].push_back(s);
+        }
+    }
+
+    // 行任务：(mip, face, y) 摊平后并行
+    struct Row { uint8_t mip; uint8_t face; uint16_t y; };
+    std::vector<Row> rows;
+    std::vector<size_t> faceOffset(size_t(mips) * 6); // 以 uint16 计，按 bgfx 立方体布局：逐面，每面完整 mip 链
+    size_t total = 0;
+    for (uint8_t f = 0; f < 6; ++f)
+        for (uint8_t m = 0; m < mips; ++m) {
+            const uint16_t s = uint16_t(std::max(1, kSpecSize >> m));
+            faceOffset[size_t(f) * mips + m] = total;
+            total += size_t(s) * s * 4;
+            for (uint16_t y = 0; y < s; ++y) rows.push_back({ m, f, y });
+        }
+    out.assign(total, 0);
+
+    m_jobs->parallelFor((uint32_t)rows.size(), 4, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t r = begin; r < end; ++r) {
+            const Row& row = rows[r];
+            const uint16_t s = uint16_t(std::max(1, kSpecSize >> row.mip));
+            uint16_t* dst = &out[faceOffset[size_t(row.face) * mips + row.mip] + size_t(row.y) * s * 4];
+            const float v = 2.0f * (float(row.y) + 0.5f) / float(s) - 1.0f;
+            // mip0 = 镜面反射：按目标 texel 的立体角取源 lod，避免欠采样闪烁
+            const float lod0 = std::max(0.0f, 0.5f * std::log2((4.0f * kPi / (6.0f * s * s)) / saSrc));
+
+            for (uint16_t x = 0; x < s; ++x) {
+                const float u = 2.0f * (float(x) + 0.5f) / float(s) - 1.0f;
+                float n[3], uv[2];
+                cubeDir(row.face, u, v, n);
+                if (row.mip == 0) {
+                    dirToUv(n, uv[0], uv[1]);
+                    toHalf4(sampleLod(levels, uv[0], uv[1], lod0), dst + 4 * x);
+                    continue;
+                }
+                // 以 N 为 z 的切线框
+                const float up[3] = { std::fabs(n[1]) < 0.999f ? 0.0f : 1.0f, std::fabs(n[1]) < 0.999f ? 1.0f : 0.0f, 0.0f };
+                float t[3] = { up[1] * n[2] - up[2] * n[1], up[2] * n[0] - up[0] * n[2], up[0] * n[1] - up[1] * n[0] };
+                const float tl = 1.0f / std::sqrt(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+                t[0] *= tl; t[1] *= tl; t[2] *= tl;
+                const float b[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+
+                F4 sum = f4zero();
+                float wsum = 0.0f;
+                for (const Sample& smp : sets[row.mip]) {
+                    const float l[3] = {
+                        t[0] * smp.l[0] + b[0] * smp.l[1] + n[0] * smp.l[2],
+                        t[1] * smp.l[0] + b[1] * smp.l[1] + n[1] * smp.l[2],
+                        t[2] * smp.l[0] + b[2] * smp.l[1] + n[2] * smp.l[2],
+                    };
+                    dirToUv(l, uv[0], uv[1]);
+                    sum = f4madd(sampleLod(levels, uv[0], uv[1], smp.lod), f4splat(smp.w), sum);
+                    wsum += smp.w;
+                }
+                toHalf4(f4mul(sum, f4splat(wsum > 0.0f ? 1.0f / wsum : 0.0f)), dst + 4 * x);
+            }
+        }
+    });
+}
+
+void ImageBasedLighting::computeLut(std::vector<uint16_t>& out) const {
+    // split-sum：x = NoV，y = roughness；输出 (scale, bias)，镜面 = prefiltered * (F0 * scale + bias)
+    out.assign(size_t(kLutSize) * kLutSize * 2, 0);
+    m_jobs->parallelFor(kLutSize, 4, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            const float rough = (float(y) + 0.5f) / float(kLutSize);
+            const float a = rough * rough;
+            const float k = a * 0.5f; // IBL 用的 Schlick-Smith k
+            for (uint32_t x = 0; x < kLutSize; ++x) {
+                const float NoV = (float(x) + 0.5f) / float(kLutSize);
+                const float V[3] = { std::sqrt(1.0f - NoV * NoV), 0.0f, NoV };
+                float A = 0.0f, B = 0.0f;
+                for (uint32_t i = 0; i < kLutSamples; ++i) {
+                    float sx, sy, h[3];
+                    hammersley(i, kLutSamples, sx, sy);
+                    sampleGGX(sx, sy, a, h);
+                    const float VoH = V[0] * h[0] + V[2] * h[2];
+                    const float NoL = 2.0f * VoH * h[2] - V[2];
+                    if (NoL <= 0.0f) continue;
+                    const float NoH = h[2];
+                    const float G = (NoV / (NoV * (1.0f - k) + k)) * (NoL / (NoL * (1.0f - k) + k));
+                    const float Gv = G * std::max(VoH, 0.0f) / (NoH * NoV);
+                    const float f1 = 1.0f - std::max(VoH, 0.0f), f2 = f1 * f1;
+                    const float Fc = f2 * f2 * f1;
+                    A += (1.0f - Fc) * Gv;
+                    B += Fc * Gv;
+                }
+                uint16_t* dst = &out[(size_t(y) * kLutSize + x) * 2];
+                dst[0] = bx::halfFromFloat(A / float(kLutSamples));
+                dst[1] = bx::halfFromFloat(B / float(kLutSamples));
+            }
+        }
+    });
+}
+
+bool ImageBasedLighting::ensureLut() {
+    if (bgfx::isValid(m_lut)) return true;
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "brdf_%u_%u.lut", unsigned(kLutSize), unsigned(kLutSamples));
+    std::vector<uint8_t> payload;
+    std::vector<uint16_t> lut;
+    const size_t bytes = size_t(kLutSize) * kLutSize * 2 * sizeof(uint16_t);
+    m_stats.lutFromCache = readCache(m_dir / name, kMagicLut, payload) && payload.size() == bytes;
+    if (m_stats.lutFromCache) {
+        lut.resize(bytes / sizeof(uint16_t));
+        std::memcpy(lut.data(), payload.data(), bytes);
+    } else {
+        const auto t0 = std::chrono::steady_clock::now();
+        computeLut(lut);
+        m_stats.lutMs = msSince(t0);
+        payload.assign((const uint8_t*)lut.data(), (const uint8_t*)lut.data() + bytes);
+        writeCache(m_dir / name, kMagicLut, payload);
+    }
+    m_lut = bgfx::createTexture2D(kLutSize, kLutSize, false, 1, bgfx::TextureFormat::RG16F,
+                                  BGFX_SAMPLER_UVW_CLAMP, bgfx::copy(lut.data(), (uint32_t)bytes));
+    return bgfx::isValid(m_lut);
+}
+
+bool ImageBasedLighting::load(const std::string& hdrPath) {
+    if (!m_supported) return false;
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> file;
+    {
+        std::ifstream ifs(hdrPath, std::ios::binary | std::ios::ate);
+        if (!ifs) {
+            spdlog::error("[IBL] cannot open {}", hdrPath);
+            return false;
+        }
+        file.resize((size_t)ifs.tellg());
+        ifs.seekg(0);
+        if (!ifs.read((char*)file.data(), file.size())) {
+            spdlog::error("[IBL] read failed: {}", hdrPath);
+            return false;
+        }
+    }
+    if (!ensureLut()) return false;
+
+    // 缓存键：文件内容 + 影响结果的全部参数
+    const uint32_t params[] = { kCacheVersion, kSpecSize, kRoughMips, kSpecSamples, kShMaxWidth };
+    const uint64_t hash = fnv1a(params, sizeof(params), fnv1a(file.data(), file.size()));
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ibl", (unsigned long long)hash);
+
+    const uint8_t mips = specMipCount();
+    size_t specTexels = 0;
+    for (uint8_t m = 0; m < mips; ++m) specTexels += size_t(std::max(1, kSpecSize >> m)) * std::max(1, kSpecSize >> m);
+    const size_t shBytes = sizeof(m_sh);
+    const size_t specBytes = specTexels * 6 * 4 * sizeof(uint16_t);
+
+    Stats st = m_stats;
+    st.hash = hash;
+    st.shMs = st.specMs = 0;
+    std::vector<uint8_t> payload;
+    std::vector<uint16_t> spec;
+    st.fromCache = readCache(m_dir / name, kMagicEnv, payload) && payload.size() == shBytes + specBytes;
+    if (st.fromCache) {
+        std::memcpy(m_sh, payload.data(), shBytes);
+        spec.resize(specBytes / sizeof(uint16_t));
+        std::memcpy(spec.data(), payload.data() + shBytes, specBytes);
+        st.loadMs = msSince(t0);
+    } else {
+        std::vector<Level> levels(1);
+        int comp = 0;
+        stbi_set_flip_vertically_on_load_thread(0);
+        float* px = stbi_loadf_from_memory(file.data(), (int)file.size(), &levels[0].w, &levels[0].h, &comp, 4);
+        if (!px) {
+            spdlog::error("[IBL] decode failed: {} ({})", hdrPath, stbi_failure_reason());
+            return false;
+        }
+        levels[0].rgba.assign(px, px + size_t(levels[0].w) * levels[0].h * 4);
+        stbi_image_free(px);
+        file.clear();
+        file.shrink_to_fit();
+        if (levels[0].w < 16 || levels[0].h < 8) {
+            spdlog::error("[IBL] {}: {}x{} too small", hdrPath, levels[0].w, levels[0].h);
+            return false;
+        }
+        st.loadMs = msSince(t0);
+
+        auto t1 = std::chrono::steady_clock::now();
+        buildPyramid(levels);
+        projectSH(levels, m_sh);
+        st.shMs = msSince(t1);
+
+        t1 = std::chrono::steady_clock::now();
+        prefilterSpecular(levels, spec);
+        st.specMs = msSince(t1);
+
+        payload.resize(shBytes + specBytes);
+        std::memcpy(payload.data(), m_sh, shBytes);
+        std::memcpy(payload.data() + shBytes, spec.data(), specBytes);
+        writeCache(m_dir / name, kMagicEnv, payload);
+    }
+
+    if (bgfx::isValid(m_specCube)) bgfx::destroy(m_specCube);
+    m_specCube = bgfx::createTextureCube(kSpecSize, true, 1, bgfx::TextureFormat::RGBA16F,
+                                         BGFX_SAMPLER_UVW_CLAMP, bgfx::copy(spec.data(), (uint32_t)specBytes));
+    if (!bgfx::isValid(m_specCube)) {
+        spdlog::error("[IBL] createTextureCube {} failed", kSpecSize);
+        return false;
+    }
+    m_stats = st;
+    m_enabled = true;
+    spdlog::info("[IBL] {}: {} (load {:.1f} ms, sh {:.1f} ms, specular {:.1f} ms)", hdrPath,
+                 st.fromCache ? "cached" : "computed", st.loadMs, st.shMs, st.specMs);
+    return true;
+}
+
+void ImageBasedLighting::bind(uint8_t firstStage) const {
+    // x = 强度（0 = 关，着色器退回平坦环境光）  y = 镜面最大 roughness 对应的 mip
+    const float params[4] = { m_enabled ? m_intensity : 0.0f, float(kRoughMips - 1), 0.0f, 0.0f };
+    if (m_enabled) {
+        bgfx::setTexture(firstStage,     s_envSpec, m_specCube);
+        bgfx::setTexture(firstStage + 1, s_brdfLut, m_lut);
+        bgfx::setUniform(u_envSH, m_sh, 9);
+    }
+    if (bgfx::isValid(u_iblParams)) bgfx::setUniform(u_iblParams, params);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace ke { class JobSystem; }
+
+// 名称速记：ImageBasedLighting = 环境光（IBL）的 CPU 预计算 + 磁盘缓存
+// - 输入一张等距柱状（equirect）HDR；加载时在工作线程上并行算：
+//   1) 漫反射辐照度的 3 阶球谐（9 个系数，已乘好余弦卷积与基函数常数）
+//   2) GGX 预滤波的镜面立方体贴图：mip i 对应 roughness = i / (kRoughMips-1)，按 pdf 选源 mip 减少采样数
+//   3) split-sum 的 BRDF LUT（与环境无关，单独缓存一份）
+// - 结果按“文件内容哈希 + 参数”落盘：<root>/<hash>.ibl；同一环境第二次加载直接读盘
+// - 文件头带魔数/版本/长度/FNV-1a 校验，不符就重算；写入走“临时文件 + rename”
+// - 设备不支持 RGBA16F 立方体 / RG16F 纹理时不可用，着色器退回平坦环境光
+class ImageBasedLighting {
+public:
+    static constexpr uint16_t kSpecSize    = 128; // 镜面立方体 mip0 边长（完整 mip 链到 1x1）
+    static constexpr uint8_t  kRoughMips   = 6;   // 前几级按 roughness 0..1 均分，其余同 roughness 1
+    static constexpr uint32_t kSpecSamples = 64;  // 每 texel 的 GGX 重要性采样数
+    static constexpr uint16_t kLutSize     = 128;
+    static constexpr uint32_t kLutSamples  = 256;
+    static constexpr uint32_t kShMaxWidth  = 256; // 球谐投影用不超过这么宽的 equirect mip
+
+    struct Stats {
+        uint64_t hash = 0;        // 当前环境的缓存键
+        bool  fromCache = false;  // 环境数据直接读盘
+        bool  lutFromCache = false;
+        float loadMs = 0;         // 读文件 + 哈希 + 解码（或读缓存）
+        float shMs = 0, specMs = 0, lutMs = 0;
+    };
+
+    // cacheRoot 为空时用 SDL_GetPrefPath 下的 iblcache；须在 bgfx::init 之后调用
+    bool init(ke::JobSystem& jobs, const std::string& cacheRoot = {});
+    void shutdown();
+
+    // 主线程调用（内部用 parallelFor 并行）；成功后自动启用
+    bool load(const std::string& hdrPath);
+
+    void setEnabled(bool b) { m_enabled = b && loaded(); }
+    bool enabled() const { return m_enabled; }
+    bool loaded() const { return bgfx::isValid(m_specCube); }
+    bool supported() const { return m_supported; }
+    void setIntensity(float k) { m_intensity = k; }
+
+    // 绑定镜面立方体（firstStage）与 LUT（firstStage+1）+ 球谐/参数；每个 PBR draw 调一次
+    void bind(uint8_t firstStage) const;
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    // equirect 的一级：RGBA32F（a 不用，方便 SIMD 一次读一个 texel）
+    struct Level {
+        int w = 0, h = 0;
+        std::vector<float> rgba;
+    };
+
+    void buildPyramid(std::vector<Level>& levels) const;
+    void projectSH(const std::vector<Level>& levels, float outSH[9][4]) const;
+    void prefilterSpecular(const std::vector<Level>& levels, std::vector<uint16_t>& out) const;
+    void computeLut(std::vector<uint16_t>& out) const;
+
+    bool readCache(const std::filesystem::path& file, uint32_t magic, std::vector<uint8_t>& payload) const;
+    void writeCache(const std::filesystem::path& file, uint32_t magic, const std::vector<uint8_t>& payload) const;
+    bool ensureLut();
+
+    ke::JobSystem* m_jobs = nullptr;
+    std::filesystem::path m_dir; // 空 = 缓存不可用（照算不存）
+    bool  m_supported = false;
+    bool  m_enabled = false;
+    float m_intensity = 1.0f;
+
+    bgfx::TextureHandle m_specCube = BGFX_INVALID_HANDLE;
+    bgfx::TextureHandle m_lut      = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_envSpec  = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_brdfLut  = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle u_envSH    = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle u_iblParams= BGFX_INVALID_HANDLE;
+    float m_sh[9][4] = {};
+    Stats m_stats;
+};
@@ -0,0 +1,130 @@
+#include "ObjectLights.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+bool ObjectLights::init() {
+    u_objLights = bgfx::createUniform("u_objLights", bgfx::UniformType::Vec4, kMaxPerObject * 3);
+    return bgfx::isValid(u_objLights);
+}
+
+void ObjectLights::shutdown() {
+    if (bgfx::isValid(u_objLights)) bgfx::destroy(u_objLights);
+    u_objLights = BGFX_INVALID_HANDLE;
+    m_lights.clear();
+    m_entries.clear();
+    m_global.clear();
+    m_stamp.clear();
+    m_stats = {};
+}
+
+uint64_t ObjectLights::cellKey(int x, int y, int z) {
+    // 每轴 21 位（偏移到非负），足够覆盖 ±4M 个格子
+    const uint64_t bias = 1u << 20, mask = (1u << 21) - 1;
+    return ((uint64_t(x + bias) & mask) << 42) | ((uint64_t(y + bias) & mask) << 21) | (uint64_t(z + bias) & mask);
+}
+
+static int cellOf(float v) { return (int)std::floor(v / ObjectLights::kCellSize); }
+
+void ObjectLights::build(const ClusteredLighting& lights, const ClusteredLighting::Light* extra) {
+    m_lights.clear();
+    lights.forEachLight([&](const ClusteredLighting::Light& l) {
+        if (l.radius > 0.0f && l.intensity > 0.0f) m_lights.push_back(l);
+    });
+    if (extra && extra->radius > 0.0f && extra->intensity > 0.0f) m_lights.push_back(*extra);
+
+    m_entries.clear();
+    m_global.clear();
+    for (uint32_t i = 0; i < m_lights.size(); ++i) {
+        const ClusteredLighting::Light& l = m_lights[i];
+        const int x0 = cellOf(l.pos.x - l.radius), x1 = cellOf(l.pos.x + l.radius);
+        const int y0 = cellOf(l.pos.y - l.radius), y1 = cellOf(l.pos.y + l.radius);
+        const int z0 = cellOf(l.pos.z - l.radius), z1 = cellOf(l.pos.z + l.radius);
+        const uint64_t cells = uint64_t(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+        if (cells > kMaxCellsPerLight) { m_global.push_back(i); continue; }
+        for (int z = z0; z <= z1; ++z)
+            for (int y = y0; y <= y1; ++y)
+                for (int x = x0; x <= x1; ++x)
+                    m_entries.push_back({ cellKey(x, y, z), i });
+    }
+    std::sort(m_entries.begin(), m_entries.end(),
+              [](const Entry& a, const Entry& b) { return a.cell < b.cell; });
+
+    m_stamp.assign(m_lights.size(), 0);
+    m_query = 0;
+    m_stats = {};
+    m_stats.lights = (uint32_t)m_lights.size();
+    m_stats.global = (uint32_t)m_global.size();
+}
+
+void ObjectLights::consider(uint32_t li, const float c[3], float radius, List& out, float* scores, bool& clipped) {
+    if (m_stamp[li] == m_query) return; // 同一盏光跨多个格子
+    m_stamp[li] = m_query;
+
+    const ClusteredLighting::Light& l = m_lights[li];
+    const float dx = l.pos.x - c[0], dy = l.pos.y - c[1], dz = l.pos.z - c[2];
+    const float d = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - radius, 0.0f);
+    if (d >= l.radius) return;
+
+    // 影响 = 强度 × 包围球最近点处的衰减（同着色器的 smoothstep 衰减）
+    const float a = 1.0f - d / l.radius;
+    const float lum = std::max(l.color.x, std::max(l.color.y, l.color.z)) * l.intensity;
+    const float score = lum * a * a * (3.0f - 2.0f * a);
+
+    // 插入排序到前 kMaxPerObject（n 很小，比堆快）
+    uint32_t n = out.count;
+    if (n == kMaxPerObject) {
+        clipped = true;
+        if (score <= scores[n - 1]) return;
+        --n; // 挤掉最弱的一盏
+    }
+    uint32_t pos = n;
+    while (pos > 0 && scores[pos - 1] < score) {
+        scores[pos] = scores[pos - 1];
+        std::memcpy(out.data + pos * 12, out.data + (pos - 1) * 12, 12 * sizeof(float));
+        --pos;
+    }
+    scores[pos] = score;
+    ClusteredLighting::packLight(l, out.data + pos * 12);
+    out.count = n + 1;
+}
+
+void ObjectLights::gather(const float center[3], float radius, List& out) {
+    out.count = 0;
+    ++m_stats.objects;
+    if (m_lights.empty()) return;
+    if (++m_query == 0) { std::fill(m_stamp.begin(), m_stamp.end(), 0u); m_query = 1; }
+
+    float scores[kMaxPerObject] = {};
+    bool clipped = false;
+    for (uint32_t li : m_global) consider(li, center, radius, out, scores, clipped);
+
+    const int x0 = cellOf(center[0] - radius), x1 = cellOf(center[0] + radius);
+    const int y0 = cellOf(center[1] - radius), y1 = cellOf(center[1] + radius);
+    const int z0 = cellOf(center[2] - radius), z1 = cellOf(center[2] + radius);
+    if (uint64_t(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1) > kMaxCellsPerLight) {
+        // 大物体：逐格查不如直接扫全部
+        for (uint32_t li = 0; li < m_lights.size(); ++li) consider(li, center, radius, out, scores, clipped);
+    } else {
+        for (int z = z0; z <= z1; ++z)
+            for (int y = y0; y <= y1; ++y)
+                for (int x = x0; x <= x1; ++x) {
+                    const uint64_t key = cellKey(x, y, z);
+                    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key,
+                                               [](const Entry& e, uint64_t k) { return e.cell < k; });
+                    for (; it != m_entries.end() && it->cell == key; ++it)
+                        consider(it->light, center, radius, out, scores, clipped);
+                }
+    }
+    m_stats.assigned += out.count;
+    m_stats.clipped += clipped;
+}
+
+void ObjectLights::bind(const List& list, uint32_t count) const {
+    if (count == 0) return;
+    float data[kMaxPerObject * 12];
+    const uint32_t n = std::min(list.count, count);
+    std::memcpy(data, list.data, n * 12 * sizeof(float));
+    std::memset(data + n * 12, 0, (count - n) * 12 * sizeof(float)); // 零光：颜色为 0，不贡献
+    bgfx::setUniform(u_objLights, data, uint16_t(count * 3));
+}
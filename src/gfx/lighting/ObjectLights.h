@@ -0,0 +1,58 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <vector>
+#include "gfx/lighting/ClusteredLighting.h"
+
+// 名称速记：ObjectLights = 逐物体光表（分簇的替代路径，不需要浮点数据纹理）
+// - 每帧把光源按世界空间均匀网格建索引（cell → 光）；半径过大的光进全局表
+// - 裁剪阶段每个可见网格用包围球查索引，按“强度 × 球面最近点衰减”挑最多 kMaxPerObject 盏
+// - 选中的光作为 per-draw uniform 上传；着色器按 0/1/2/4/8 盏编译排列（见 PbrPermutation.h）
+class ObjectLights {
+public:
+    static constexpr uint32_t kMaxPerObject = 8;
+    static constexpr float    kCellSize = 4.0f;        // 网格边长（世界单位）
+    static constexpr uint32_t kMaxCellsPerLight = 64;  // 超过就进全局表
+
+    struct List {
+        uint32_t count = 0;                // 实际选中的光
+        float data[kMaxPerObject * 12];    // 每盏 3 个 vec4，布局同 ClusteredLighting::packLight
+    };
+
+    struct Stats {
+        uint32_t lights = 0;    // 进索引的光
+        uint32_t global = 0;    // 其中在全局表里的
+        uint32_t objects = 0;   // 本帧查询次数
+        uint32_t assigned = 0;  // 所有物体选中的光总数
+        uint32_t clipped = 0;   // 候选超过上限、被丢掉弱光的物体
+    };
+
+    bool init();
+    void shutdown();
+
+    // 每帧（裁剪前）：重建空间索引；extra 同 ClusteredLighting::update
+    void build(const ClusteredLighting& lights, const ClusteredLighting::Light* extra = nullptr);
+
+    // 包围球（世界空间）→ 最有影响的至多 kMaxPerObject 盏光，按影响从大到小
+    void gather(const float center[3], float radius, List& out);
+
+    // 上传前 count 盏（不足的槽位填零光）；每个 draw 调一次
+    void bind(const List& list, uint32_t count) const;
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Entry { uint64_t cell; uint32_t light; };
+
+    static uint64_t cellKey(int x, int y, int z);
+    void consider(uint32_t li, const float c[3], float radius, List& out, float* scores, bool& clipped);
+
+    std::vector<ClusteredLighting::Light> m_lights; // 本帧快照
+    std::vector<Entry>    m_entries;                // 按 cell 排序
+    std::vector<uint32_t> m_global;
+    std::vector<uint32_t> m_stamp;                  // 查询去重
+    uint32_t m_query = 0;
+
+    bgfx::UniformHandle u_objLights = BGFX_INVALID_HANDLE; // vec4[kMaxPerObject * 3]
+    Stats m_stats;
+};
@@ -1,55 +1,46 @@
 #include "PbrMaterial.h"
-#include "gfx/texture/TextureLoader.h" // 你现有的创建函数：createTexture2DFromFile(...) :contentReference[oaicite:5]{index=5}
+#include "gfx/texture/TextureArrayPacker.h"
+#include <algorithm>
 #include <cassert>
+#include <initializer_list>
 
-static bgfx::UniformHandle U(const char* n, bgfx::UniformType::Enum t) {
-    auto u = bgfx::createUniform(n, t);
-    assert(bgfx::isValid(u) && "createUniform failed");
-    return u;
+bool PbrMaterialManager::init(TextureCache& texCache) {
+    m_texCache = &texCache;
+    m_dense.reserve(128);
+    m_denseToSlot.reserve(128);
+    return m_registry.init();
 }
 
-bool PbrMaterialManager::init() { m_pool.reserve(128); return true; }
+// 释放单个材质的 GPU 对象；缓存里的纹理、纹理数组组只减引用，共享对象（program/uniform）不归材质
+void PbrMaterialManager::releaseGpu(PbrMaterialGPU& m) {
+    for (TexRef r : { m.r_baseColor, m.r_mr, m.r_normal, m.r_ao, m.r_emissive })
+        if (r.valid()) m_texCache->release(r);
+    if (m.texArray >= 0 && m_arrays) m_arrays->release(m.texArray);
+    m = PbrMaterialGPU{};
+}
 
 void PbrMaterialManager::shutdown() {
-    for (auto& m : m_pool) {
-        if (bgfx::isValid(m.program)) bgfx::destroy(m.program);
-        if (bgfx::isValid(m.u_baseColorFactor)) bgfx::destroy(m.u_baseColorFactor);
-        if (bgfx::isValid(m.u_mrFactor))        bgfx::destroy(m.u_mrFactor);
-        if (bgfx::isValid(m.u_emissive))        bgfx::destroy(m.u_emissive);
-        if (bgfx::isValid(m.u_flags))           bgfx::destroy(m.u_flags);
-        if (bgfx::isValid(m.s_baseColor)) bgfx::destroy(m.s_baseColor);
-        if (bgfx::isValid(m.s_mr))        bgfx::destroy(m.s_mr);
-        if (bgfx::isValid(m.s_normal))    bgfx::destroy(m.s_normal);
-        if (bgfx::isValid(m.s_ao))        bgfx::destroy(m.s_ao);
-        if (bgfx::isValid(m.s_emissive))  bgfx::destroy(m.s_emissive);
-        if (bgfx::isValid(m.t_baseColor)) bgfx::destroy(m.t_baseColor);
-        if (bgfx::isValid(m.t_mr))        bgfx::destroy(m.t_mr);
-        if (bgfx::isValid(m.t_normal))    bgfx::destroy(m.t_normal);
-        if (bgfx::isValid(m.t_ao))        bgfx::destroy(m.t_ao);
-        if (bgfx::isValid(m.t_emissive))  bgfx::destroy(m.t_emissive);
-    }
-    m_pool.clear();
+    for (auto& m : m_dense) releaseGpu(m);
+    for (auto& p : m_graveyard) releaseGpu(p.gpu);
+    m_dense.clear();
+    m_denseToSlot.clear();
+    m_graveyard.clear();
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_arrays = nullptr;
+    m_registry.shutdown();
 }
 
 PbrMatHandle PbrMaterialManager::create(const PbrMaterialDesc& d) {
     PbrMaterialGPU m{};
-    // 常量/采样器（名字与 fs_pbr_mr.sc 对齐）
-    m.u_baseColorFactor = U("u_baseColorFactor", bgfx::UniformType::Vec4);
-    m.u_mrFactor        = U("u_mrFactor",        bgfx::UniformType::Vec4);
-    m.u_emissive        = U("u_emissive",        bgfx::UniformType::Vec4);
-    m.u_flags           = U("u_matFlags",        bgfx::UniformType::Vec4);
-    m.s_baseColor = U("s_baseColor", bgfx::UniformType::Sampler);
-    m.s_mr        = U("s_mr",        bgfx::UniformType::Sampler);
-    m.s_normal    = U("s_normal",    bgfx::UniformType::Sampler);
-    m.s_ao        = U("s_ao",        bgfx::UniformType::Sampler);
-    m.s_emissive  = U("s_emissive",  bgfx::UniformType::Sampler);
-
-    // 纹理（空路径 → 占位）
-    m.t_baseColor = d.texBaseColor.empty()         ? solid1x1(255,255,255,true) : loadTexCached(d.texBaseColor, true);
-    m.t_mr        = d.texMetallicRoughness.empty() ? solid1x1(255,255,255,false): loadTexCached(d.texMetallicRoughness, false);
-    m.t_normal    = d.texNormal.empty()            ? solid1x1(128,128,255,false): loadTexCached(d.texNormal, false);
-    m.t_ao        = d.texOcclusion.empty()         ? solid1x1(255,255,255,false): loadTexCached(d.texOcclusion, false);
-    m.t_emissive  = d.texEmissive.empty()          ? solid1x1(0,0,0,true)       : loadTexCached(d.texEmissive, true);
+    const PbrMaterialRegistry& R = m_registry;
+
+    // 纹理（空路径 → 默认纹理；有路径 → 先绑默认，解码在后台，syncTextures 里换上真纹理）
+    m.t_baseColor = loadTex(d.texBaseColor,         true,  m.r_baseColor, R.t_white);
+    m.t_mr        = loadTex(d.texMetallicRoughness, false, m.r_mr,        R.t_white);
+    m.t_normal    = loadTex(d.texNormal,            false, m.r_normal,    R.t_flatNormal);
+    m.t_ao        = loadTex(d.texOcclusion,         false, m.r_ao,        R.t_white);
+    m.t_emissive  = loadTex(d.texEmissive,          true,  m.r_emissive,  R.t_black);
 
     if (!d.texBaseColor.empty())        m.flags |= (1u<<0);
     if (!d.texMetallicRoughness.empty())m.flags |= (1u<<1);
@@ -57,36 +48,139 @@ PbrMatHandle PbrMaterialManager::create(const PbrMaterialDesc& d) {
     if (!d.texOcclusion.empty())        m.flags |= (1u<<3);
     if (!d.texEmissive.empty())         m.flags |= (1u<<4);
 
+    // 只为真正用到的特性付费：没有贴图的槽位不进着色器
+    if (!d.texMetallicRoughness.empty()) m.features |= PbrFeature_MrMap;
+    if (!d.texNormal.empty())            m.features |= PbrFeature_NormalMap;
+    if (!d.texEmissive.empty())          m.features |= PbrFeature_EmissiveMap;
+    if (d.twoSided)                      m.features |= PbrFeature_TwoSided;
+
+    const float params[16] = {
+        d.baseColorFactor.x, d.baseColorFactor.y, d.baseColorFactor.z, d.baseColorFactor.w,
+        d.metallic, d.roughness, float(m.flags), 0.0f,
+        d.emissive.x, d.emissive.y, d.emissive.z, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f,
+    };
+    std::copy(params, params + 16, m.params);
+
     m.state = d.twoSided
       ? BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS
       : BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_CULL_CW;
 
     // 先不绑定 Program（由 ForwardPBR 填充）
     m.program = BGFX_INVALID_HANDLE;
+    m.serial = ++m_serial;
+
+    uint32_t slot;
+    if (!m_freeSlots.empty()) { slot = m_freeSlots.back(); m_freeSlots.pop_back(); }
+    else { slot = (uint32_t)m_slots.size(); m_slots.emplace_back(); }
+    m_slots[slot].dense = (uint32_t)m_dense.size();
+    m_dense.push_back(m);
+    m_denseToSlot.push_back(slot);
+    return PbrMatHandle{ slot, m_slots[slot].generation };
+}
+void PbrMaterialManager::destroy(PbrMatHandle h) {
+    if (!isAlive(h)) return;
+    Slot& slot = m_slots[h.index];
+    const uint32_t d = slot.dense;
+
+    // GPU 资源先进墓地，等 kDestroyDelay 帧后再释放
+    m_graveyard.push_back({ m_dense[d], m_frame });
+
+    // 稠密数组：末尾元素挪进空位
+    const uint32_t last = (uint32_t)m_dense.size() - 1;
+    if (d != last) {
+        m_dense[d] = m_dense[last];
+        m_denseToSlot[d] = m_denseToSlot[last];
+        m_slots[m_denseToSlot[d]].dense = d;
+    }
+    m_dense.pop_back();
+    m_denseToSlot.pop_back();
+
+    slot.dense = UINT32_MAX;
+    if (++slot.generation == 0) slot.generation = 1; // 0 留给“从未有效”的句柄
+    m_freeSlots.push_back(h.index);
+}
+
+bool PbrMaterialManager::isAlive(PbrMatHandle h) const {
+    return h.index < m_slots.size()
+        && m_slots[h.index].generation == h.generation
+        && m_slots[h.index].dense != UINT32_MAX;
+}
 
-    PbrMatHandle h = (PbrMatHandle)m_pool.size();
-    m_pool.push_back(m);
+const PbrMaterialGPU* PbrMaterialManager::tryGet(PbrMatHandle h) const {
+    return isAlive(h) ? &m_dense[m_slots[h.index].dense] : nullptr;
+}
+
+const PbrMaterialGPU& PbrMaterialManager::get(PbrMatHandle h) const {
+    assert(isAlive(h) && "stale PbrMatHandle");
+    return m_dense[m_slots[h.index].dense];
+}
+
+PbrMatHandle PbrMaterialManager::handleAt(uint32_t i) const {
+    const uint32_t slot = m_denseToSlot[i];
+    return { slot, m_slots[slot].generation };
+}
+
+void PbrMaterialManager::collectGarbage() {
+    ++m_frame;
+    size_t keep = 0;
+    for (size_t i = 0; i < m_graveyard.size(); ++i) {
+        if (m_frame - m_graveyard[i].frame >= kDestroyDelay) releaseGpu(m_graveyard[i].gpu);
+        else m_graveyard[keep++] = m_graveyard[i];
+    }
+    m_graveyard.resize(keep);
+}
 
-    // 初值写一次（便于 debug）
-    float mr[4] = { d.metallic, d.roughness, 0, 0 };
-    bgfx::setUniform(m.u_baseColorFactor, &d.baseColorFactor[0]);
-    bgfx::setUniform(m.u_mrFactor, mr);
-    float em[4] = { d.emissive.x, d.emissive.y, d.emissive.z, 0 };
-    bgfx::setUniform(m.u_emissive, em);
-    return h;
+void PbrMaterialManager::bindTextureArray(PbrMatHandle h, int16_t group, const uint16_t layers[5]) {
+    if (!isAlive(h)) return;
+    PbrMaterialGPU& m = m_dense[m_slots[h.index].dense];
+    if (m.texArray == group) return;
+    if (m_arrays) {
+        m_arrays->addRef(group);
+        if (m.texArray >= 0) m_arrays->release(m.texArray);
+    }
+    bgfx::TextureHandle* t[5] = { &m.t_baseColor, &m.t_mr, &m.t_normal, &m.t_ao, &m.t_emissive };
+    TexRef*              r[5] = { &m.r_baseColor, &m.r_mr, &m.r_normal, &m.r_ao, &m.r_emissive };
+    for (uint32_t i = 0; i < 5; ++i) {
+        if (r[i]->valid()) m_texCache->release(*r[i]);
+        *r[i] = {};
+        *t[i] = BGFX_INVALID_HANDLE;
+        m.texLayers[i] = layers[i];
+    }
+    m.texArray = group;
+    // 层号写进常量块，绘制时随材质参数一起上传
+    m.params[12] = float(layers[0]);
+    m.params[13] = float(layers[1]);
+    m.params[14] = float(layers[2]);
+    m.params[15] = float(layers[3]);
+    m.params[7]  = float(layers[4]);
 }
-void PbrMaterialManager::destroy(PbrMatHandle) { /* 简化：暂不回收槽位 */ }
-
-bgfx::TextureHandle PbrMaterialManager::loadTexCached(const std::string& path, bool srgb) {
-    auto it = m_texCache.find(path);
-    if (it != m_texCache.end()) return it->second;
-    auto t = createTexture2DFromFile(path, srgb, 0); // 你现有的加载接口 :contentReference[oaicite:6]{index=6}
-    if (bgfx::isValid(t)) m_texCache[path] = t;
-    return t;
+
+void PbrMaterialManager::syncTextures() {
+    if (!m_texCache || m_texCache->generation() == m_texGen) return;
+    m_texGen = m_texCache->generation();
+    for (auto& m : m_dense) {
+        // 缓存里还没有可用句柄（解码中/失败）就继续用默认纹理
+        auto sync = [&](bgfx::TextureHandle& t, TexRef r) {
+            if (!r.valid()) return;
+            const bgfx::TextureHandle h = m_texCache->handle(r);
+            if (bgfx::isValid(h)) t = h;
+        };
+        sync(m.t_baseColor, m.r_baseColor);
+        sync(m.t_mr,        m.r_mr);
+        sync(m.t_normal,    m.r_normal);
+        sync(m.t_ao,        m.r_ao);
+        sync(m.t_emissive,  m.r_emissive);
+    }
 }
-bgfx::TextureHandle PbrMaterialManager::solid1x1(uint8_t r,uint8_t g,uint8_t b,bool srgb) {
-    // 复用你的 TextureLoader；也可改成手工内存贴图
-    std::vector<uint8_t> px = { r,g,b,255 };
-    const bgfx::Memory* mem = bgfx::copy(px.data(), 4);
-    return bgfx::createTexture2D(1,1,false,1,bgfx::TextureFormat::RGBA8,0,mem);
+
+bgfx::TextureHandle PbrMaterialManager::loadTex(const std::string& path, bool srgb, TexRef& outRef,
+                                                bgfx::TextureHandle fallback) {
+    outRef = {};
+    if (!path.empty()) {
+        outRef = m_texCache->acquireAsync(path, srgb, true, bgfx::TextureFormat::RGBA8, /*streamable*/true);
+        const bgfx::TextureHandle h = m_texCache->handle(outRef);
+        if (bgfx::isValid(h)) return h; // 命中已就绪的条目
+    }
+    return fallback;
 }
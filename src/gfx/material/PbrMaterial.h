@@ -3,11 +3,15 @@
 #include <glm/vec4.hpp>
 #include <glm/vec3.hpp>
 #include <string>
-#include <unordered_map>
 #include <vector>
+#include "gfx/resource/TextureCache.h"
+#include "PbrMaterialRegistry.h"
+#include "PbrPermutation.h"
 
 // 名称速记：Desc=CPU侧描述；GPU=GPU侧句柄集合；Manager=创建/缓存/销毁
 
+class TextureArrayPacker;
+
 struct PbrMaterialDesc {
     glm::vec4 baseColorFactor{1,1,1,1};
     float     metallic{1.0f};
@@ -19,48 +23,101 @@ struct PbrMaterialDesc {
 };
 
 struct PbrMaterialGPU {
-    bgfx::ProgramHandle program = BGFX_INVALID_HANDLE;
-
-    // 常量
-    bgfx::UniformHandle u_baseColorFactor = BGFX_INVALID_HANDLE; // vec4
-    bgfx::UniformHandle u_mrFactor        = BGFX_INVALID_HANDLE; // x=metallic y=roughness
-    bgfx::UniformHandle u_emissive        = BGFX_INVALID_HANDLE; // vec3
-    bgfx::UniformHandle u_flags           = BGFX_INVALID_HANDLE; // bit 标志
-
-    // 采样器
-    bgfx::UniformHandle s_baseColor = BGFX_INVALID_HANDLE;
-    bgfx::UniformHandle s_mr        = BGFX_INVALID_HANDLE;
-    bgfx::UniformHandle s_normal    = BGFX_INVALID_HANDLE;
-    bgfx::UniformHandle s_ao        = BGFX_INVALID_HANDLE;
-    bgfx::UniformHandle s_emissive  = BGFX_INVALID_HANDLE;
-
-    // 纹理对象
+    bgfx::ProgramHandle program = BGFX_INVALID_HANDLE; // 借用 ForwardPBR 的共享 program，不归材质所有
+    // uniform/sampler 句柄见 PbrMaterialRegistry（全部材质共用）
+
+    // 纹理对象（缺贴图/未就绪时指向 registry 的默认纹理，不归材质所有）
     bgfx::TextureHandle t_baseColor = BGFX_INVALID_HANDLE;
     bgfx::TextureHandle t_mr        = BGFX_INVALID_HANDLE;
     bgfx::TextureHandle t_normal    = BGFX_INVALID_HANDLE;
     bgfx::TextureHandle t_ao        = BGFX_INVALID_HANDLE;
     bgfx::TextureHandle t_emissive  = BGFX_INVALID_HANDLE;
 
+    // 纹理缓存引用（无贴图时无效）
+    TexRef r_baseColor, r_mr, r_normal, r_ao, r_emissive;
+
+    // 纹理数组打包（TextureArrayPacker）：>=0 时 t_* 不再使用，改绑该组数组 + 层号
+    int16_t  texArray = -1;
+    uint16_t texLayers[5] = { 0, 0, 0, 0, 0 }; // 顺序同 flags 位
+
+    // 材质常量块（u_material[4]），draw 时一次 setUniform 上传：
+    // [0] baseColorFactor  [1] metallic, roughness, flags, emissive 层号
+    // [2] emissive.rgb, 0  [3] 层号 baseColor, mr, normal, ao（纹理数组路径）
+    float params[16] = { 1,1,1,1,  1,1,0,0,  0,0,0,0,  0,0,0,0 };
+
     uint64_t state = 0;
     uint32_t flags = 0; // bit0:baseColor bit1:mr bit2:normal bit3:ao bit4:emissive
+    uint32_t features = 0; // 着色器排列位（PbrFeature_*，只含材质自身决定的部分）
+    uint32_t serial = 0; // 创建序号（单调递增），供“只处理新材质”的系统使用
     bool valid() const { return bgfx::isValid(program); }
 };
 
-using PbrMatHandle = uint16_t;
+// 代际句柄：index 指向槽位，generation 不符即为过期句柄（材质已销毁、槽位已复用）
+struct PbrMatHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+    bool valid() const { return index != UINT32_MAX; }
+    bool operator==(const PbrMatHandle& o) const { return index == o.index && generation == o.generation; }
+    bool operator!=(const PbrMatHandle& o) const { return !(*this == o); }
+};
 
 class PbrMaterialManager {
 public:
-    bool init();
+    bool init(TextureCache& texCache);
     void shutdown();
 
     PbrMatHandle create(const PbrMaterialDesc& d);
-    const PbrMaterialGPU& get(PbrMatHandle h) const { return m_pool[h]; }
-    void destroy(PbrMatHandle h);
+    void destroy(PbrMatHandle h); // 立即失效并回收槽位；GPU 资源延迟 kDestroyDelay 帧释放
+
+    bool isAlive(PbrMatHandle h) const;
+    const PbrMaterialGPU* tryGet(PbrMatHandle h) const; // 过期句柄返回 nullptr
+    const PbrMaterialGPU& get(PbrMatHandle h) const;    // 须为有效句柄
+
+    // 稠密遍历：[0, count()) 连续存放所有存活材质（销毁时与末尾交换，顺序不稳定）
+    uint32_t count() const { return (uint32_t)m_dense.size(); }
+    const PbrMaterialGPU& at(uint32_t i) const { return m_dense[i]; }
+    PbrMatHandle handleAt(uint32_t i) const;
+
+    // 每帧调用一次：释放已过延迟期的销毁材质
+    void collectGarbage();
+
+    const PbrMaterialRegistry& registry() const { return m_registry; }
+
+    // 设置后，材质绑上 / 释放时给所在的纹理数组组加减引用（组归零即销毁）
+    void setTextureArrays(TextureArrayPacker* arrays) { m_arrays = arrays; }
+    // 材质改用纹理数组：归还各自的缓存引用，持有该组一份引用
+    void bindTextureArray(PbrMatHandle h, int16_t group, const uint16_t layers[5]);
+
+    // 纹理缓存换过句柄（异步解码完成/流送替换）后，重新解析材质里的 t_*；每帧绘制前调用
+    void syncTextures();
 
 private:
-    std::vector<PbrMaterialGPU> m_pool;
-    std::unordered_map<std::string, bgfx::TextureHandle> m_texCache;
+    static constexpr uint32_t kDestroyDelay = 3; // 帧；覆盖仍在途的 draw
+
+    struct Slot {
+        uint32_t generation = 1;
+        uint32_t dense = UINT32_MAX; // m_dense 下标；UINT32_MAX = 空闲
+    };
+    struct Pending {
+        PbrMaterialGPU gpu;
+        uint32_t frame = 0; // 销毁时的帧号
+    };
+
+    std::vector<Slot>           m_slots;
+    std::vector<uint32_t>       m_freeSlots;
+    std::vector<PbrMaterialGPU> m_dense;       // 参数/句柄连续存放，便于遍历
+    std::vector<uint32_t>       m_denseToSlot; // 与 m_dense 一一对应
+    std::vector<Pending>        m_graveyard;   // 等待释放 GPU 资源
+    uint32_t m_frame = 0;
+    uint32_t m_serial = 0;
+
+    PbrMaterialRegistry m_registry;     // 共享 uniform/sampler + 默认纹理
+    TextureCache* m_texCache = nullptr; // 引擎级纹理缓存（ResourceCache 持有）
+    TextureArrayPacker* m_arrays = nullptr;
+    uint32_t      m_texGen = 0;         // 上次同步时的 TextureCache::generation()
 
-    bgfx::TextureHandle loadTexCached(const std::string& path, bool srgb);
-    bgfx::TextureHandle solid1x1(uint8_t r, uint8_t g, uint8_t b, bool srgb);
+    // 有路径：向缓存异步请求并记下引用；真纹理就绪前（或无路径/失败）返回 fallback
+    bgfx::TextureHandle loadTex(const std::string& path, bool srgb, TexRef& outRef,
+                                bgfx::TextureHandle fallback);
+    void releaseGpu(PbrMaterialGPU& m);
 };
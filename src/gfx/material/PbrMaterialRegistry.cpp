@@ -0,0 +1,39 @@
+#include "PbrMaterialRegistry.h"
+#include <cassert>
+#include <initializer_list>
+
+static bgfx::UniformHandle U(const char* n, bgfx::UniformType::Enum t, uint16_t num = 1) {
+    auto u = bgfx::createUniform(n, t, num);
+    assert(bgfx::isValid(u) && "createUniform failed");
+    return u;
+}
+
+static bgfx::TextureHandle solid1x1(uint8_t r, uint8_t g, uint8_t b) {
+    const uint8_t px[4] = { r, g, b, 255 };
+    return bgfx::createTexture2D(1, 1, false, 1, bgfx::TextureFormat::RGBA8, BGFX_TEXTURE_NONE, bgfx::copy(px, 4));
+}
+
+bool PbrMaterialRegistry::init() {
+    u_material  = U("u_material",  bgfx::UniformType::Vec4, kMaterialVec4);
+    s_baseColor = U("s_baseColor", bgfx::UniformType::Sampler);
+    s_mr        = U("s_mr",        bgfx::UniformType::Sampler);
+    s_normal    = U("s_normal",    bgfx::UniformType::Sampler);
+    s_ao        = U("s_ao",        bgfx::UniformType::Sampler);
+    s_emissive  = U("s_emissive",  bgfx::UniformType::Sampler);
+
+    t_white      = solid1x1(255, 255, 255);
+    t_black      = solid1x1(0, 0, 0);
+    t_flatNormal = solid1x1(128, 128, 255);
+    return bgfx::isValid(t_white) && bgfx::isValid(t_black) && bgfx::isValid(t_flatNormal);
+}
+
+void PbrMaterialRegistry::shutdown() {
+    for (bgfx::UniformHandle* u : { &u_material, &s_baseColor, &s_mr, &s_normal, &s_ao, &s_emissive }) {
+        if (bgfx::isValid(*u)) bgfx::destroy(*u);
+        *u = BGFX_INVALID_HANDLE;
+    }
+    for (bgfx::TextureHandle* t : { &t_white, &t_black, &t_flatNormal }) {
+        if (bgfx::isValid(*t)) bgfx::destroy(*t);
+        *t = BGFX_INVALID_HANDLE;
+    }
+}
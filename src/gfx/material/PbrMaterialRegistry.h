@@ -0,0 +1,28 @@
+#pragma once
+#include <bgfx/bgfx.h>
+
+// 名称速记：PbrMaterialRegistry = 所有 PBR 材质共享的 GPU 对象
+// - uniform/sampler 句柄（名字与 fs_pbr_mr.sc 对齐）：全局只建一份
+// - 默认纹理：white / black / flatNormal 各一张 1x1，材质缺贴图或贴图未就绪时引用它们
+// 材质只引用、不拥有这些对象；由 PbrMaterialManager 持有并统一销毁
+
+struct PbrMaterialRegistry {
+    // 常量：材质参数打包成 4 个 vec4，布局见 PbrMaterialGPU::params / pbr_common.sh
+    static constexpr uint16_t kMaterialVec4 = 4;
+    bgfx::UniformHandle u_material = BGFX_INVALID_HANDLE;
+
+    // 采样器
+    bgfx::UniformHandle s_baseColor = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_mr        = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_normal    = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_ao        = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle s_emissive  = BGFX_INVALID_HANDLE;
+
+    // 默认纹理（白/黑在 sRGB 与线性下数值相同，共用即可）
+    bgfx::TextureHandle t_white      = BGFX_INVALID_HANDLE;
+    bgfx::TextureHandle t_black      = BGFX_INVALID_HANDLE;
+    bgfx::TextureHandle t_flatNormal = BGFX_INVALID_HANDLE; // (0.5, 0.5, 1)
+
+    bool init();
+    void shutdown();
+};
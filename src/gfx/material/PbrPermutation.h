@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+
+// 名称速记：PbrPermutation = fs_pbr_mr 的特性位（--define 开关）
+// - 位顺序须与 CMakeLists.txt 的 PBR_PERM_DEFINES、fs_pbr_mr.sc 顶部注释一致
+// - 每个键对应一个预编译的 fs_pbr_mr_pXX.bin（XX = 至少两位的小写十六进制；带光表档位时是三位，如 p13f；
+//   见 ProgramRegistry::permutationFile 与 CMakeLists.txt 的排列循环）
+enum PbrFeature : uint32_t {
+    PbrFeature_MrMap       = 1u << 0, // PBR_MR_MAP：采样 metallic/roughness 贴图
+    PbrFeature_NormalMap   = 1u << 1, // PBR_NORMAL_MAP：法线贴图（导数重建切线空间）
+    PbrFeature_EmissiveMap = 1u << 2, // PBR_EMISSIVE_MAP：自发光贴图
+    PbrFeature_Clustered   = 1u << 3, // PBR_CLUSTERED：分簇点光/聚光（由 ClusteredLighting 是否有光决定）
+    PbrFeature_TwoSided    = 1u << 4, // PBR_TWO_SIDED：背面翻转法线
+    PbrFeature_TexArray    = 1u << 5, // PBR_TEX_ARRAY：纹理数组路径（由打包结果决定）
+
+    PbrFeature_Count       = 1u << 6, // 排列总数
+};
+
+// 逐物体光表的盏数档位，放在特性位之上（bit6..8）：档位 t → PBR_OBJECT_LIGHTS = 0/1/2/4/8
+// 只在非分簇排列上有意义（PBR_CLUSTERED 与档位 > 0 不会同时编译）
+constexpr uint32_t kPbrLightTierShift = 6;
+constexpr uint32_t kPbrLightTiers     = 5;
+constexpr uint32_t kPbrPermutationCount = kPbrLightTiers << kPbrLightTierShift; // 完整排列键的取值范围
+
+constexpr uint32_t pbrLightTierCount(uint32_t tier) { return tier == 0 ? 0u : 1u << (tier - 1); }
+constexpr uint32_t pbrLightTierFor(uint32_t lights) {
+    return lights == 0 ? 0u : lights == 1 ? 1u : lights == 2 ? 2u : lights <= 4 ? 3u : 4u;
+}
+
+// 材质自身能决定的位（其余位在 draw 时按场景状态补上）
+constexpr uint32_t kPbrMaterialFeatureMask =
+    PbrFeature_MrMap | PbrFeature_NormalMap | PbrFeature_EmissiveMap | PbrFeature_TwoSided;
+
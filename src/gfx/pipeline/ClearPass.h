@@ -1,9 +1,11 @@
 #pragma once
 
 #include "RenderPass.h"   // 依赖 RenderPass/RenderContext
+#include "RenderGraph.h"  // RGResource / RenderGraphBuilder
 #include <array>          // std::array 固定大小数组（栈上、无额外分配）
 
 // ClearPass：只负责设置 view 的清屏颜色/深度/模板并“touch”一次 view。
+// 放进 RenderGraph 时先 setTargets：作为这些目标本帧的第一个写者，后面的通道就不用再各自清屏。
 class ClearPass final : public RenderPass {
 public:
     // explicit：防止单参数构造发生隐式转换
@@ -15,6 +17,10 @@ public:
           m_clearStencil(clearStencil)
     {}
 
+    // 渲染图里要清的目标（颜色与深度可以是同一个资源，如后台缓冲）
+    void setTargets(RGResource color, RGResource depth) { m_color = color; m_depth = depth; }
+    void setup(RenderGraphBuilder& b) override { b.write(m_color); b.write(m_depth); }
+
     // 准备阶段对本 Pass 来说什么都不做
     void prepare(const RenderContext& /*rc*/) override {}
 
@@ -25,4 +31,5 @@ private:
     std::array<float, 4> m_clearRGBA;   // 清屏颜色
     float   m_clearDepth;               // 清屏深度（1.0 表示最远）
     uint8_t m_clearStencil;             // 清屏模板
+    RGResource m_color, m_depth;        // 渲染图里的目标
 };
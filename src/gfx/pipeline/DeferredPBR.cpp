@@ -0,0 +1,184 @@
+#include "DeferredPBR.h"
+#include "ForwardPBR.h"
+#include "gfx/material/PbrMaterial.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <initializer_list>
+
+// 依次取第一个能当渲染目标、又能被采样的格式
+static bgfx::TextureFormat::Enum pickFormat(const bgfx::Caps* caps, std::initializer_list<bgfx::TextureFormat::Enum> list) {
+    const uint16_t need = BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER | BGFX_CAPS_FORMAT_TEXTURE_2D;
+    for (bgfx::TextureFormat::Enum f : list)
+        if ((caps->formats[f] & need) == need) return f;
+    return bgfx::TextureFormat::Count;
+}
+
+bool DeferredPBR::init(ProgramRegistry& programs, ForwardPBR& forward) {
+    m_registry = &programs;
+    m_forward = &forward;
+    m_registryGen = programs.generation();
+    m_supported = false;
+
+    const bgfx::Caps* caps = bgfx::getCaps();
+    if (!caps || caps->limits.maxFBAttachments < 3) {
+        spdlog::warn("[Deferred] needs 3 color attachments, deferred path disabled");
+        return false;
+    }
+    m_formats[kAlbedo]   = pickFormat(caps, { bgfx::TextureFormat::RGBA8 });
+    m_formats[kNormal]   = pickFormat(caps, { bgfx::TextureFormat::RGB10A2, bgfx::TextureFormat::RGBA16F, bgfx::TextureFormat::RGBA8 });
+    m_formats[kEmissive] = pickFormat(caps, { bgfx::TextureFormat::RG11B10F, bgfx::TextureFormat::RGBA16F, bgfx::TextureFormat::RGBA8 });
+    m_formats[kDepth]    = pickFormat(caps, { bgfx::TextureFormat::D32F, bgfx::TextureFormat::D24S8, bgfx::TextureFormat::D24 });
+    for (bgfx::TextureFormat::Enum f : m_formats) {
+        if (f == bgfx::TextureFormat::Count) {
+            spdlog::warn("[Deferred] no usable G-buffer format, deferred path disabled");
+            return false;
+        }
+    }
+
+    m_lightPrograms[0] = programs.acquire("vs_fullscreen.bin", "fs_deferred_light", 0);
+    m_lightPrograms[1] = programs.acquire("vs_fullscreen.bin", "fs_deferred_light", PbrFeature_Clustered);
+    if (!m_lightPrograms[0].valid() || !bgfx::isValid(gbufferProgram(0))) {
+        spdlog::warn("[Deferred] shaders missing, deferred path disabled");
+        shutdown();
+        return false;
+    }
+
+    s_targets[kAlbedo]   = bgfx::createUniform("s_gbAlbedo",   bgfx::UniformType::Sampler);
+    s_targets[kNormal]   = bgfx::createUniform("s_gbNormal",   bgfx::UniformType::Sampler);
+    s_targets[kEmissive] = bgfx::createUniform("s_gbEmissive", bgfx::UniformType::Sampler);
+    s_targets[kDepth]    = bgfx::createUniform("s_gbDepth",    bgfx::UniformType::Sampler);
+    u_deferred           = bgfx::createUniform("u_deferred",   bgfx::UniformType::Vec4);
+
+    // 盖住整个屏幕的单个三角形（裁剪空间坐标，vs_fullscreen 直接输出）
+    static const float kTriangle[] = { -1.0f, -1.0f, 0.0f,   3.0f, -1.0f, 0.0f,   -1.0f, 3.0f, 0.0f };
+    bgfx::VertexLayout layout;
+    layout.begin().add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float).end();
+    m_triangle = bgfx::createVertexBuffer(bgfx::makeRef(kTriangle, sizeof(kTriangle)), layout);
+
+    m_supported = bgfx::isValid(m_triangle);
+    if (!m_supported) {
+        shutdown();
+        return false;
+    }
+    spdlog::info("[Deferred] G-buffer formats: {} {} {} {}",
+                 int(m_formats[0]), int(m_formats[1]), int(m_formats[2]), int(m_formats[3]));
+    return true;
+}
+
+void DeferredPBR::shutdown() {
+    if (m_registry) {
+        for (uint32_t i = 0; i < PbrFeature_Count; ++i) m_registry->release(m_gbPrograms[i]);
+        for (ProgramRef& r : m_lightPrograms) m_registry->release(r);
+    }
+    for (uint32_t i = 0; i < PbrFeature_Count; ++i) {
+        m_gbPrograms[i] = {};
+        m_gbTried[i] = false;
+    }
+    for (ProgramRef& r : m_lightPrograms) r = {};
+    if (bgfx::isValid(m_triangle)) bgfx::destroy(m_triangle);
+    m_triangle = BGFX_INVALID_HANDLE;
+    for (bgfx::UniformHandle* u : { &s_targets[0], &s_targets[1], &s_targets[2], &s_targets[3], &u_deferred }) {
+        if (bgfx::isValid(*u)) bgfx::destroy(*u);
+        *u = BGFX_INVALID_HANDLE;
+    }
+    m_registry = nullptr;
+    m_forward = nullptr;
+    m_supported = false;
+    m_stats = {};
+}
+
+bgfx::ProgramHandle DeferredPBR::gbufferProgram(uint32_t mask) {
+    if (!m_registry || mask >= PbrFeature_Count) return BGFX_INVALID_HANDLE;
+    if (m_registryGen != m_registry->generation()) {
+        m_registryGen = m_registry->generation();
+        for (uint32_t i = 0; i < PbrFeature_Count; ++i)
+            if (!m_gbPrograms[i].valid()) m_gbTried[i] = false;
+    }
+    if (!m_gbTried[mask]) {
+        m_gbTried[mask] = true;
+        m_gbPrograms[mask] = m_registry->acquire("vs_pbr.bin", "fs_pbr_gb", mask);
+        if (!m_gbPrograms[mask].valid())
+            spdlog::error("[Deferred] G-buffer permutation 0x{:02x} missing, draws using it are skipped", mask);
+    }
+    return m_registry->handle(m_gbPrograms[mask]);
+}
+
+void DeferredPBR::addPasses(RenderGraph& graph, RGResource color, RGResource depth, const uint16_t rect[4],
+                            RGResource shadowAtlas) {
+    m_stats = {};
+    m_gbufferId = m_lightingId = RenderGraph::kInvalidPass;
+    if (!m_supported) return;
+
+    static const char* kNames[kTargets] = { "GBuffer.Albedo", "GBuffer.Normal", "GBuffer.Emissive", "GBuffer.Depth" };
+    for (uint32_t i = 0; i < kTargets; ++i) {
+        RGTextureDesc d;
+        d.format = m_formats[i];
+        d.flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_POINT | BGFX_SAMPLER_UVW_CLAMP;
+        m_gb[i] = graph.createTexture(kNames[i], d);
+    }
+    m_color = color;
+    m_depth = depth;
+    m_shadowAtlas = shadowAtlas;
+    std::copy(rect, rect + 4, m_rect);
+    m_gbufferId = graph.addPass("G-buffer", m_gbufferPass);
+    m_lightingId = graph.addPass("Deferred lighting", m_lightingPass);
+}
+
+void DeferredPBR::GBufferPass::setup(RenderGraphBuilder& b) {
+    for (RGResource r : m_owner.m_gb) b.write(r);
+    b.viewRect(m_owner.m_rect[0], m_owner.m_rect[1], m_owner.m_rect[2], m_owner.m_rect[3]);
+}
+
+void DeferredPBR::GBufferPass::execute(const RenderContext& rc) {
+    DeferredPBR& o = m_owner;
+    bgfx::setViewTransform(rc.view, rc.viewMatrix, rc.projMatrix);
+    bgfx::setViewClear(rc.view, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0, 1.0f, 0);
+
+    for (const DrawItem& item : rc.drawList) {
+        const PbrMaterialGPU* mat = item.material;
+        bgfx::ProgramHandle p = BGFX_INVALID_HANDLE;
+        if (mat) p = o.gbufferProgram(o.m_forward->materialMask(*mat));
+        if (!bgfx::isValid(p)) { ++o.m_stats.skipped; continue; }
+
+        bgfx::setTransform(item.model);
+        bgfx::setVertexBuffer(0, item.vbh);
+        if (bgfx::isValid(item.ibh)) bgfx::setIndexBuffer(item.ibh);
+        bgfx::setState(mat->state | BGFX_STATE_WRITE_A); // RT0.a 存金属度
+        o.m_forward->bindMaterial(*mat);
+        bgfx::submit(rc.view, p);
+        ++o.m_stats.draws;
+    }
+}
+
+void DeferredPBR::LightingPass::setup(RenderGraphBuilder& b) {
+    for (RGResource r : m_owner.m_gb) b.read(r);
+    b.read(m_owner.m_shadowAtlas);
+    b.write(m_owner.m_color);
+    b.write(m_owner.m_depth);
+    b.viewRect(m_owner.m_rect[0], m_owner.m_rect[1], m_owner.m_rect[2], m_owner.m_rect[3]);
+}
+
+void DeferredPBR::LightingPass::execute(const RenderContext& rc) {
+    DeferredPBR& o = m_owner;
+    bgfx::setViewTransform(rc.view, rc.viewMatrix, rc.projMatrix); // u_invViewProj 重建世界坐标
+
+    // 本帧没有可见局部光（或分簇排列缺失）时退回只有方向光的排列
+    bgfx::ProgramHandle lp = BGFX_INVALID_HANDLE;
+    if (o.m_forward->clusteredActive()) lp = o.m_registry->handle(o.m_lightPrograms[1]);
+    if (!bgfx::isValid(lp)) lp = o.m_registry->handle(o.m_lightPrograms[0]);
+    if (!bgfx::isValid(lp) || !rc.graph) return;
+
+    // G-buffer 纹理与后台缓冲同尺寸（BackbufferRatio::Equal）
+    const bgfx::Caps* caps = bgfx::getCaps();
+    const bgfx::Stats* st = bgfx::getStats();
+    const float params[4] = { caps->originBottomLeft ? 1.0f : 0.0f, caps->homogeneousDepth ? 1.0f : 0.0f,
+                              1.0f / float(std::max<uint16_t>(st->width, 1)), 1.0f / float(std::max<uint16_t>(st->height, 1)) };
+    bgfx::setUniform(o.u_deferred, params);
+    for (uint8_t i = 0; i < kTargets; ++i)
+        bgfx::setTexture(i, o.s_targets[i], rc.graph->texture(o.m_gb[i]));
+    o.m_forward->bindLighting();
+    bgfx::setVertexBuffer(0, o.m_triangle);
+    // 写回深度：之后的叠加通道（网格线等）照常做深度测试
+    bgfx::setState(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_ALWAYS);
+    bgfx::submit(rc.view, lp);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "RenderPass.h"
+#include "RenderGraph.h"
+#include <bgfx/bgfx.h>
+#include "gfx/material/PbrPermutation.h"
+#include "gfx/shaders/ProgramRegistry.h"
+
+class ForwardPBR;
+
+// 名称速记：DeferredPBR = 延迟着色管线，和 ForwardPBR 二选一（Renderer::setDeferredShading）
+// - G-buffer 通道：fs_pbr_mr 的 PBR_GBUFFER 变体写 3 个 MRT + 深度（各目标的打包见 fs_pbr_mr.sc 末尾）
+// - 光照通道：一个全屏三角形，每像素一次 pbrShade；点光/聚光查 ClusteredLighting 的簇表，
+//   开销只与像素数 × 每簇光数有关，与 draw 数 / 重叠深度无关
+// - 材质与光照绑定借用 ForwardPBR（bindMaterial / bindLighting），两条路径的着色一致
+// - 两个通道都是 RenderPass，经 addPasses 挂进 RenderGraph：G-buffer 4 张是渲染图的临时目标
+//   （BackbufferRatio::Equal，不用延迟路径时归还给池），view 由渲染图分配
+// - rect 可只用目标的一角（动态分辨率），G-buffer 与光照通道用同一个
+class DeferredPBR {
+public:
+    struct Stats {
+        uint32_t draws   = 0; // 写入 G-buffer 的 draw
+        uint32_t skipped = 0; // 没有材质 / 缺排列而跳过的条目
+    };
+
+    DeferredPBR() : m_gbufferPass(*this), m_lightingPass(*this) {}
+
+    bool init(ProgramRegistry& programs, ForwardPBR& forward);
+    void shutdown();
+
+    bool supported() const { return m_supported; }
+
+    // G-buffer（画 rc.drawList，条目须带 material）→ 光照（写 color/depth，不清屏）；rc 须带相机矩阵
+    // shadowAtlas：光照要采样的阴影图集（可无效），声明成读取以排在阴影通道之后
+    void addPasses(RenderGraph& graph, RGResource color, RGResource depth, const uint16_t rect[4],
+                   RGResource shadowAtlas = {});
+    RenderGraph::PassId gbufferPassId() const { return m_gbufferId; }
+    RenderGraph::PassId lightingPassId() const { return m_lightingId; }
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    enum { kAlbedo, kNormal, kEmissive, kDepth, kTargets };
+
+    class GBufferPass final : public RenderPass {
+    public:
+        explicit GBufferPass(DeferredPBR& o) : m_owner(o) {}
+        void setup(RenderGraphBuilder& b) override;
+        void execute(const RenderContext& rc) override;
+    private:
+        DeferredPBR& m_owner;
+    };
+    class LightingPass final : public RenderPass {
+    public:
+        explicit LightingPass(DeferredPBR& o) : m_owner(o) {}
+        void setup(RenderGraphBuilder& b) override;
+        void execute(const RenderContext& rc) override;
+    private:
+        DeferredPBR& m_owner;
+    };
+
+    bgfx::ProgramHandle gbufferProgram(uint32_t mask);
+
+    ProgramRegistry* m_registry = nullptr;
+    ForwardPBR*      m_forward = nullptr;
+    ProgramRef       m_gbPrograms[PbrFeature_Count];
+    bool             m_gbTried[PbrFeature_Count] = {};
+    uint32_t         m_registryGen = 0;
+    ProgramRef       m_lightPrograms[2]; // [0] 只有方向光  [1] 带分簇光
+
+    bgfx::TextureFormat::Enum m_formats[kTargets] = {};
+    bgfx::VertexBufferHandle m_triangle = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle     s_targets[kTargets] = { BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE,
+                                                    BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE };
+    bgfx::UniformHandle     u_deferred = BGFX_INVALID_HANDLE;
+
+    // 本帧渲染图里的资源（addPasses 时填）
+    GBufferPass  m_gbufferPass;
+    LightingPass m_lightingPass;
+    RGResource   m_gb[kTargets];
+    RGResource   m_color, m_depth, m_shadowAtlas;
+    uint16_t     m_rect[4] = {};
+    RenderGraph::PassId m_gbufferId = RenderGraph::kInvalidPass;
+    RenderGraph::PassId m_lightingId = RenderGraph::kInvalidPass;
+
+    bool  m_supported = false;
+    Stats m_stats;
+};
@@ -0,0 +1,142 @@
+#include "DynamicResolution.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+bool DynamicResolution::init(ProgramRegistry& programs) {
+    m_registry = &programs;
+    m_supported = false;
+
+    const bgfx::Caps* caps = bgfx::getCaps();
+    const uint16_t need = BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER;
+    if (!caps || (caps->formats[bgfx::TextureFormat::RGBA8] & (need | BGFX_CAPS_FORMAT_TEXTURE_2D)) != (need | BGFX_CAPS_FORMAT_TEXTURE_2D)) {
+        spdlog::warn("[DynRes] RGBA8 render target unsupported, dynamic resolution disabled");
+        return false;
+    }
+    for (bgfx::TextureFormat::Enum f : { bgfx::TextureFormat::D24S8, bgfx::TextureFormat::D32F, bgfx::TextureFormat::D24 }) {
+        if (caps->formats[f] & need) { m_depthFormat = f; break; }
+    }
+    if (m_depthFormat == bgfx::TextureFormat::Count) {
+        spdlog::warn("[DynRes] no depth render target format, dynamic resolution disabled");
+        return false;
+    }
+
+    m_program = programs.acquire("vs_fullscreen.bin", "fs_upscale.bin");
+    if (!m_program.valid()) {
+        spdlog::warn("[DynRes] upscale shader missing, dynamic resolution disabled");
+        shutdown();
+        return false;
+    }
+    s_scene   = bgfx::createUniform("s_scene",   bgfx::UniformType::Sampler);
+    u_upscale = bgfx::createUniform("u_upscale", bgfx::UniformType::Vec4);
+
+    static const float kTriangle[] = { -1.0f, -1.0f, 0.0f,   3.0f, -1.0f, 0.0f,   -1.0f, 3.0f, 0.0f };
+    bgfx::VertexLayout layout;
+    layout.begin().add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float).end();
+    m_triangle = bgfx::createVertexBuffer(bgfx::makeRef(kTriangle, sizeof(kTriangle)), layout);
+
+    m_supported = bgfx::isValid(m_triangle);
+    return m_supported;
+}
+
+void DynamicResolution::shutdown() {
+    if (m_registry) m_registry->release(m_program);
+    m_program = {};
+    if (bgfx::isValid(m_triangle)) bgfx::destroy(m_triangle);
+    m_triangle = BGFX_INVALID_HANDLE;
+    for (bgfx::UniformHandle* u : { &s_scene, &u_upscale }) {
+        if (bgfx::isValid(*u)) bgfx::destroy(*u);
+        *u = BGFX_INVALID_HANDLE;
+    }
+    m_registry = nullptr;
+    m_supported = m_enabled = m_active = false;
+    m_scale = 1.0f;
+    m_cooldown = 0;
+    m_stats = {};
+}
+
+void DynamicResolution::update(uint16_t width, uint16_t height) {
+    m_fullW = width;
+    m_fullH = height;
+
+    // 上一帧 GPU 耗时：不含 vsync 等待，能看出余量
+    const bgfx::Stats* st = bgfx::getStats();
+    const bool timed = st && st->gpuTimerFreq > 0 && st->gpuTimeEnd > st->gpuTimeBegin;
+    if (timed) {
+        const float f = float(double(st->gpuTimeEnd - st->gpuTimeBegin) * 1000.0 / double(st->gpuTimerFreq));
+        m_stats.frameMs = (m_stats.frameMs > 0.0f) ? m_stats.frameMs + (f - m_stats.frameMs) * 0.15f : f;
+    }
+    m_stats.gpuTimed = timed;
+
+    if (!m_enabled) {
+        m_scale = 1.0f;
+        m_cooldown = 0;
+    } else if (!timed) {
+        // 没有 GPU 计时：保持当前比例
+    } else if (m_cooldown > 0) {
+        --m_cooldown;
+    } else if (m_stats.frameMs > 0.0f) {
+        float next = m_scale;
+        if (m_stats.frameMs > m_targetMs)
+            next = std::max(m_scale * std::sqrt(m_targetMs / m_stats.frameMs), m_scale - kMaxDrop);
+        else if (m_stats.frameMs < m_targetMs * kHeadroom)
+            next = m_scale + kGrowStep;
+        next = std::round(std::clamp(next, m_minScale, 1.0f) * 64.0f) / 64.0f; // 按 1/64 量化，避免抖动
+        if (next != m_scale) {
+            m_scale = next;
+            m_cooldown = kSettleFrames;
+            ++m_stats.changes;
+        }
+    }
+
+    m_active = m_enabled && m_scale < 1.0f;
+    const float s = m_active ? m_scale : 1.0f;
+    m_stats.scale = s;
+    m_stats.width = uint16_t(std::max(1.0f, std::round(float(width) * s)));
+    m_stats.height = uint16_t(std::max(1.0f, std::round(float(height) * s)));
+}
+
+void DynamicResolution::viewRect(uint16_t rect[4]) const {
+    rect[0] = 0;
+    // GL 系（原点左下）bgfx 会把 rect 上下翻转；放在底部才让 gl_FragCoord 与纹理 uv 都从 0 起
+    rect[1] = (m_active && bgfx::getCaps()->originBottomLeft) ? uint16_t(m_fullH - m_stats.height) : 0;
+    rect[2] = m_stats.width;
+    rect[3] = m_stats.height;
+}
+
+RGTextureDesc DynamicResolution::colorDesc() const {
+    RGTextureDesc d;
+    d.format = bgfx::TextureFormat::RGBA8;
+    d.flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_UVW_CLAMP; // 放大时双线性
+    return d;
+}
+
+RGTextureDesc DynamicResolution::depthDesc() const {
+    RGTextureDesc d;
+    d.format = m_depthFormat;
+    d.flags = BGFX_TEXTURE_RT_WRITE_ONLY;
+    return d;
+}
+
+RenderGraph::PassId DynamicResolution::addUpscalePass(RenderGraph& graph, RGResource scene, RGResource backbuffer) {
+    if (!m_active || !m_registry) return RenderGraph::kInvalidPass;
+    return graph.addPass("Upscale",
+        [=](RenderGraphBuilder& b) {
+            b.read(scene);
+            b.write(backbuffer);
+        },
+        [this, scene](const RenderContext& rc) {
+            const bgfx::ProgramHandle p = m_registry->handle(m_program);
+            if (!bgfx::isValid(p)) return;
+            // xy：场景区域占整张纹理的比例；zw：uv 上限，收进半个 texel 免得双线性混进区域外的旧像素
+            const float params[4] = {
+                float(m_stats.width) / float(m_fullW), float(m_stats.height) / float(m_fullH),
+                (float(m_stats.width) - 0.5f) / float(m_fullW), (float(m_stats.height) - 0.5f) / float(m_fullH),
+            };
+            bgfx::setUniform(u_upscale, params);
+            bgfx::setTexture(0, s_scene, rc.graph->texture(scene));
+            bgfx::setVertexBuffer(0, m_triangle);
+            bgfx::setState(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
+            bgfx::submit(rc.view, p);
+        });
+}
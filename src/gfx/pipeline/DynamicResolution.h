@@ -0,0 +1,72 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include "gfx/shaders/ProgramRegistry.h"
+#include "RenderGraph.h"
+
+// 名称速记：DynamicResolution = 按帧耗时自动调场景分辨率 + 放大回后台缓冲
+// - 控制器：每帧取上一帧的 GPU 耗时（bgfx 计时），EMA 平滑；拿不到 GPU 计时就保持当前比例不动
+//   （CPU 帧间隔被 vsync 钉在刷新周期上，看不出余量，拿它当依据会一路降到最低）；
+//   超出目标就按 sqrt(目标/实际) 降比例（片元开销 ∝ 像素数 ∝ scale²），
+//   低于目标 kHeadroom 才慢慢升；每次调整后等 kSettleFrames 帧再看（GPU 计时滞后几帧）
+// - 场景目标：RGBA8 + 深度，渲染图的临时目标（BackbufferRatio::Equal，改窗口尺寸时 bgfx 自动重建）；
+//   场景只画在与 gl_FragCoord 同原点的一角（w*scale × h*scale），不用每次调比例都重建纹理
+// - scale == 1 时场景直接画到后台缓冲，不多一次拷贝
+// - 放大：渲染图里的一个通道，全屏三角形双线性采样到后台缓冲
+class DynamicResolution {
+public:
+    static constexpr float    kHeadroom     = 0.85f; // 低于目标的这个比例才升分辨率
+    static constexpr float    kMaxDrop      = 0.10f; // 单次最多降的比例
+    static constexpr float    kGrowStep     = 0.025f;
+    static constexpr uint32_t kSettleFrames = 10;
+
+    struct Stats {
+        float    scale = 1.0f;
+        uint16_t width = 0, height = 0; // 本帧场景的渲染尺寸
+        float    frameMs = 0.0f;        // 平滑后的帧耗时
+        bool     gpuTimed = false;      // 本帧拿到了 GPU 计时（否则控制器保持不动）
+        uint32_t changes = 0;           // 累计调整次数
+    };
+
+    bool init(ProgramRegistry& programs);
+    void shutdown();
+
+    void setEnabled(bool b) { m_enabled = b && m_supported; }
+    bool enabled() const { return m_enabled; }
+    bool supported() const { return m_supported; }
+    float targetFrameMs() const { return m_targetMs; }
+
+    // 每帧渲染前（API 线程）：width/height = 后台缓冲尺寸
+    void update(uint16_t width, uint16_t height);
+
+    // 本帧场景是否画在离屏目标上（启用且 scale < 1）
+    bool active() const { return m_active; }
+    // 本帧场景区域（bgfx 的 view rect 坐标，未激活时 = 后台缓冲全屏）
+    void viewRect(uint16_t rect[4]) const;
+    // 离屏场景目标的描述（active 时由调用方在渲染图里创建）
+    RGTextureDesc colorDesc() const;
+    RGTextureDesc depthDesc() const;
+    // 激活时加一个放大通道：读 scene，写 backbuffer
+    RenderGraph::PassId addUpscalePass(RenderGraph& graph, RGResource scene, RGResource backbuffer);
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    ProgramRegistry* m_registry = nullptr;
+    ProgramRef       m_program;
+
+    bgfx::VertexBufferHandle m_triangle = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle      s_scene = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle      u_upscale = BGFX_INVALID_HANDLE;
+    bgfx::TextureFormat::Enum m_depthFormat = bgfx::TextureFormat::Count;
+
+    bool     m_supported = false;
+    bool     m_enabled = false;
+    bool     m_active = false;
+    float    m_targetMs = 16.0f; // 60 Hz 留一点余量
+    float    m_minScale = 0.5f;
+    float    m_scale = 1.0f;
+    uint32_t m_cooldown = 0;
+    uint16_t m_fullW = 0, m_fullH = 0; // 后台缓冲尺寸
+    Stats    m_stats;
+};
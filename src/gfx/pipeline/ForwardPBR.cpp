@@ -1,48 +1,132 @@
 #include "ForwardPBR.h"
-#include "gfx/shaders/shader_utils.h" // ke_loadShaderFile/ke_loadProgramDx11 :contentReference[oaicite:7]{index=7}
+#include "gfx/texture/TextureArrayPacker.h"
+#include "gfx/lighting/ClusteredLighting.h"
+#include "gfx/lighting/CascadedShadows.h"
+#include "gfx/lighting/ImageBasedLighting.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <spdlog/spdlog.h>
 
-extern bgfx::ShaderHandle ke_loadShaderFile(const std::string&); // 声明以便使用
-
-bool ForwardPBR::init() {
+bool ForwardPBR::init(ProgramRegistry& programs) {
     m_light.init();
-    m_vs = ke_loadShaderFile("vs_pbr.bin");
-    m_fs = ke_loadShaderFile("fs_pbr_mr.bin");
-    return bgfx::isValid(m_vs) && bgfx::isValid(m_fs);
+    m_registry = &programs;
+    m_registryGen = programs.generation();
+    for (uint32_t i = 0; i < kPbrPermutationCount; ++i) {
+        m_programs[i] = {};
+        m_tried[i] = false;
+    }
+    m_depthProgram = programs.acquire("vs_depth.bin", "fs_depth.bin");
+    if (!m_depthProgram.valid())
+        spdlog::warn("[ForwardPBR] depth pre-pass program missing, pre-pass disabled");
+    // 最常用的两个排列先取，顺便验证着色器产物在位；其余用到时再取
+    return bgfx::isValid(programFor(0))
+        && bgfx::isValid(programFor(PbrFeature_Clustered));
 }
 void ForwardPBR::shutdown() {
     m_light.shutdown();
-    if (bgfx::isValid(m_vs)) bgfx::destroy(m_vs);
-    if (bgfx::isValid(m_fs)) bgfx::destroy(m_fs);
+    for (uint32_t i = 0; i < kPbrPermutationCount; ++i) {
+        if (m_registry) m_registry->release(m_programs[i]);
+        m_programs[i] = {};
+        m_tried[i] = false;
+    }
+    if (m_registry) m_registry->release(m_depthProgram);
+    m_depthProgram = {};
+    m_registry = nullptr;
 }
-void ForwardPBR::attachProgramTo(PbrMaterialGPU& m) {
-    if (!bgfx::isValid(m.program)) {
-        auto prog = bgfx::createProgram(m_vs, m_fs, /*destroyShaders*/false);
-        if (bgfx::isValid(prog)) m.program = prog;
+bgfx::ProgramHandle ForwardPBR::programFor(uint32_t mask) {
+    if (!m_registry) return BGFX_INVALID_HANDLE;
+    if (m_registryGen != m_registry->generation()) {
+        m_registryGen = m_registry->generation();
+        for (uint32_t i = 0; i < kPbrPermutationCount; ++i)
+            if (!m_programs[i].valid()) m_tried[i] = false;
+    }
+    if (mask >= kPbrPermutationCount) return BGFX_INVALID_HANDLE;
+    if (!m_tried[mask]) {
+        m_tried[mask] = true;
+        m_programs[mask] = m_registry->acquire("vs_pbr.bin", "fs_pbr_mr", mask);
+        if (!m_programs[mask].valid())
+            spdlog::error("[ForwardPBR] permutation 0x{:02x} missing, draws using it are skipped", mask);
     }
+    return m_registry->handle(m_programs[mask]);
+}
+void ForwardPBR::attachProgramTo(PbrMaterialGPU& m) {
+    // 同一排列的材质拿到同一个句柄，按 program 排序的 draw 才能真正合批
+    m.program = programFor(m.features | PbrFeature_Clustered);
+}
+bool ForwardPBR::drawDepth(const glm::mat4& model,
+                           bgfx::VertexBufferHandle vbhPos,
+                           bgfx::IndexBufferHandle  ibh,
+                           const PbrMaterialGPU&    mat,
+                           uint8_t viewId) {
+    if (!m_registry) return false;
+    bgfx::ProgramHandle p = m_registry->handle(m_depthProgram);
+    if (!bgfx::isValid(p)) return false;
+
+    bgfx::setTransform(glm::value_ptr(model));
+    bgfx::setVertexBuffer(0, vbhPos);
+    bgfx::setIndexBuffer(ibh);
+    bgfx::setState(BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS | (mat.state & BGFX_STATE_CULL_MASK));
+    bgfx::submit(viewId, p);
+    return true;
 }
 void ForwardPBR::draw(const glm::mat4& model,
                       bgfx::VertexBufferHandle vbh,
                       bgfx::IndexBufferHandle  ibh,
                       const PbrMaterialGPU&    mat,
-                      uint8_t viewId) {
-    m_light.uploadPerFrame();
+                      uint8_t viewId,
+                      const ObjectLights::List* lights) {
+    // 排列 = 材质特性 + 本帧光照/打包状态
+    uint32_t mask = materialMask(mat);
+    const bool clustered = clusteredActive();
+    uint32_t tier = 0;
+    if (clustered)
+        mask |= PbrFeature_Clustered;
+    else if (lights && m_objLights)
+        tier = pbrLightTierFor(lights->count);
+    mask |= tier << kPbrLightTierShift;
+
+    bgfx::ProgramHandle p = programFor(mask);
+    if (!bgfx::isValid(p)) return; // 缺排列：宁可不画，也不拿错误的采样器类型去画
 
     bgfx::setTransform(glm::value_ptr(model));
     bgfx::setVertexBuffer(0, vbh);
     bgfx::setIndexBuffer(ibh);
 
-    float flags[4] = { (float)mat.flags, 0,0,0 };
-    bgfx::setUniform(mat.u_flags, flags);
-    bgfx::setTexture(0, mat.s_baseColor, mat.t_baseColor);
-    bgfx::setTexture(1, mat.s_mr,        mat.t_mr);
-    bgfx::setTexture(2, mat.s_normal,    mat.t_normal);
-    bgfx::setTexture(3, mat.s_ao,        mat.t_ao);
-    bgfx::setTexture(4, mat.s_emissive,  mat.t_emissive);
+    // 预通道已写好深度：只有最前面的片元通过，每个像素只做一次完整着色
+    bgfx::setState(m_depthEqual
+        ? (mat.state & ~(BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_MASK)) | BGFX_STATE_DEPTH_TEST_EQUAL
+        : mat.state);
 
-    bgfx::setState(mat.state);
-
-    bgfx::ProgramHandle p = mat.program;
-    if (!bgfx::isValid(p)) p = bgfx::createProgram(m_vs, m_fs, false);
+    bindMaterial(mat);
+    bindLighting();
+    if (tier > 0) m_objLights->bind(*lights, pbrLightTierCount(tier));
     bgfx::submit(viewId, p);
 }
+uint32_t ForwardPBR::materialMask(const PbrMaterialGPU& mat) const {
+    uint32_t mask = mat.features & kPbrMaterialFeatureMask;
+    if (mat.texArray >= 0 && m_arrays) mask |= PbrFeature_TexArray;
+    return mask;
+}
+void ForwardPBR::bindMaterial(const PbrMaterialGPU& mat) const {
+    // 材质参数：整块一次上传（bgfx 会在 view 内重排 draw，uniform 不能假定沿用上一个 draw）
+    const PbrMaterialRegistry& R = *m_reg;
+    bgfx::setUniform(R.u_material, mat.params, PbrMaterialRegistry::kMaterialVec4);
+    if (mat.texArray >= 0 && m_arrays) {
+        // 打包材质：同组共用数组绑定，只有层号不同
+        m_arrays->bind(mat, R);
+    } else {
+        bgfx::setTexture(0, R.s_baseColor, mat.t_baseColor);
+        bgfx::setTexture(1, R.s_mr,        mat.t_mr);
+        bgfx::setTexture(2, R.s_normal,    mat.t_normal);
+        bgfx::setTexture(3, R.s_ao,        mat.t_ao);
+        bgfx::setTexture(4, R.s_emissive,  mat.t_emissive);
+    }
+}
+void ForwardPBR::bindLighting() const {
+    m_light.uploadPerFrame();
+    if (clusteredActive()) m_clusters->bind(5);
+    if (m_shadows) m_shadows->bind(8);
+    if (m_ibl) m_ibl->bind(9);
+}
+bool ForwardPBR::clusteredActive() const {
+    return m_clusters && m_clusters->active();
+}
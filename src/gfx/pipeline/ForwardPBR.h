@@ -3,27 +3,83 @@
 #include <glm/mat4x4.hpp>
 #include "gfx/material/PbrMaterial.h"
 #include "gfx/lighting/Lighting.h"
+#include "gfx/lighting/ObjectLights.h"
+#include "gfx/shaders/ProgramRegistry.h"
+
+class TextureArrayPacker;
+class CascadedShadows;
+class ImageBasedLighting;
 
 // 名称速记：ForwardPBR 管线 = “上传光照 + 绑定材质 + 提交网格”的封装
 
 class ForwardPBR {
 public:
-    bool init();
+    bool init(ProgramRegistry& programs);
     void shutdown();
 
     Lighting& lighting() { return m_light; }
 
-    // 给材质池绑定本管线着色器（或在创建材质后单独赋值）
+    // 给材质填上其排列的共享 program（句柄归本管线，材质只借用）
     void attachProgramTo(PbrMaterialGPU& m);
 
+    // 材质共享的 uniform/sampler 句柄（PbrMaterialManager 持有）
+    void setMaterialRegistry(const PbrMaterialRegistry* reg) { m_reg = reg; }
+
+    // 已打包进纹理数组的材质（texArray >= 0）改走 PbrFeature_TexArray 排列
+    void setTextureArrays(const TextureArrayPacker* arrays) { m_arrays = arrays; }
+
+    // 本帧有分簇光时改走 PbrFeature_Clustered 排列（数据纹理占 stage 5..7）；
+    // 为空则走逐物体光表（draw 的 lights 参数，按盏数选 0/1/2/4/8 档排列）
+    void setClusteredLighting(const ClusteredLighting* clusters) { m_clusters = clusters; }
+    void setObjectLights(const ObjectLights* objLights) { m_objLights = objLights; }
+
+    // 方向光级联阴影（图集占 stage 8）；为空或关闭时着色器跳过阴影
+    void setShadows(const CascadedShadows* shadows) { m_shadows = shadows; }
+
+    // 环境光 IBL（镜面立方体 + BRDF LUT 占 stage 9、10）；为空或未加载时退回平坦环境光
+    void setImageBasedLighting(const ImageBasedLighting* ibl) { m_ibl = ibl; }
+
+    // 深度预通道开启期间：主通道改用 DEPTH_TEST_EQUAL、不写深度（只影响 set 之后的 draw）
+    void setDepthEqual(bool b) { m_depthEqual = b; }
+
+    // 深度预通道：只用位置流 + 空片元着色器写深度；剔除方式与材质一致，EQUAL 才能对上
+    bool drawDepth(const glm::mat4& model,
+                   bgfx::VertexBufferHandle vbhPos,
+                   bgfx::IndexBufferHandle  ibh,
+                   const PbrMaterialGPU&    mat,
+                   uint8_t viewId);
+
+    // 以下三个也给延迟管线（DeferredPBR）复用，保证两条路径的材质/光照绑定一致
+    // 材质排列位：材质特性 + 是否走纹理数组
+    uint32_t materialMask(const PbrMaterialGPU& mat) const;
+    // 材质常量块 + 纹理（stage 0..4）
+    void bindMaterial(const PbrMaterialGPU& mat) const;
+    // 帧级光照：方向光/曝光 uniform + 分簇光（5..7）+ 阴影（8）+ IBL（9、10）；逐物体光表不在此
+    void bindLighting() const;
+    bool clusteredActive() const;
+
     void draw(const glm::mat4& model,
               bgfx::VertexBufferHandle vbh,
               bgfx::IndexBufferHandle  ibh,
               const PbrMaterialGPU&    mat,
-              uint8_t viewId = 0);
+              uint8_t viewId = 0,
+              const ObjectLights::List* lights = nullptr);
 
 private:
-    bgfx::ShaderHandle  m_vs = BGFX_INVALID_HANDLE;
-    bgfx::ShaderHandle  m_fs = BGFX_INVALID_HANDLE;
+    // 排列 → 共享 program：首次用到时向 ProgramRegistry 取一份引用，缺失的排列只报一次
+    bgfx::ProgramHandle programFor(uint32_t mask);
+
+    ProgramRegistry* m_registry = nullptr;
+    ProgramRef       m_programs[kPbrPermutationCount];
+    bool             m_tried[kPbrPermutationCount] = {};
+    uint32_t         m_registryGen = 0; // 重载后重试之前缺失的排列
+    ProgramRef       m_depthProgram;
+    bool             m_depthEqual = false;
+    const TextureArrayPacker* m_arrays = nullptr;
+    const ClusteredLighting*  m_clusters = nullptr;
+    const ObjectLights*       m_objLights = nullptr;
+    const CascadedShadows*    m_shadows = nullptr;
+    const ImageBasedLighting* m_ibl = nullptr;
+    const PbrMaterialRegistry* m_reg = nullptr;
     Lighting            m_light;
 };
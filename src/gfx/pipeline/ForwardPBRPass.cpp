@@ -5,7 +5,7 @@
 #include "RenderPass.h"         // RenderContext / DrawItem / DrawKey 的定义
 #include <bgfx/bgfx.h>          // bgfx 渲染 API
 #include <bx/math.h>            // bx 数学库（这里主要是类型与工具）
-#include "gfx/shaders/shader_utils.h" // 你的 shader 装载工具（ke_loadProgramDx11 等）
+#include "gfx/shaders/shader_utils.h" // 你的 shader 装载工具（ke_loadProgram 等）
 
 // 注意：我们不再 include "gfx/camera/Camera.h"
 // Pass 只消费 RenderContext 里传进来的“纯数据”（view/proj 指针 + camPos）。
@@ -18,7 +18,7 @@ void ForwardPBRPass::prepare(const RenderContext& /*rc*/)
     if (!bgfx::isValid(m_program)) {
         // 如果你项目里装载函数名不同（例如 ke_loadProgram 或 loadProgram），
         // 把下面这一行改成你工程的对应函数即可。
-        m_program = ke_loadProgramDx11("vs_pbr", "fs_pbr"); // 加载/链接 VS+FS
+        m_program = ke_loadProgram("vs_pbr", "fs_pbr"); // 加载/链接 VS+FS
     }
 
     // 2) Uniform（注意名称需要与着色器里保持一致）
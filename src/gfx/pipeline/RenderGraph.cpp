@@ -0,0 +1,394 @@
+#include "RenderGraph.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+// lambda 版通道：setup 在 addPass 里直接调，这里只转发 execute
+class RenderGraph::CallbackPass final : public RenderPass {
+public:
+    explicit CallbackPass(ExecFn exec) : m_exec(std::move(exec)) {}
+    void execute(const RenderContext& rc) override { if (m_exec) m_exec(rc); }
+
+private:
+    ExecFn m_exec;
+};
+
+// 按后台缓冲比例换算尺寸（与 bgfx 内部一致：至少 1）
+static void targetSize(const RGTextureDesc& d, uint16_t& w, uint16_t& h) {
+    if (d.ratio == bgfx::BackbufferRatio::Count) {
+        w = d.width;
+        h = d.height;
+        return;
+    }
+    const bgfx::Stats* st = bgfx::getStats();
+    uint32_t bw = st ? st->width : 0, bh = st ? st->height : 0;
+    switch (d.ratio) {
+    case bgfx::BackbufferRatio::Half:      bw /= 2;  bh /= 2;  break;
+    case bgfx::BackbufferRatio::Quarter:   bw /= 4;  bh /= 4;  break;
+    case bgfx::BackbufferRatio::Eighth:    bw /= 8;  bh /= 8;  break;
+    case bgfx::BackbufferRatio::Sixteenth: bw /= 16; bh /= 16; break;
+    case bgfx::BackbufferRatio::Double:    bw *= 2;  bh *= 2;  break;
+    default: break;
+    }
+    w = uint16_t(std::max<uint32_t>(bw, 1));
+    h = uint16_t(std::max<uint32_t>(bh, 1));
+}
+
+// ---- RenderGraphBuilder ----
+
+void RenderGraphBuilder::read(RGResource r) {
+    if (r.valid() && r.id < m_graph.m_resources.size())
+        m_graph.m_passes[m_pass].reads.push_back(r.id);
+}
+
+void RenderGraphBuilder::write(RGResource r) {
+    if (!r.valid() || r.id >= m_graph.m_resources.size()) return;
+    auto& writes = m_graph.m_passes[m_pass].writes;
+    if (std::find(writes.begin(), writes.end(), r.id) != writes.end()) return; // 颜色/深度都是后台缓冲时只记一次
+    writes.push_back(r.id);
+    m_graph.m_resources[r.id].writers.push_back(m_pass);
+}
+
+void RenderGraphBuilder::sideEffect() {
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+void RenderGraphBuilder::viewRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    auto& p = m_graph.m_passes[m_pass];
+    p.hasRect = true;
+    p.rect[0] = x; p.rect[1] = y; p.rect[2] = w; p.rect[3] = h;
+}
+
+// ---- RenderGraph ----
+
+void RenderGraph::init(bgfx::ViewId firstView, uint16_t maxViews) {
+    m_firstView = firstView;
+    m_maxViews = maxViews;
+    m_frame = 0;
+}
+
+void RenderGraph::shutdown() {
+    reset();
+    for (CachedFb& f : m_fbs)
+        if (bgfx::isValid(f.fb)) bgfx::destroy(f.fb);
+    for (Physical& p : m_pool)
+        if (bgfx::isValid(p.handle)) bgfx::destroy(p.handle);
+    m_fbs.clear();
+    m_pool.clear();
+    m_stats = {};
+}
+
+void RenderGraph::reset() {
+    m_resources.clear();
+    m_passes.clear();
+    m_order.clear();
+    m_callbacks.clear();
+}
+
+RGResource RenderGraph::importBackbuffer() {
+    Resource r;
+    r.name = "Backbuffer";
+    r.imported = r.backbuffer = true;
+    m_resources.push_back(std::move(r));
+    return RGResource{ uint16_t(m_resources.size() - 1) };
+}
+
+RGResource RenderGraph::importTexture(const char* name, bgfx::TextureHandle t) {
+    Resource r;
+    r.name = name;
+    r.imported = true;
+    r.handle = t;
+    m_resources.push_back(std::move(r));
+    return RGResource{ uint16_t(m_resources.size() - 1) };
+}
+
+RGResource RenderGraph::createTexture(const char* name, const RGTextureDesc& desc) {
+    Resource r;
+    r.name = name;
+    r.desc = desc;
+    m_resources.push_back(std::move(r));
+    return RGResource{ uint16_t(m_resources.size() - 1) };
+}
+
+RenderGraph::PassId RenderGraph::addPass(const char* name, RenderPass& pass) {
+    Pass p;
+    p.name = name;
+    p.pass = &pass;
+    m_passes.push_back(std::move(p));
+    const PassId id = PassId(m_passes.size() - 1);
+    RenderGraphBuilder b(*this, id);
+    pass.setup(b);
+    return id;
+}
+
+RenderGraph::PassId RenderGraph::addPass(const char* name, SetupFn setup, ExecFn exec) {
+    m_callbacks.push_back(std::make_unique<CallbackPass>(std::move(exec)));
+    Pass p;
+    p.name = name;
+    p.pass = m_callbacks.back().get();
+    m_passes.push_back(std::move(p));
+    const PassId id = PassId(m_passes.size() - 1);
+    RenderGraphBuilder b(*this, id);
+    if (setup) setup(b);
+    return id;
+}
+
+void RenderGraph::compile() {
+    ++m_frame;
+    const uint32_t n = (uint32_t)m_passes.size();
+
+    // 依赖边：读者依赖该资源的全部写者；写者依赖同一资源更早声明的写者
+    std::vector<std::vector<PassId>> deps(n);
+    auto addDep = [&](PassId p, PassId on) {
+        if (p != on && std::find(deps[p].begin(), deps[p].end(), on) == deps[p].end()) deps[p].push_back(on);
+    };
+    for (PassId p = 0; p < n; ++p) {
+        for (uint16_t r : m_passes[p].reads)
+            for (PassId w : m_resources[r].writers) addDep(p, w);
+        for (uint16_t r : m_passes[p].writes)
+            for (PassId w : m_resources[r].writers) {
+                if (w == p) break;
+                addDep(p, w);
+            }
+    }
+
+    // 剔除：从有副作用的通道沿依赖倒推
+    std::vector<PassId> stack;
+    for (PassId p = 0; p < n; ++p) {
+        Pass& ps = m_passes[p];
+        ps.kept = false;
+        ps.view = UINT16_MAX;
+        bool root = ps.sideEffect;
+        for (uint16_t r : ps.writes) root = root || m_resources[r].imported;
+        if (root) {
+            ps.kept = true;
+            stack.push_back(p);
+        }
+    }
+    while (!stack.empty()) {
+        const PassId p = stack.back();
+        stack.pop_back();
+        for (PassId d : deps[p])
+            if (!m_passes[d].kept) {
+                m_passes[d].kept = true;
+                stack.push_back(d);
+            }
+    }
+
+    // 拓扑排序（Kahn），就绪的里面取声明最早的，结果稳定
+    std::vector<uint32_t> pending(n, 0);
+    std::vector<std::vector<PassId>> users(n);
+    for (PassId p = 0; p < n; ++p) {
+        if (!m_passes[p].kept) continue;
+        for (PassId d : deps[p]) {
+            ++pending[p];
+            users[d].push_back(p);
+        }
+    }
+    m_order.clear();
+    std::vector<bool> done(n, false);
+    for (;;) {
+        PassId next = kInvalidPass;
+        for (PassId p = 0; p < n && next == kInvalidPass; ++p)
+            if (m_passes[p].kept && !done[p] && pending[p] == 0) next = p;
+        if (next == kInvalidPass) break;
+        done[next] = true;
+        m_order.push_back(next);
+        for (PassId u : users[next]) --pending[u];
+    }
+    for (PassId p = 0; p < n; ++p) {
+        if (m_passes[p].kept && !done[p]) { // 只有循环依赖才会走到这里
+            spdlog::error("[RenderGraph] dependency cycle at pass '{}', running in declaration order", m_passes[p].name);
+            m_order.push_back(p);
+        }
+    }
+
+    // view 分配：按执行顺序连续编号
+    if (m_order.size() > m_maxViews) {
+        spdlog::error("[RenderGraph] {} passes exceed {} views, dropping the rest", m_order.size(), m_maxViews);
+        for (size_t i = m_maxViews; i < m_order.size(); ++i) m_passes[m_order[i]].kept = false;
+        m_order.resize(m_maxViews);
+    }
+    for (size_t i = 0; i < m_order.size(); ++i)
+        m_passes[m_order[i]].view = bgfx::ViewId(m_firstView + i);
+
+    // 资源使用区间（按执行位置）
+    for (Resource& r : m_resources) r.first = r.last = -1;
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        const Pass& p = m_passes[m_order[i]];
+        for (const auto* list : { &p.reads, &p.writes })
+            for (uint16_t id : *list) {
+                Resource& r = m_resources[id];
+                if (r.first < 0) r.first = int32_t(i);
+                r.last = int32_t(i);
+            }
+    }
+
+    m_stats.passes = n;
+    m_stats.culled = n - (uint32_t)m_order.size();
+    allocateTransients();
+    for (PassId p : m_order) m_passes[p].fb = frameBuffer(m_passes[p]);
+    collectGarbage();
+}
+
+void RenderGraph::allocateTransients() {
+    for (Physical& ph : m_pool) ph.busyUntil = -1;
+
+    // 按首次使用排序后贪心分配：描述相同、上一个持有者已用完的物理纹理直接复用
+    std::vector<uint16_t> list;
+    for (uint16_t i = 0; i < m_resources.size(); ++i) {
+        Resource& r = m_resources[i];
+        if (r.imported) continue;
+        r.handle = BGFX_INVALID_HANDLE;
+        if (r.first >= 0) list.push_back(i);
+    }
+    std::sort(list.begin(), list.end(), [&](uint16_t a, uint16_t b) { return m_resources[a].first < m_resources[b].first; });
+
+    uint32_t aliased = 0, physical = 0;
+    for (uint16_t id : list) {
+        Resource& r = m_resources[id];
+        if (r.writers.empty())
+            spdlog::warn("[RenderGraph] '{}' is read but never written", r.name);
+        Physical* pick = nullptr;
+        for (Physical& ph : m_pool) {
+            if (!(ph.desc == r.desc) || ph.busyUntil >= r.first) continue;
+            // 优先挑本帧已经用过的（别名），其次才动闲置的
+            if (!pick || (ph.lastFrame == m_frame && pick->lastFrame != m_frame)) pick = &ph;
+        }
+        if (pick && pick->lastFrame == m_frame) ++aliased;
+        if (!pick) {
+            Physical ph;
+            ph.desc = r.desc;
+            if (r.desc.ratio == bgfx::BackbufferRatio::Count)
+                ph.handle = bgfx::createTexture2D(r.desc.width, r.desc.height, false, 1, r.desc.format, r.desc.flags);
+            else
+                ph.handle = bgfx::createTexture2D(r.desc.ratio, false, 1, r.desc.format, r.desc.flags);
+            if (!bgfx::isValid(ph.handle)) {
+                spdlog::error("[RenderGraph] failed to create '{}'", r.name);
+                continue;
+            }
+            m_pool.push_back(ph);
+            pick = &m_pool.back();
+        }
+        if (pick->lastFrame != m_frame) ++physical;
+        pick->lastFrame = m_frame;
+        pick->busyUntil = r.last;
+        r.handle = pick->handle;
+    }
+
+    m_stats.transients = (uint32_t)list.size();
+    m_stats.physical = physical;
+    m_stats.aliased = aliased;
+}
+
+bgfx::FrameBufferHandle RenderGraph::frameBuffer(const Pass& p) {
+    // 没写任何目标，或写的是后台缓冲：用默认帧缓冲
+    std::vector<bgfx::TextureHandle> att;
+    std::vector<uint16_t> key;
+    for (uint16_t id : p.writes) {
+        const Resource& r = m_resources[id];
+        if (r.backbuffer) {
+            if (p.writes.size() > 1)
+                spdlog::error("[RenderGraph] pass '{}' writes the backbuffer together with other targets", p.name);
+            return BGFX_INVALID_HANDLE;
+        }
+        if (!bgfx::isValid(r.handle)) return BGFX_INVALID_HANDLE;
+        att.push_back(r.handle); // 深度附件由 bgfx 按格式识别
+        key.push_back(r.handle.idx);
+    }
+    if (att.empty()) return BGFX_INVALID_HANDLE;
+
+    for (CachedFb& f : m_fbs) {
+        if (f.key == key) {
+            f.lastFrame = m_frame;
+            return f.fb;
+        }
+    }
+    CachedFb f;
+    f.key = key;
+    f.fb = bgfx::createFrameBuffer(uint8_t(att.size()), att.data(), false); // 纹理归池 / 导入方
+    f.lastFrame = m_frame;
+    if (!bgfx::isValid(f.fb)) {
+        spdlog::error("[RenderGraph] framebuffer for pass '{}' failed", p.name);
+        return BGFX_INVALID_HANDLE;
+    }
+    m_fbs.push_back(f);
+    return f.fb;
+}
+
+void RenderGraph::collectGarbage() {
+    auto stale = [&](uint64_t last) { return last + kKeepFrames < m_frame; };
+    // 先销毁引用了要回收纹理的帧缓冲（以及自身闲置的）
+    std::vector<uint16_t> dead;
+    for (const Physical& ph : m_pool)
+        if (stale(ph.lastFrame)) dead.push_back(ph.handle.idx);
+    for (size_t i = 0; i < m_fbs.size();) {
+        CachedFb& f = m_fbs[i];
+        bool drop = stale(f.lastFrame);
+        for (uint16_t k : f.key) drop = drop || std::find(dead.begin(), dead.end(), k) != dead.end();
+        if (drop) {
+            bgfx::destroy(f.fb);
+            m_fbs[i] = m_fbs.back();
+            m_fbs.pop_back();
+        } else {
+            ++i;
+        }
+    }
+    m_pool.erase(std::remove_if(m_pool.begin(), m_pool.end(), [&](const Physical& ph) {
+        if (!stale(ph.lastFrame)) return false;
+        bgfx::destroy(ph.handle);
+        return true;
+    }), m_pool.end());
+
+    m_stats.pooled = (uint32_t)m_pool.size();
+    m_stats.bytes = 0;
+    for (const Physical& ph : m_pool) {
+        uint16_t w, h;
+        targetSize(ph.desc, w, h);
+        bgfx::TextureInfo info;
+        bgfx::calcTextureSize(info, w, h, 1, false, false, 1, ph.desc.format);
+        m_stats.bytes += info.storageSize;
+    }
+}
+
+void RenderGraph::execute(const RenderContext& rc) {
+    for (PassId id : m_order) {
+        Pass& p = m_passes[id];
+        const bgfx::ViewId v = p.view;
+        bgfx::setViewName(v, p.name.c_str());
+        bgfx::setViewMode(v, bgfx::ViewMode::Default);
+        bgfx::setViewClear(v, BGFX_CLEAR_NONE);
+        bgfx::setViewFrameBuffer(v, p.fb);
+        bgfx::setViewTransform(v, nullptr, nullptr);
+        if (p.hasRect) {
+            bgfx::setViewRect(v, p.rect[0], p.rect[1], p.rect[2], p.rect[3]);
+        } else {
+            // 附件全尺寸：取第一个非后台缓冲附件的描述
+            const Resource* att = nullptr;
+            for (uint16_t r : p.writes)
+                if (!m_resources[r].backbuffer && !m_resources[r].imported) { att = &m_resources[r]; break; }
+            if (att && att->desc.ratio == bgfx::BackbufferRatio::Count)
+                bgfx::setViewRect(v, 0, 0, att->desc.width, att->desc.height);
+            else
+                bgfx::setViewRect(v, 0, 0, bgfx::BackbufferRatio::Equal);
+        }
+        bgfx::touch(v); // 只有清屏的通道也要执行
+
+        const RenderContext prc{ v, rc.viewMatrix, rc.projMatrix, { rc.camPos[0], rc.camPos[1], rc.camPos[2] },
+                                 rc.timeSec, rc.drawList, this };
+        p.pass->prepare(prc);
+        p.pass->execute(prc);
+    }
+}
+
+bool RenderGraph::culled(PassId p) const {
+    return p >= m_passes.size() || !m_passes[p].kept;
+}
+
+bgfx::ViewId RenderGraph::view(PassId p) const {
+    return p < m_passes.size() ? m_passes[p].view : bgfx::ViewId(UINT16_MAX);
+}
+
+bgfx::TextureHandle RenderGraph::texture(RGResource r) const {
+    if (!r.valid() || r.id >= m_resources.size()) return BGFX_INVALID_HANDLE;
+    return m_resources[r.id].handle;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include "RenderPass.h"
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 名称速记：RenderGraph = 每帧重建的渲染图（帧图）
+// - 每帧：reset → 导入外部资源 / 声明临时目标 → addPass（各通道在 setup 里声明读写）→ compile → execute
+// - 依赖：读一个资源 = 依赖它的全部写者；同一资源的多个写者按声明顺序串起来（后写的保留先写的内容）
+// - compile：从“有副作用”的通道（写后台缓冲 / 导入资源，或显式 sideEffect）倒推，没人用到输出的通道剔除；
+//   剩下的拓扑排序（同层按声明顺序），依次分配 view id（firstView 起连续），不再需要 setViewOrder
+// - 临时目标：按 [首次使用, 最后使用] 的区间从池里分配物理纹理，描述相同且区间不重叠的共用一张（别名）；
+//   池跨帧保留，连续 kKeepFrames 帧没用到的纹理才销毁
+// - 帧缓冲：按附件组合缓存；导入的纹理也可以当附件（不随帧缓冲销毁）
+// - 通道写的资源就是它 view 的附件（声明顺序 = MRT 顺序，深度格式自动当深度附件）；后台缓冲只能单独写
+struct RGResource {
+    static constexpr uint16_t kInvalid = UINT16_MAX;
+    uint16_t id = kInvalid;
+    bool valid() const { return id != kInvalid; }
+};
+
+struct RGTextureDesc {
+    bgfx::TextureFormat::Enum   format = bgfx::TextureFormat::RGBA8;
+    bgfx::BackbufferRatio::Enum ratio  = bgfx::BackbufferRatio::Equal; // Count = 用 width/height
+    uint16_t width = 0, height = 0;
+    uint64_t flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_UVW_CLAMP;
+
+    bool operator==(const RGTextureDesc& o) const {
+        return format == o.format && ratio == o.ratio && width == o.width && height == o.height && flags == o.flags;
+    }
+};
+
+class RenderGraph;
+
+// setup 阶段交给通道的声明接口
+class RenderGraphBuilder {
+public:
+    void read(RGResource r);
+    void write(RGResource r);
+    void sideEffect();                                          // 输出没人读也保留
+    void viewRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h); // 默认 = 附件全尺寸
+
+private:
+    friend class RenderGraph;
+    RenderGraphBuilder(RenderGraph& g, uint16_t pass) : m_graph(g), m_pass(pass) {}
+    RenderGraph& m_graph;
+    uint16_t     m_pass;
+};
+
+class RenderGraph {
+public:
+    using PassId = uint16_t;
+    static constexpr PassId   kInvalidPass = UINT16_MAX;
+    static constexpr uint32_t kKeepFrames = 120; // 池里闲置这么多帧的纹理 / 帧缓冲才销毁
+
+    using SetupFn = std::function<void(RenderGraphBuilder&)>;
+    using ExecFn  = std::function<void(const RenderContext&)>;
+
+    struct Stats {
+        uint32_t passes = 0;     // 声明的通道
+        uint32_t culled = 0;     // 被剔除的通道
+        uint32_t transients = 0; // 本帧用到的临时目标
+        uint32_t physical = 0;   // 本帧用到的物理纹理
+        uint32_t aliased = 0;    // 借用了同帧别的目标纹理的临时目标
+        uint32_t pooled = 0;     // 池里的物理纹理总数（含闲置）
+        uint64_t bytes = 0;      // 池里纹理的估算显存
+    };
+
+    // firstView 起最多 maxViews 个 view 归渲染图分配
+    void init(bgfx::ViewId firstView, uint16_t maxViews);
+    void shutdown();
+
+    void reset();
+    RGResource importBackbuffer();
+    RGResource importTexture(const char* name, bgfx::TextureHandle t);
+    RGResource createTexture(const char* name, const RGTextureDesc& desc);
+
+    // pass 的生命周期由调用方保证（至少到 execute 结束）；setup 立即调用
+    PassId addPass(const char* name, RenderPass& pass);
+    PassId addPass(const char* name, SetupFn setup, ExecFn exec);
+
+    void compile();
+    // 按顺序设置每个 view（名称 / 帧缓冲 / rect / 清屏关 / 单位变换）再调 prepare + execute；
+    // 传给通道的 rc 只换了 view 和 graph
+    void execute(const RenderContext& rc);
+
+    // compile 之后有效
+    bool culled(PassId p) const;
+    bgfx::ViewId view(PassId p) const; // 被剔除 / 无效返回 UINT16_MAX
+    // execute 期间有效（导入的纹理任何时候都有效）
+    bgfx::TextureHandle texture(RGResource r) const;
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    friend class RenderGraphBuilder;
+
+    struct Resource {
+        std::string name;
+        RGTextureDesc desc;
+        bool imported = false;
+        bool backbuffer = false;
+        bgfx::TextureHandle handle = BGFX_INVALID_HANDLE; // 导入的纹理 / 分配到的物理纹理
+        std::vector<PassId> writers;                       // 声明顺序
+        int32_t first = -1, last = -1;                     // 排序后的使用区间
+    };
+    struct Pass {
+        std::string name;
+        RenderPass* pass = nullptr;
+        std::vector<uint16_t> reads, writes;
+        bool sideEffect = false;
+        bool hasRect = false;
+        uint16_t rect[4] = {};
+        bool kept = false;
+        bgfx::ViewId view = UINT16_MAX;
+        bgfx::FrameBufferHandle fb = BGFX_INVALID_HANDLE;
+    };
+    struct Physical {
+        RGTextureDesc desc;
+        bgfx::TextureHandle handle = BGFX_INVALID_HANDLE;
+        uint64_t lastFrame = 0;
+        int32_t  busyUntil = -1; // 本帧当前持有者的最后使用位置
+    };
+    struct CachedFb {
+        std::vector<uint16_t> key; // 附件纹理的 idx
+        bgfx::FrameBufferHandle fb = BGFX_INVALID_HANDLE;
+        uint64_t lastFrame = 0;
+    };
+    class CallbackPass;
+
+    void allocateTransients();
+    bgfx::FrameBufferHandle frameBuffer(const Pass& p);
+    void collectGarbage();
+
+    bgfx::ViewId m_firstView = 0;
+    uint16_t     m_maxViews = 0;
+    uint64_t     m_frame = 0;
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass>     m_passes;
+    std::vector<PassId>   m_order; // 保留下来的通道，执行顺序
+    std::vector<std::unique_ptr<RenderPass>> m_callbacks;
+
+    std::vector<Physical> m_pool;
+    std::vector<CachedFb> m_fbs;
+    Stats m_stats;
+};
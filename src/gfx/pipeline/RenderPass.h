@@ -5,6 +5,10 @@
 #include <memory>     // std::unique_ptr 智能指针
 #include <bgfx/bgfx.h> // bgfx 句柄与渲染 API（ViewId、VertexBufferHandle 等）
 
+struct PbrMaterialGPU;  // 前置声明：DrawItem 只存指针，不需要完整定义
+class RenderGraph;      // 前置声明：RenderContext 只存指针
+class RenderGraphBuilder;
+
 // =============================
 // DrawKey：排序键（64 位）
 // 用“位域”把一个 64-bit 整数分成多个子字段，
@@ -53,6 +57,9 @@ struct DrawItem final {                          // final：禁止继续被继
     float metallic     = 0.0f;                   // 金属度 [0,1]
     float roughness    = 1.0f;                   // 粗糙度 [0,1]
 
+    // 材质系统里的 PBR 材质（非空时优先于上面的散装字段；DeferredPBR 只认这个）
+    const PbrMaterialGPU* material = nullptr;
+
     // 固定状态位（深度测试、写入、剔除、MSAA 等）
     uint64_t state = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_Z |
                      BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA;
@@ -70,10 +77,12 @@ struct RenderContext final {
     float        camPos[3];                           // 摄像机世界空间坐标 (x,y,z)
     float        timeSec;                             // 运行时间（秒）
     const std::vector<DrawItem>& drawList;            // 本帧的绘制条目列表（只读引用）
+    const RenderGraph*           graph = nullptr;     // 经渲染图执行时非空：按 RGResource 取纹理
 };
 
 // =============================
 // RenderPass：渲染通道抽象基类
+// - setup()：可选，加进 RenderGraph 时声明读写的资源（rc.view 由渲染图分配）
 // - prepare()：可选，做懒加载或本帧预处理
 // - execute()：必须，实现绘制提交
 // 禁拷贝：避免资源拥有者被意外复制
@@ -82,6 +91,7 @@ class RenderPass {
 public:
     virtual ~RenderPass() = default;                 // 虚析构：通过基类指针 delete 派生类安全
 
+    virtual void setup(RenderGraphBuilder& /*b*/) {}     // 默认不声明任何资源（没有副作用就会被剔除）
     virtual void prepare(const RenderContext& /*rc*/) {} // 默认空实现（可不重载）
 
     virtual void execute(const RenderContext& rc) = 0;   // 纯虚函数：派生类必须实现
@@ -0,0 +1,146 @@
+#include "MeshRegistry.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+static std::string normalizePath(const std::string& path) {
+    return fs::path(path).lexically_normal().generic_string();
+}
+
+void MeshRegistry::destroyGpu(MeshGPU& m) {
+    if (bgfx::isValid(m.vbh))    bgfx::destroy(m.vbh);
+    if (bgfx::isValid(m.vbhPos)) bgfx::destroy(m.vbhPos);
+    if (bgfx::isValid(m.ibh))    bgfx::destroy(m.ibh);
+    m = MeshGPU{};
+}
+
+void MeshRegistry::shutdown() {
+    for (auto& s : m_slots)
+        if (s.refs > 0) destroyGpu(s.mesh);
+    for (auto& p : m_graveyard) destroyGpu(p.mesh);
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_graveyard.clear();
+    m_lookup.clear();
+    m_byContent.clear();
+    m_materials = nullptr;
+    m_stats = {};
+}
+
+MeshHandle MeshRegistry::find(const std::string& path, PbrMatHandle* material, std::string* baseColorPath) {
+    auto it = m_lookup.find(normalizePath(path));
+    if (it == m_lookup.end()) {
+        ++m_stats.misses;
+        return {};
+    }
+    ++m_stats.hits;
+    Slot& s = m_slots[it->second.slot];
+    ++s.refs;
+    ++m_stats.refs;
+    if (material) *material = it->second.material;
+    if (baseColorPath) *baseColorPath = it->second.baseColorPath;
+    return { it->second.slot, s.generation };
+}
+
+MeshHandle MeshRegistry::findContent(uint64_t contentHash) {
+    auto it = m_byContent.find(contentHash);
+    if (contentHash == 0 || it == m_byContent.end()) return {};
+    Slot& s = m_slots[it->second];
+    ++s.refs;
+    ++m_stats.refs;
+    return { it->second, s.generation };
+}
+
+MeshHandle MeshRegistry::create(const std::string& path, uint64_t contentHash, MeshGPU mesh,
+                                PbrMatHandle material, const std::string& baseColorPath) {
+    uint32_t slot;
+    if (!m_freeSlots.empty()) { slot = m_freeSlots.back(); m_freeSlots.pop_back(); }
+    else { slot = (uint32_t)m_slots.size(); m_slots.emplace_back(); }
+
+    Slot& s = m_slots[slot];
+    s.mesh = std::move(mesh);
+    s.refs = 1;
+    s.content = contentHash;
+    if (contentHash) m_byContent[contentHash] = slot;
+    ++m_stats.meshes;
+    ++m_stats.refs;
+    m_stats.bytes += s.mesh.bytes;
+
+    const MeshHandle h{ slot, s.generation };
+    addAlias(h, path, material, baseColorPath);
+    return h;
+}
+
+void MeshRegistry::addAlias(MeshHandle h, const std::string& path, PbrMatHandle material,
+                            const std::string& baseColorPath) {
+    if (!isAlive(h)) return;
+    Slot& s = m_slots[h.index];
+    if (material.valid()) s.materials.push_back(material);
+    if (path.empty()) return;
+    // 同 Key 的旧条目（若有）不再被找到，照常按引用释放
+    std::string key = normalizePath(path);
+    m_lookup[key] = PathRef{ h.index, material, baseColorPath };
+    s.keys.push_back(std::move(key));
+    if (s.keys.size() > 1) { // 第一条是上传它的路径，之后的都是省下来的上传
+        ++m_stats.aliases;
+        m_stats.bytesDeduped += s.mesh.bytes;
+    }
+}
+
+bool MeshRegistry::isAlive(MeshHandle h) const {
+    return h.index < m_slots.size()
+        && m_slots[h.index].generation == h.generation
+        && m_slots[h.index].refs > 0;
+}
+
+const MeshGPU* MeshRegistry::tryGet(MeshHandle h) const {
+    return isAlive(h) ? &m_slots[h.index].mesh : nullptr;
+}
+
+void MeshRegistry::addRef(MeshHandle h) {
+    if (!isAlive(h)) return;
+    ++m_slots[h.index].refs;
+    ++m_stats.refs;
+}
+
+void MeshRegistry::release(MeshHandle h) {
+    if (!isAlive(h)) return;
+    Slot& s = m_slots[h.index];
+    --m_stats.refs;
+    if (--s.refs > 0) return;
+
+    // 最后一个引用：句柄立即失效，缓冲等 kDestroyDelay 帧
+    for (const std::string& key : s.keys) {
+        auto it = m_lookup.find(key);
+        if (it != m_lookup.end() && it->second.slot == h.index) m_lookup.erase(it);
+    }
+    auto it = m_byContent.find(s.content);
+    if (s.content && it != m_byContent.end() && it->second == h.index) m_byContent.erase(it);
+    if (m_materials)
+        for (PbrMatHandle m : s.materials) m_materials->destroy(m); // 材质自己也会延迟释放
+    if (s.keys.size() > 1) {
+        m_stats.aliases -= uint32_t(s.keys.size() - 1);
+        m_stats.bytesDeduped -= uint64_t(s.keys.size() - 1) * s.mesh.bytes;
+    }
+    --m_stats.meshes;
+    m_stats.bytes -= s.mesh.bytes;
+    m_graveyard.push_back({ std::move(s.mesh), m_frame });
+    s.mesh = MeshGPU{};
+    s.keys.clear();
+    s.materials.clear();
+    s.content = 0;
+    if (++s.generation == 0) s.generation = 1; // 0 留给“从未有效”的句柄
+    m_freeSlots.push_back(h.index);
+    m_stats.pending = (uint32_t)m_graveyard.size();
+}
+
+void MeshRegistry::collectGarbage() {
+    ++m_frame;
+    size_t keep = 0;
+    for (size_t i = 0; i < m_graveyard.size(); ++i) {
+        if (m_frame - m_graveyard[i].frame >= kDestroyDelay) destroyGpu(m_graveyard[i].mesh);
+        else if (keep++ != i) m_graveyard[keep - 1] = std::move(m_graveyard[i]);
+    }
+    m_graveyard.resize(keep);
+    m_stats.pending = (uint32_t)keep;
+}
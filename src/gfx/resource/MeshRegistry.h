@@ -0,0 +1,112 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gfx/material/PbrMaterial.h" // PbrMatHandle
+
+// 名称速记：MeshRegistry = 全引擎共享的 GPU 网格表（ResourceCache 持有）
+// - Key：规整路径；同一文件只上传一份 VB/IB/位置流，再次加载只 +1 引用，多个实体共用一份缓冲
+// - 内容去重：另按几何数据的 XXH64 建索引；换了路径 / 拷贝出来的同一份几何，新路径只登记成别名，
+//   不再上传（每条路径各配自己的材质，贴图的去重交给 TextureCache）
+// - MeshHandle：代际句柄（index + generation）；槽位复用后旧句柄 tryGet 返回 nullptr
+// - 引用计数：create / find 命中 / addRef +1，release -1；归零后立即失效并摘掉 Key，
+//   GPU 缓冲进墓地，kDestroyDelay 帧后销毁（与 PbrMaterialManager 同一套节奏）
+// - 各路径加载时配的材质归网格所有，随网格一起销毁；导出用的 CPU 几何用 shared_ptr 由实体共享，
+//   贴图路径按路径记（PathRef），不放进共享的那份
+
+struct MeshExportData; // scene/Scene.h
+
+struct MeshHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+    bool valid() const { return index != UINT32_MAX; }
+    bool operator==(const MeshHandle& o) const { return index == o.index && generation == o.generation; }
+    bool operator!=(const MeshHandle& o) const { return !(*this == o); }
+};
+
+struct MeshGPU {
+    bgfx::VertexBufferHandle vbh    = BGFX_INVALID_HANDLE;
+    bgfx::VertexBufferHandle vbhPos = BGFX_INVALID_HANDLE; // 只有位置的流（深度预通道 / 阴影）
+    bgfx::IndexBufferHandle  ibh    = BGFX_INVALID_HANDLE;
+    uint32_t indexCount  = 0;
+    uint32_t vertexCount = 0;
+    uint64_t bytes       = 0;      // VB + 位置流 + IB 的估算字节数
+    float    bmin[3] = {}, bmax[3] = {}; // 物体空间 AABB
+    std::shared_ptr<const MeshExportData> cpu; // 导出用 CPU 副本（可空）
+};
+
+class MeshRegistry {
+public:
+    struct Stats {
+        uint32_t meshes  = 0; // 存活网格数
+        uint32_t refs    = 0; // 引用总数（≈ 引用它们的实体数）
+        uint32_t pending = 0; // 墓地里等待销毁的网格
+        uint64_t bytes   = 0; // 存活网格的 GPU 字节数
+        uint64_t hits    = 0; // find 命中（省掉的一次加载 + 上传）
+        uint64_t misses  = 0; // find 未命中
+        uint32_t aliases = 0; // 按内容命中、指向已有网格的路径数
+        uint64_t bytesDeduped = 0; // 别名省下的 GPU 字节
+    };
+
+    // 设置后，网格释放时顺带销毁它名下的材质
+    void setMaterials(PbrMaterialManager* materials) { m_materials = materials; }
+    void shutdown(); // 销毁全部缓冲（不管引用计数）；材质由 PbrMaterialManager 自己清
+
+    // 命中则 +1 引用并返回句柄，material / baseColorPath 给出这条路径配的材质与贴图；
+    // 未命中返回无效句柄（调用方加载后 create）
+    MeshHandle find(const std::string& path, PbrMatHandle* material = nullptr,
+                    std::string* baseColorPath = nullptr);
+    // 按几何内容找：命中则 +1 引用，调用方随后 addAlias 登记自己的路径；未命中返回无效句柄
+    MeshHandle findContent(uint64_t contentHash);
+    // 登记新网格（接管缓冲与材质），引用计数 = 1；path 可空（不参与查找），contentHash 0 = 不参与去重
+    MeshHandle create(const std::string& path, uint64_t contentHash, MeshGPU mesh, PbrMatHandle material,
+                      const std::string& baseColorPath = {});
+    // 让 path 也指向 h（findContent 命中后调用）；material 归网格，baseColorPath 只记在这条路径上（导出用）
+    void addAlias(MeshHandle h, const std::string& path, PbrMatHandle material,
+                  const std::string& baseColorPath = {});
+    void addRef(MeshHandle h);
+    void release(MeshHandle h);
+
+    bool isAlive(MeshHandle h) const;
+    const MeshGPU* tryGet(MeshHandle h) const; // 过期句柄返回 nullptr
+
+    // 每帧调用一次：销毁已过延迟期的网格
+    void collectGarbage();
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    static constexpr uint32_t kDestroyDelay = 3; // 帧；覆盖仍在途的 draw
+
+    struct Slot {
+        MeshGPU     mesh;
+        std::vector<std::string>  keys;      // 指向它的路径（第一条是首次加载的）
+        std::vector<PbrMatHandle> materials; // 各路径的材质
+        uint64_t    content = 0;
+        uint32_t    generation = 1;
+        uint32_t    refs = 0; // 0 = 空闲
+    };
+    struct PathRef {
+        uint32_t     slot = 0;
+        PbrMatHandle material{};
+        std::string  baseColorPath; // 别名的几何相同，贴图未必相同
+    };
+    struct Pending {
+        MeshGPU  mesh;
+        uint32_t frame = 0; // 归零时的帧号
+    };
+
+    void destroyGpu(MeshGPU& m);
+
+    std::vector<Slot>     m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::vector<Pending>  m_graveyard;
+    std::unordered_map<std::string, PathRef> m_lookup;  // 规整路径 → 槽位 + 材质
+    std::unordered_map<uint64_t, uint32_t>    m_byContent; // 几何哈希 → 槽位
+    PbrMaterialManager* m_materials = nullptr;
+    uint32_t m_frame = 0;
+    Stats    m_stats;
+};
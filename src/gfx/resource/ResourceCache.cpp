@@ -1,15 +1,22 @@
 #include "ResourceCache.h"
-#include "gfx/texture/TextureLoader.h"
 #include <bgfx/bgfx.h>
 
+bool ResourceCache::init(uint64_t texBudgetBytes) {
+    return textures_.init(texBudgetBytes);
+}
+
 bgfx::TextureHandle ResourceCache::getTexture2D(const std::string& path, bool flipY) {
-    auto it = texCache_.find(path);
-    if (it != texCache_.end() && bgfx::isValid(it->second)) return it->second;
-    auto h = createTexture2DFromFile(path, /*srgb*/false, /*sampler*/0);
-    if (bgfx::isValid(h)) texCache_[path] = h;
-    return h;
+    const std::string key = (flipY ? "1|" : "0|") + path;
+    auto it = texRefs_.find(key);
+    if (it != texRefs_.end()) return textures_.handle(it->second);
+    TexRef r = textures_.acquire(path, /*srgb*/false, flipY);
+    if (r.valid()) texRefs_[key] = r;
+    return textures_.handle(r);
 }
 void ResourceCache::clear() {
-    for (auto& kv : texCache_) if (bgfx::isValid(kv.second)) bgfx::destroy(kv.second);
-    texCache_.clear();
+    for (auto& kv : texRefs_) textures_.release(kv.second);
+    texRefs_.clear();
+    meshes_.shutdown();
+    textures_.shutdown();
+    programs_.shutdown();
 }
@@ -2,12 +2,32 @@
 #include <bgfx/bgfx.h>
 #include <string>
 #include <unordered_map>
+#include "TextureCache.h"
+#include "MeshRegistry.h"
+#include "gfx/shaders/ProgramRegistry.h"
 
+// 引擎级资源缓存：持有唯一的 TextureCache / ProgramRegistry / MeshRegistry；材质系统等通过 textures()/programs() 共享
 class ResourceCache {
 public:
+    bool init(uint64_t texBudgetBytes = TextureCache::kDefaultBudget);
+
+    // 旧接口：返回裸句柄；本类替调用方持有一份引用，直到 clear()
     bgfx::TextureHandle getTexture2D(const std::string& path,
                                      bool flipY = true);
     void clear(); // 退出时释放（你已在 Renderer::shutdown 释放全局）
+
+    TextureCache&       textures()       { return textures_; }
+    const TextureCache& textures() const { return textures_; }
+
+    ProgramRegistry&       programs()       { return programs_; }
+    const ProgramRegistry& programs() const { return programs_; }
+
+    MeshRegistry&       meshes()       { return meshes_; }
+    const MeshRegistry& meshes() const { return meshes_; }
+
 private:
-    std::unordered_map<std::string, bgfx::TextureHandle> texCache_;
+    TextureCache textures_;
+    ProgramRegistry programs_;
+    MeshRegistry meshes_;
+    std::unordered_map<std::string, TexRef> texRefs_; // key = flip 标记 + 路径
 };
@@ -0,0 +1,391 @@
+#include "TextureCache.h"
+#include "gfx/texture/TextureLoader.h"
+#include "core/JobSystem.h"
+#include "core/ContentHash.h"
+#include <spdlog/spdlog.h>
+#include <filesystem>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+// 同一文件的不同写法（a/./b.png、a/../a/b.png）规整成同一个 key
+static std::string normalizePath(const std::string& path) {
+    return fs::path(path).lexically_normal().generic_string();
+}
+
+size_t TextureCache::KeyHash::operator()(const Key& k) const {
+    size_t h = std::hash<std::string>{}(k.path);
+    const size_t bits = size_t(k.srgb) | (size_t(k.flipY) << 1) | (size_t(k.format) << 2);
+    return h ^ (bits + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+bool TextureCache::init(uint64_t budgetBytes) {
+    m_stats = {};
+    m_stats.budgetBytes = budgetBytes;
+    m_entries.reserve(256);
+    return true;
+}
+
+void TextureCache::shutdown() {
+    if (m_jobs) m_jobs->waitIdle(); // 在途解码会回写 m_decoded
+    m_decoded.clear();
+    for (auto& e : m_entries)
+        if (bgfx::isValid(e.tex)) bgfx::destroy(e.tex);
+    m_entries.clear();
+    m_free.clear();
+    m_lookup.clear();
+    m_byContent.clear();
+    m_lru.clear();
+    const uint64_t budget = m_stats.budgetBytes;
+    m_stats = {};
+    m_stats.budgetBytes = budget;
+}
+
+TexRef TextureCache::acquire(const std::string& path, bool srgb, bool flipY,
+                             bgfx::TextureFormat::Enum format, bool streamable) {
+    if (path.empty()) return {};
+
+    Key key{ normalizePath(path), srgb, flipY, format };
+    auto it = m_lookup.find(key);
+    if (it != m_lookup.end()) {
+        ++m_stats.hits;
+        addRef(TexRef{ it->second });
+        return TexRef{ it->second };
+    }
+    ++m_stats.misses;
+
+    // stb 只输出 RGBA8；其它格式留给离线转换（Key 里先保留该字段）
+    if (format != bgfx::TextureFormat::RGBA8) {
+        spdlog::warn("[TexCache] format {} not supported yet, fallback RGBA8: {}", int(format), key.path);
+    }
+
+    streamable = streamable && m_streamStartDim > 0;
+    Decoded d;
+    decode(key.path, flipY, streamable, m_streamStartDim, m_keepPixelsDim, d);
+    if (d.w == 0) return {};
+
+    const uint32_t idx = newEntry(std::move(key), streamable);
+    if (dedupe(idx, d.fileHash)) return TexRef{ idx };
+    if (!upload(idx, d)) {
+        destroyEntry(idx);
+        return {};
+    }
+    return TexRef{ idx };
+}
+
+TexRef TextureCache::acquireAsync(const std::string& path, bool srgb, bool flipY,
+                                  bgfx::TextureFormat::Enum format, bool streamable) {
+    if (!m_jobs) return acquire(path, srgb, flipY, format, streamable);
+    if (path.empty()) return {};
+
+    Key key{ normalizePath(path), srgb, flipY, format };
+    auto it = m_lookup.find(key);
+    if (it != m_lookup.end()) {
+        ++m_stats.hits;
+        addRef(TexRef{ it->second });
+        return TexRef{ it->second };
+    }
+    ++m_stats.misses;
+
+    if (format != bgfx::TextureFormat::RGBA8) {
+        spdlog::warn("[TexCache] format {} not supported yet, fallback RGBA8: {}", int(format), key.path);
+    }
+
+    streamable = streamable && m_streamStartDim > 0;
+    std::string file = key.path;
+    const uint32_t idx = newEntry(std::move(key), streamable);
+    Entry& e = m_entries[idx];
+    e.loading = true;
+    ++m_stats.loading;
+
+    // 工作线程只做文件 IO + 解码 + mip 生成；bgfx 调用全部留在 update()
+    m_jobs->submit([this, idx, serial = e.serial, file = std::move(file), flipY, streamable,
+                    startDim = m_streamStartDim, keepDim = m_keepPixelsDim] {
+        Decoded d;
+        d.idx = idx;
+        d.serial = serial;
+        decode(file, flipY, streamable, startDim, keepDim, d);
+        std::lock_guard<std::mutex> lock(m_decodedMutex);
+        m_decoded.push_back(std::move(d));
+    });
+    return TexRef{ idx };
+}
+
+void TextureCache::update() {
+    std::vector<Decoded> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_decodedMutex);
+        if (m_decoded.empty()) return;
+        const size_t n = std::min<size_t>(m_decoded.size(), kMaxUploadsPerFrame);
+        ready.assign(std::make_move_iterator(m_decoded.begin()), std::make_move_iterator(m_decoded.begin() + n));
+        m_decoded.erase(m_decoded.begin(), m_decoded.begin() + n);
+    }
+
+    for (Decoded& d : ready) {
+        // 条目在解码期间被淘汰/复用：结果作废
+        if (d.idx >= m_entries.size()) continue;
+        Entry& e = m_entries[d.idx];
+        if (e.serial != d.serial || !e.loading) continue;
+        e.loading = false;
+        --m_stats.loading;
+
+        if (e.refs == 0) { // 解码完已无人要：不上传，直接丢掉
+            if (e.inLru) { m_lru.erase(e.lruIt); e.inLru = false; --m_stats.unreferenced; }
+            destroyEntry(d.idx);
+            continue;
+        }
+        if (d.w == 0) continue; // 失败：条目保留（避免反复重试），handle() 一直无效
+        if (dedupe(d.idx, d.fileHash) || upload(d.idx, d)) ++m_generation;
+    }
+}
+
+uint32_t TextureCache::newEntry(Key key, bool streamable) {
+    uint32_t idx;
+    if (!m_free.empty()) { idx = m_free.back(); m_free.pop_back(); m_entries[idx] = Entry{}; }
+    else { idx = (uint32_t)m_entries.size(); m_entries.emplace_back(); }
+
+    Entry& e = m_entries[idx];
+    e.key    = key;
+    e.refs   = 1;
+    e.serial = ++m_serial;
+    e.streamable = streamable;
+    m_lookup.emplace(std::move(key), idx);
+    ++m_stats.entries;
+    return idx;
+}
+
+void TextureCache::decode(const std::string& path, bool flipY, bool streamable, uint16_t startDim,
+                          uint16_t keepDim, Decoded& out) {
+    int w = 0, h = 0;
+    if (!loadImageRGBA(path, w, h, out.data, flipY, &out.fileHash)) {
+        out.w = out.h = 0;
+        return;
+    }
+    out.w = out.tw = w;
+    out.h = out.th = h;
+    out.firstMip = 0;
+
+    std::shared_ptr<TexPixels> keep;
+    if (keepDim > 0 && std::max(w, h) <= keepDim) {
+        keep = std::make_shared<TexPixels>();
+        keep->w = (uint16_t)w;
+        keep->h = (uint16_t)h;
+    }
+
+    // 流送：从 <= startDim 的那一级起上传完整的低 mip 链
+    if (streamable) {
+        while (std::max(w >> out.firstMip, h >> out.firstMip) > startDim) ++out.firstMip;
+        std::vector<uint8_t> chain;
+        buildMipChainRGBA(out.data.data(), w, h, out.firstMip, chain, out.tw, out.th);
+        out.data.swap(chain);
+        if (keep) keep->rgba.swap(chain); // 换出来的正是原图
+    } else if (keep) {
+        keep->rgba = out.data;
+    }
+    out.pixels = std::move(keep);
+}
+
+bool TextureCache::upload(uint32_t idx, Decoded& d) {
+    Entry& e = m_entries[idx];
+    const bool hasMips = e.streamable;
+
+    bgfx::TextureInfo info{};
+    bgfx::calcTextureSize(info, (uint16_t)d.tw, (uint16_t)d.th, 1, false, hasMips, 1, bgfx::TextureFormat::RGBA8);
+
+    // 先腾地方：只淘汰无人引用的条目；全被引用时只能超预算运行
+    if (m_stats.bytesResident + info.storageSize > m_stats.budgetBytes) {
+        const uint64_t target = m_stats.budgetBytes > info.storageSize ? m_stats.budgetBytes - info.storageSize : 0;
+        evictUntil(target);
+        if (m_stats.bytesResident + info.storageSize > m_stats.budgetBytes) {
+            spdlog::warn("[TexCache] over budget: {:.1f} MB resident (budget {:.1f} MB), all referenced",
+                         (m_stats.bytesResident + info.storageSize) / (1024.0 * 1024.0),
+                         m_stats.budgetBytes / (1024.0 * 1024.0));
+        }
+    }
+
+    const uint64_t flags = e.key.srgb ? BGFX_TEXTURE_SRGB : BGFX_TEXTURE_NONE;
+    const bgfx::Memory* mem = bgfx::copy(d.data.data(), (uint32_t)d.data.size());
+    bgfx::TextureHandle tex = bgfx::createTexture2D((uint16_t)d.tw, (uint16_t)d.th, hasMips, 1,
+                                                    bgfx::TextureFormat::RGBA8, flags, mem);
+    if (!bgfx::isValid(tex)) {
+        spdlog::error("[TexCache] createTexture2D failed: {}", e.key.path);
+        return false;
+    }
+
+    e.tex   = tex;
+    e.bytes = info.storageSize;
+    e.fullW = (uint16_t)d.w;
+    e.fullH = (uint16_t)d.h;
+    e.numMips     = hasMips ? mipCountFor(d.w, d.h) : 1;
+    e.residentMip = d.firstMip;
+    e.pixels      = std::move(d.pixels);
+    m_stats.bytesResident += e.bytes;
+    if (e.content) m_byContent.emplace(e.content, idx);
+    return true;
+}
+
+bool TextureCache::dedupe(uint32_t idx, uint64_t fileHash) {
+    Entry& e = m_entries[idx];
+    // 解码结果还受色彩空间 / 翻转 / 格式 / 流送影响：这些不同的同一文件不能共用
+    const uint64_t bits = uint64_t(e.key.srgb) | (uint64_t(e.key.flipY) << 1) |
+                          (uint64_t(e.streamable) << 2) | (uint64_t(e.key.format) << 8);
+    e.content = ke::hashCombine(fileHash, bits);
+    if (e.content == 0) e.content = 1; // 0 留给“还不知道”
+
+    auto it = m_byContent.find(e.content);
+    if (it == m_byContent.end() || it->second == idx) return false;
+    const uint32_t target = it->second;
+    addRef(TexRef{ target });
+    e.alias = target;
+    e.saved = m_entries[target].bytes;
+    ++m_stats.aliases;
+    m_stats.bytesDeduped += e.saved;
+    return true;
+}
+
+void TextureCache::addRef(TexRef r) {
+    if (!r.valid() || r.idx >= m_entries.size()) return;
+    Entry& e = m_entries[r.idx];
+    if (e.refs++ == 0 && e.inLru) {
+        m_lru.erase(e.lruIt);
+        e.inLru = false;
+        --m_stats.unreferenced;
+    }
+}
+
+void TextureCache::release(TexRef r) {
+    if (!r.valid() || r.idx >= m_entries.size()) return;
+    Entry& e = m_entries[r.idx];
+    if (e.refs == 0) return;
+    if (--e.refs == 0) {
+        if (e.alias != UINT32_MAX) {
+            // 别名不占显存，不进 LRU：直接拆掉，再归还它替自己持有的那份目标引用
+            const uint32_t target = e.alias;
+            destroyEntry(r.idx);
+            release(TexRef{ target });
+            return;
+        }
+        e.lruIt = m_lru.insert(m_lru.end(), r.idx);
+        e.inLru = true;
+        ++m_stats.unreferenced;
+        if (m_stats.bytesResident > m_stats.budgetBytes) evictUntil(m_stats.budgetBytes);
+    }
+}
+
+bgfx::TextureHandle TextureCache::handle(TexRef r) const {
+    if (!r.valid() || r.idx >= m_entries.size()) return BGFX_INVALID_HANDLE;
+    return m_entries[resolve(r).idx].tex;
+}
+
+const std::string* TextureCache::path(TexRef r) const {
+    if (!r.valid() || r.idx >= m_entries.size() || m_entries[r.idx].refs == 0) return nullptr;
+    return &m_entries[resolve(r).idx].key.path; // 同内容的贴图在纹理数组里也只占一层
+}
+
+TexRef TextureCache::resolve(TexRef r) const {
+    if (!r.valid() || r.idx >= m_entries.size()) return r;
+    const uint32_t alias = m_entries[r.idx].alias;
+    return alias != UINT32_MAX ? TexRef{ alias } : r;
+}
+
+bool TextureCache::loading(TexRef r) const {
+    return r.valid() && r.idx < m_entries.size() && m_entries[r.idx].loading;
+}
+
+std::shared_ptr<const TexPixels> TextureCache::pixels(TexRef r) const {
+    if (!r.valid() || r.idx >= m_entries.size() || m_entries[r.idx].refs == 0) return {};
+    return m_entries[resolve(r).idx].pixels;
+}
+
+void TextureCache::chargeExternal(uint64_t bytes) {
+    makeRoom(bytes);
+    m_stats.bytesResident += bytes;
+    m_stats.bytesExternal += bytes;
+    if (m_stats.bytesResident > m_stats.budgetBytes) {
+        spdlog::warn("[TexCache] over budget after external {:.1f} MB: {:.1f} MB resident (budget {:.1f} MB)",
+                     bytes / (1024.0 * 1024.0), m_stats.bytesResident / (1024.0 * 1024.0),
+                     m_stats.budgetBytes / (1024.0 * 1024.0));
+    }
+}
+
+void TextureCache::refundExternal(uint64_t bytes) {
+    bytes = std::min(bytes, m_stats.bytesExternal); // shutdown 已清零账目时不下溢
+    m_stats.bytesResident -= bytes;
+    m_stats.bytesExternal -= bytes;
+}
+
+void TextureCache::setBudget(uint64_t bytes) {
+    m_stats.budgetBytes = bytes;
+    evictUntil(bytes);
+}
+
+void TextureCache::evictUntil(uint64_t targetBytes) {
+    while (m_stats.bytesResident > targetBytes && !m_lru.empty()) {
+        const uint32_t idx = m_lru.front();
+        m_lru.pop_front();
+        m_entries[idx].inLru = false;
+        --m_stats.unreferenced;
+        destroyEntry(idx);
+        ++m_stats.evictions;
+    }
+}
+
+void TextureCache::destroyEntry(uint32_t idx) {
+    Entry& e = m_entries[idx];
+    if (bgfx::isValid(e.tex)) bgfx::destroy(e.tex);
+    m_lookup.erase(e.key);
+    auto it = m_byContent.find(e.content);
+    if (it != m_byContent.end() && it->second == idx) m_byContent.erase(it);
+    if (e.alias != UINT32_MAX) {
+        --m_stats.aliases;
+        m_stats.bytesDeduped -= e.saved;
+    }
+    if (e.loading) --m_stats.loading;
+    m_stats.bytesResident -= e.bytes;
+    --m_stats.entries;
+    e = Entry{};
+    m_free.push_back(idx);
+}
+
+void TextureCache::setStreaming(bool enabled, uint16_t startDim) {
+    m_streamStartDim = enabled ? std::max<uint16_t>(1, startDim) : 0;
+}
+
+bool TextureCache::streamInfo(uint32_t idx, StreamInfo& out) const {
+    if (idx >= m_entries.size()) return false;
+    const Entry& e = m_entries[idx];
+    if (!e.streamable || !bgfx::isValid(e.tex)) return false;
+    out.path        = e.key.path;
+    out.srgb        = e.key.srgb;
+    out.flipY       = e.key.flipY;
+    out.fullW       = e.fullW;
+    out.fullH       = e.fullH;
+    out.numMips     = e.numMips;
+    out.residentMip = e.residentMip;
+    out.bytes       = e.bytes;
+    out.serial      = e.serial;
+    return true;
+}
+
+bool TextureCache::replaceTexture(uint32_t idx, uint32_t serial, bgfx::TextureHandle tex,
+                                  uint64_t bytes, uint8_t residentMip) {
+    if (idx >= m_entries.size() || m_entries[idx].serial != serial || !bgfx::isValid(m_entries[idx].tex)) {
+        if (bgfx::isValid(tex)) bgfx::destroy(tex);
+        return false;
+    }
+    Entry& e = m_entries[idx];
+    bgfx::destroy(e.tex);
+    m_stats.bytesResident = m_stats.bytesResident - e.bytes + bytes;
+    e.tex = tex;
+    e.bytes = bytes;
+    e.residentMip = residentMip;
+    ++m_generation;
+    return true;
+}
+
+void TextureCache::makeRoom(uint64_t bytes) {
+    if (m_stats.bytesResident + bytes <= m_stats.budgetBytes) return;
+    evictUntil(m_stats.budgetBytes > bytes ? m_stats.budgetBytes - bytes : 0);
+}
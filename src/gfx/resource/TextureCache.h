@@ -0,0 +1,175 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 名称速记：TextureCache = 全引擎唯一的纹理缓存
+// - Key：(路径, 色彩空间, 是否翻转, 格式)，同一路径的 sRGB/Linear 各占一份
+// - 内容去重：读文件时顺带算 XXH64；路径不同但内容（及上述参数）相同的条目成为“别名”，
+//   不上传，handle() 返回已驻留那份的句柄；别名持有目标一份引用，自己引用归零即拆掉
+// - TexRef：引用计数句柄；acquire +1，release -1
+// - 预算：bytesResident 超出预算时，按 LRU 淘汰“无人引用”的条目（被引用的永不淘汰）
+// - 异步：acquireAsync 立刻返回 TexRef，解码在 JobSystem 上做，update() 里上传；
+//   上传前 handle() 返回无效句柄，调用方自己绑占位纹理
+// - 流送：streamable 条目先以低 mip 驻留，由 TextureStreamer 按需换成更高/更低的 mip 链；
+//   换句柄时 generation() 递增，持有裸句柄的一方（材质）据此重新解析
+// - 像素：setKeepPixels 打开后，不超过该尺寸的纹理解码完保留一份 mip0 像素，纹理数组打包直接取用，不再二次解码
+// - 外部纹理：缓存之外但同样吃显存的纹理（纹理数组）用 chargeExternal / refundExternal 记进同一份预算
+
+namespace ke { class JobSystem; }
+
+struct TexRef {
+    uint32_t idx = UINT32_MAX;
+    bool valid() const { return idx != UINT32_MAX; }
+};
+
+// 解码后的 mip0 像素（RGBA8，已按条目的 flipY 翻转）
+struct TexPixels {
+    uint16_t w = 0, h = 0;
+    std::vector<uint8_t> rgba;
+};
+
+class TextureCache {
+public:
+    static constexpr uint64_t kDefaultBudget = 512ull * 1024 * 1024; // 512 MB
+
+    struct Stats {
+        uint64_t bytesResident = 0; // 当前驻留的纹理字节数（估算值，含 mip）
+        uint64_t budgetBytes   = 0; // 预算
+        uint64_t hits          = 0; // acquire 命中
+        uint64_t misses        = 0; // acquire 未命中（需要加载）
+        uint64_t evictions     = 0; // 被淘汰的条目数
+        uint32_t entries       = 0; // 当前条目数
+        uint32_t unreferenced  = 0; // 其中无人引用（可淘汰）的条目数
+        uint32_t loading       = 0; // 正在异步解码的条目数
+        uint32_t aliases       = 0; // 其中按内容命中、共用别的条目纹理的别名数
+        uint64_t bytesDeduped  = 0; // 别名省下的显存（按命中时目标的大小计）
+        uint64_t bytesExternal = 0; // bytesResident 里缓存外的纹理（纹理数组）
+    };
+
+    bool init(uint64_t budgetBytes = kDefaultBudget);
+    void shutdown(); // 销毁全部纹理（不管引用计数）
+
+    // 取得（必要时加载）纹理并 +1 引用；失败返回无效 TexRef
+    // streamable：开启流送时只上传 <= startDim 的低 mip，其余交给 TextureStreamer
+    TexRef acquire(const std::string& path, bool srgb, bool flipY = true,
+                   bgfx::TextureFormat::Enum format = bgfx::TextureFormat::RGBA8,
+                   bool streamable = false);
+    // 不阻塞版本：未命中时登记条目并把解码丢给 JobSystem（没设置 JobSystem 时退化为同步）
+    TexRef acquireAsync(const std::string& path, bool srgb, bool flipY = true,
+                        bgfx::TextureFormat::Enum format = bgfx::TextureFormat::RGBA8,
+                        bool streamable = false);
+    void addRef(TexRef r);
+    void release(TexRef r); // 引用归零后进入 LRU，等预算不够时才真正销毁
+
+    bgfx::TextureHandle handle(TexRef r) const; // 仍在解码或解码失败时返回无效句柄
+    const std::string* path(TexRef r) const;    // 条目的规整路径（别名给目标的）；无效引用返回 nullptr
+    TexRef resolve(TexRef r) const;             // 别名 → 真正持有纹理的条目；其它原样返回
+    bool loading(TexRef r) const;               // 还在后台解码
+    // 保留的 mip0 像素（别名给目标的）；解码中 / 失败 / 超过 keepPixels 尺寸时返回空
+    std::shared_ptr<const TexPixels> pixels(TexRef r) const;
+    // 之后解码的纹理里，不超过 maxDim 的保留 mip0 像素（0 = 不保留）；已驻留的条目不补
+    void setKeepPixels(uint16_t maxDim) { m_keepPixelsDim = maxDim; }
+
+    void setJobSystem(ke::JobSystem* jobs) { m_jobs = jobs; }
+    // 每帧（主线程）调用：上传已解码完的纹理；有句柄变化时 generation() 递增
+    void update();
+
+    void setBudget(uint64_t bytes); // 立即按新预算淘汰
+    // 缓存外的纹理记账：charge 先按预算淘汰无人引用的条目腾地方，refund 在那张纹理销毁时调用
+    void chargeExternal(uint64_t bytes);
+    void refundExternal(uint64_t bytes);
+    uint64_t budget() const { return m_stats.budgetBytes; }
+    const Stats& stats() const { return m_stats; }
+
+    // ===== 流送支持（供 TextureStreamer 使用）=====
+    struct StreamInfo {
+        std::string path;
+        bool     srgb = false, flipY = true;
+        uint16_t fullW = 0, fullH = 0; // mip0 尺寸
+        uint8_t  numMips = 1;          // 完整链级数
+        uint8_t  residentMip = 0;      // 当前驻留的最高一级
+        uint64_t bytes = 0;
+        uint32_t serial = 0;           // 槽位复用计数：异步结果回来时校验条目没换人
+    };
+    void setStreaming(bool enabled, uint16_t startDim = 64);
+    bool streaming() const { return m_streamStartDim > 0; }
+    uint16_t streamStartDim() const { return m_streamStartDim; }
+    uint32_t capacity() const { return (uint32_t)m_entries.size(); }
+    bool streamInfo(uint32_t idx, StreamInfo& out) const; // 仅对 streamable 且存活的条目返回 true
+    // 用新的 mip 链纹理替换条目（serial 不符则丢弃 tex 并返回 false）；旧纹理立即销毁
+    bool replaceTexture(uint32_t idx, uint32_t serial, bgfx::TextureHandle tex,
+                        uint64_t bytes, uint8_t residentMip);
+    void makeRoom(uint64_t bytes); // 淘汰无人引用的条目，尽量腾出 bytes
+    uint32_t generation() const { return m_generation; }
+
+private:
+    struct Key {
+        std::string path;
+        bool srgb = false;
+        bool flipY = true;
+        bgfx::TextureFormat::Enum format = bgfx::TextureFormat::RGBA8;
+        bool operator==(const Key& o) const {
+            return srgb == o.srgb && flipY == o.flipY && format == o.format && path == o.path;
+        }
+    };
+    struct KeyHash { size_t operator()(const Key& k) const; };
+
+    struct Entry {
+        Key key;
+        bgfx::TextureHandle tex = BGFX_INVALID_HANDLE;
+        uint64_t bytes = 0;
+        uint32_t refs = 0;
+        uint32_t serial = 0;
+        bool inLru = false;
+        bool streamable = false;
+        bool loading = false;
+        uint16_t fullW = 0, fullH = 0;
+        uint8_t numMips = 1, residentMip = 0;
+        uint64_t content = 0;          // 内容键（文件哈希 + Key 参数）；0 = 还不知道
+        uint32_t alias = UINT32_MAX;   // 别名的目标条目
+        uint64_t saved = 0;            // 别名：记进 bytesDeduped 的字节
+        std::shared_ptr<const TexPixels> pixels; // 保留的 mip0（见 setKeepPixels）
+        std::list<uint32_t>::iterator lruIt;
+    };
+
+    std::vector<Entry>    m_entries;
+    std::vector<uint32_t> m_free;   // 可复用的条目槽位
+    std::unordered_map<Key, uint32_t, KeyHash> m_lookup;
+    std::unordered_map<uint64_t, uint32_t> m_byContent; // 内容键 → 持有纹理的条目（不含别名）
+    std::list<uint32_t>   m_lru;    // 无人引用的条目；front = 最久未使用
+    Stats m_stats;
+    uint32_t m_serial = 0;
+    uint32_t m_generation = 0;
+    uint16_t m_streamStartDim = 0; // 0 = 不流送
+    uint16_t m_keepPixelsDim = 0;  // 0 = 不保留像素
+
+    // 异步解码结果（工作线程写，update() 读）
+    struct Decoded {
+        uint32_t idx = 0, serial = 0;
+        int w = 0, h = 0;          // 原图尺寸；0 = 失败
+        int tw = 0, th = 0;        // 上传的首级尺寸
+        uint8_t firstMip = 0;
+        uint64_t fileHash = 0;     // 源文件内容的 XXH64
+        std::vector<uint8_t> data; // RGBA8；streamable 时为 firstMip.. 的完整链
+        std::shared_ptr<const TexPixels> pixels; // 尺寸不超过 keepDim 时的 mip0
+    };
+    static constexpr uint32_t kMaxUploadsPerFrame = 8; // 单帧上传上限，避免集中卡顿
+    ke::JobSystem*       m_jobs = nullptr;
+    std::mutex           m_decodedMutex;
+    std::vector<Decoded> m_decoded;
+
+    uint32_t newEntry(Key key, bool streamable);
+    static void decode(const std::string& path, bool flipY, bool streamable, uint16_t startDim,
+                       uint16_t keepDim, Decoded& out);
+    bool upload(uint32_t idx, Decoded& d); // 创建 bgfx 纹理并记账；失败返回 false
+    // 记下内容键；已有同内容的驻留条目时把 idx 变成它的别名并返回 true（不用再上传）
+    bool dedupe(uint32_t idx, uint64_t fileHash);
+    void evictUntil(uint64_t targetBytes); // 从 LRU 头部淘汰，直到驻留量 <= targetBytes
+    void destroyEntry(uint32_t idx);
+};
@@ -0,0 +1,217 @@
+#include "ProgramRegistry.h"
+#include "shader_utils.h"
+#include "core/JobSystem.h"
+#include <spdlog/spdlog.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+size_t ProgramRegistry::KeyHash::operator()(const Key& k) const {
+    size_t h = std::hash<std::string>{}(k.vs);
+    h ^= std::hash<std::string>{}(k.fs) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    h ^= std::hash<uint32_t>{}(k.permutation) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+std::string ProgramRegistry::permutationFile(const std::string& base, uint32_t mask) {
+    static const char* hex = "0123456789abcdef";
+    std::string digits;
+    do { digits.insert(digits.begin(), hex[mask & 0xf]); mask >>= 4; } while (mask);
+    if (digits.size() < 2) digits.insert(digits.begin(), '0');
+    return base + "_p" + digits + ".bin";
+}
+
+std::string ProgramRegistry::fsFileOf(const Key& k) {
+    return k.permutation == kNoPermutation ? k.fs : permutationFile(k.fs, k.permutation);
+}
+
+ProgramRef ProgramRegistry::acquire(const std::string& vs, const std::string& fs, uint32_t permutation) {
+    Key key{ vs, fs, permutation };
+    auto it = m_lookup.find(key);
+    if (it != m_lookup.end()) {
+        ++m_stats.hits;
+        addRef(ProgramRef{ it->second });
+        return ProgramRef{ it->second };
+    }
+    if (m_failed.count(key)) return {};
+
+    const std::string fsFile = fsFileOf(key);
+    bgfx::ShaderHandle vsh = acquireShader(vs);
+    bgfx::ShaderHandle fsh = acquireShader(fsFile);
+    bgfx::ProgramHandle prog = BGFX_INVALID_HANDLE;
+    if (bgfx::isValid(vsh) && bgfx::isValid(fsh))
+        prog = bgfx::createProgram(vsh, fsh, /*destroyShaders*/false);
+    if (!bgfx::isValid(prog)) {
+        spdlog::error("[Programs] failed: vs='{}' fs='{}'", vs, fsFile);
+        releaseShader(vs);
+        releaseShader(fsFile);
+        m_failed.emplace(std::move(key), true);
+        return {};
+    }
+    ++m_stats.misses;
+    ++m_stats.programs;
+
+    uint32_t idx;
+    if (!m_free.empty()) { idx = m_free.back(); m_free.pop_back(); }
+    else { idx = (uint32_t)m_entries.size(); m_entries.emplace_back(); }
+    Entry& e = m_entries[idx];
+    e.key = key;
+    e.program = prog;
+    e.refs = 1;
+    m_lookup.emplace(std::move(key), idx);
+    return ProgramRef{ idx };
+}
+
+void ProgramRegistry::addRef(ProgramRef r) {
+    if (!r.valid() || r.idx >= m_entries.size()) return;
+    ++m_entries[r.idx].refs;
+}
+
+void ProgramRegistry::release(ProgramRef r) {
+    if (!r.valid() || r.idx >= m_entries.size()) return;
+    Entry& e = m_entries[r.idx];
+    if (e.refs == 0 || --e.refs > 0) return;
+
+    // bgfx 的 destroy 会延后到在途帧结束，这里可以直接销毁
+    bgfx::destroy(e.program);
+    releaseShader(e.key.vs);
+    releaseShader(fsFileOf(e.key));
+    m_lookup.erase(e.key);
+    e = Entry{};
+    m_free.push_back(r.idx);
+    --m_stats.programs;
+}
+
+bgfx::ProgramHandle ProgramRegistry::handle(ProgramRef r) const {
+    if (!r.valid() || r.idx >= m_entries.size()) return BGFX_INVALID_HANDLE;
+    return m_entries[r.idx].program;
+}
+
+bgfx::ShaderHandle ProgramRegistry::acquireShader(const std::string& file) {
+    auto it = m_shaders.find(file);
+    if (it != m_shaders.end()) {
+        ++it->second.refs;
+        return it->second.handle;
+    }
+    bgfx::ShaderHandle h = ke_loadShaderFile(file);
+    if (!bgfx::isValid(h)) return h;
+    m_shaders.emplace(file, Shader{ h, 1 });
+    ++m_stats.shaders;
+    return h;
+}
+
+void ProgramRegistry::releaseShader(const std::string& file) {
+    auto it = m_shaders.find(file);
+    if (it == m_shaders.end()) return;
+    if (--it->second.refs > 0) return;
+    bgfx::destroy(it->second.handle);
+    m_shaders.erase(it);
+    --m_stats.shaders;
+}
+
+void ProgramRegistry::reload(const std::string& dir, const std::vector<std::string>& files) {
+    for (const std::string& file : files) {
+        if (!m_shaders.count(file)) {
+            // 新出现的文件（比如补编了缺失的排列）：让之前的失败记录失效，下次 acquire 重试
+            if (!m_failed.empty()) { m_failed.clear(); ++m_generation; }
+            continue;
+        }
+        if (!m_inFlight.insert(file).second) continue; // 已在读
+        ++m_stats.pendingReloads;
+
+        const std::string path = (std::filesystem::path(dir) / file).string();
+        auto job = [this, file, path] {
+            Reloaded r;
+            r.file = file;
+            std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+            const std::streamoff size = ifs ? (std::streamoff)ifs.tellg() : 0;
+            if (size > 0) {
+                r.bytes.resize((size_t)size);
+                ifs.seekg(0);
+                if (!ifs.read((char*)r.bytes.data(), size)) r.bytes.clear();
+            }
+            std::lock_guard<std::mutex> lock(m_reloadMutex);
+            m_reloaded.push_back(std::move(r));
+        };
+        if (m_jobs) m_jobs->submit(std::move(job));
+        else job();
+    }
+}
+
+void ProgramRegistry::reloadAll(const std::string& dir) {
+    std::vector<std::string> files;
+    files.reserve(m_shaders.size());
+    for (auto& kv : m_shaders) files.push_back(kv.first);
+    reload(dir, files);
+}
+
+void ProgramRegistry::update() {
+    std::vector<Reloaded> done;
+    {
+        std::lock_guard<std::mutex> lock(m_reloadMutex);
+        done.swap(m_reloaded);
+    }
+    if (done.empty()) return;
+
+    // 1) 先把新字节全部建成 shader；任何一个失败都只影响它自己
+    std::unordered_map<std::string, bgfx::ShaderHandle> fresh;
+    for (Reloaded& r : done) {
+        m_inFlight.erase(r.file);
+        --m_stats.pendingReloads;
+        if (!m_shaders.count(r.file)) continue; // 读取期间已被释放
+        if (r.bytes.empty()) { spdlog::warn("[Programs] reload read failed: {}", r.file); continue; }
+        bgfx::ShaderHandle h = bgfx::createShader(bgfx::copy(r.bytes.data(), (uint32_t)r.bytes.size()));
+        if (!bgfx::isValid(h)) { spdlog::error("[Programs] reload createShader failed: {}", r.file); continue; }
+        if (auto old = fresh.find(r.file); old != fresh.end()) bgfx::destroy(old->second); // 同帧读了两次
+        fresh[r.file] = h;
+    }
+    if (fresh.empty()) return;
+
+    // 2) 只重建用到这些 shader 的 program；建不出来就留着旧的
+    uint32_t rebuilt = 0;
+    for (Entry& e : m_entries) {
+        if (!bgfx::isValid(e.program)) continue;
+        const std::string fsFile = fsFileOf(e.key);
+        auto v = fresh.find(e.key.vs);
+        auto f = fresh.find(fsFile);
+        if (v == fresh.end() && f == fresh.end()) continue;
+        const bgfx::ShaderHandle vsh = v != fresh.end() ? v->second : m_shaders[e.key.vs].handle;
+        const bgfx::ShaderHandle fsh = f != fresh.end() ? f->second : m_shaders[fsFile].handle;
+        const bgfx::ProgramHandle p = bgfx::createProgram(vsh, fsh, /*destroyShaders*/false);
+        if (!bgfx::isValid(p)) {
+            spdlog::error("[Programs] reload link failed: vs='{}' fs='{}', keeping old program", e.key.vs, fsFile);
+            continue;
+        }
+        bgfx::destroy(e.program);
+        e.program = p;
+        ++rebuilt;
+    }
+
+    // 3) 换上新 shader 句柄；bgfx 内部对 shader 计引用，仍被旧 program 用着的不会提前释放
+    for (auto& [file, h] : fresh) {
+        Shader& s = m_shaders[file];
+        bgfx::destroy(s.handle);
+        s.handle = h;
+    }
+    m_failed.clear();
+    m_stats.reloads += rebuilt;
+    ++m_generation;
+    spdlog::info("[Programs] reloaded {} shader(s), rebuilt {} program(s)", fresh.size(), rebuilt);
+}
+
+void ProgramRegistry::shutdown() {
+    for (auto& e : m_entries)
+        if (bgfx::isValid(e.program)) bgfx::destroy(e.program);
+    for (auto& kv : m_shaders) bgfx::destroy(kv.second.handle);
+    m_entries.clear();
+    m_free.clear();
+    m_lookup.clear();
+    m_shaders.clear();
+    m_failed.clear();
+    m_inFlight.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_reloadMutex);
+        m_reloaded.clear();
+    }
+    m_stats = {};
+}
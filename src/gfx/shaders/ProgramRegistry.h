@@ -0,0 +1,104 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+
+// 名称速记：ProgramRegistry = 全引擎共享的 bgfx program 表
+// - Key：(vs 文件, fs 文件/基名, 排列掩码)；同一组合只创建一个 program
+// - ProgramRef：引用计数句柄；acquire +1，release -1，归零时销毁 program
+// - 着色器同样按文件名共享（一个 vs 常被几十个排列复用），随最后一个 program 一起销毁
+// - 加载失败也会记下来：同一组合不再反复读盘/刷日志，直到 shutdown() 或有着色器重载
+// - 热重载：reload() 在 JobSystem 上读新字节，update() 在帧边界一次性换上新 shader/program；
+//   ProgramRef 不变，handle() 换新，generation() 递增——缓存了裸句柄的一方据此重新取
+
+namespace ke { class JobSystem; }
+
+struct ProgramRef {
+    uint32_t idx = UINT32_MAX;
+    bool valid() const { return idx != UINT32_MAX; }
+};
+
+class ProgramRegistry {
+public:
+    static constexpr uint32_t kNoPermutation = UINT32_MAX;
+
+    struct Stats {
+        uint32_t programs = 0; // 存活的 program
+        uint32_t shaders  = 0; // 存活的 shader
+        uint64_t hits     = 0; // acquire 命中
+        uint64_t misses   = 0; // acquire 新建
+        uint32_t reloads  = 0; // 热重载重建过的 program 次数
+        uint32_t pendingReloads = 0; // 正在后台读取的着色器
+    };
+
+    // fs：permutation == kNoPermutation 时是完整文件名（fs_mesh.bin），
+    //     否则是基名，实际文件为 permutationFile(fs, permutation)
+    ProgramRef acquire(const std::string& vs, const std::string& fs,
+                       uint32_t permutation = kNoPermutation);
+    void addRef(ProgramRef r);
+    void release(ProgramRef r);
+
+    bgfx::ProgramHandle handle(ProgramRef r) const; // 无效引用返回无效句柄
+
+    void shutdown(); // 销毁全部 program/shader（不管引用计数）
+
+    // ===== 热重载 =====
+    void setJobSystem(ke::JobSystem* jobs) { m_jobs = jobs; }
+    // files：改动过的文件名（不含目录），从 dir 读取；不认识的文件只会让“失败记录”失效
+    void reload(const std::string& dir, const std::vector<std::string>& files);
+    void reloadAll(const std::string& dir);
+    // 每帧（主线程）调用：换上已读完的着色器，只重建引用了它们的 program
+    void update();
+    uint32_t generation() const { return m_generation; }
+
+    const Stats& stats() const { return m_stats; }
+
+    // 排列文件名：基名 + "_p" + 十六进制掩码（至少两位），如 fs_pbr_mr_p2b.bin、fs_pbr_mr_p107.bin
+    static std::string permutationFile(const std::string& base, uint32_t mask);
+
+private:
+    struct Key {
+        std::string vs, fs;
+        uint32_t permutation = kNoPermutation;
+        bool operator==(const Key& o) const {
+            return permutation == o.permutation && vs == o.vs && fs == o.fs;
+        }
+    };
+    struct KeyHash { size_t operator()(const Key& k) const; };
+
+    struct Shader {
+        bgfx::ShaderHandle handle = BGFX_INVALID_HANDLE;
+        uint32_t refs = 0; // 引用它的 program 数
+    };
+    struct Entry {
+        Key key;
+        bgfx::ProgramHandle program = BGFX_INVALID_HANDLE;
+        uint32_t refs = 0;
+    };
+
+    bgfx::ShaderHandle acquireShader(const std::string& file);
+    void releaseShader(const std::string& file);
+    static std::string fsFileOf(const Key& k);
+
+    struct Reloaded {
+        std::string file;
+        std::vector<uint8_t> bytes; // 空 = 读取失败
+    };
+
+    std::vector<Entry>    m_entries;
+    std::vector<uint32_t> m_free;
+    std::unordered_map<Key, uint32_t, KeyHash> m_lookup;
+    std::unordered_map<std::string, Shader>    m_shaders;
+    std::unordered_map<Key, bool, KeyHash>     m_failed; // 加载失败过的组合
+    Stats m_stats;
+
+    ke::JobSystem* m_jobs = nullptr;
+    uint32_t m_generation = 0;
+    std::unordered_set<std::string> m_inFlight; // 正在读取的文件（主线程）
+    std::mutex            m_reloadMutex;        // 保护 m_reloaded（工作线程写）
+    std::vector<Reloaded> m_reloaded;
+};
@@ -0,0 +1,120 @@
+#include "ShaderArchive.h"
+#include "ShaderArchiveFormat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace ke::shaderpak;
+
+bool ShaderArchive::open(const std::string &path)
+{
+    close();
+
+#if defined(_WIN32)
+    const int wlen = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring wpath(wlen > 0 ? wlen - 1 : 0, L'\0');
+    if (wlen > 0)
+        MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wpath.data(), wlen);
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER sz{};
+    GetFileSizeEx(file, &sz);
+    HANDLE mapping = sz.QuadPart > 0 ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_base = (const uint8_t *)view;
+    m_size = (uint64_t)sz.QuadPart;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void *view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // 映射建立后 fd 可以关掉
+    if (view == MAP_FAILED)
+        return false;
+    m_base = (const uint8_t *)view;
+    m_size = (uint64_t)st.st_size;
+#endif
+
+    // 校验：头、索引范围、每个条目的数据范围
+    const Header *hdr = (const Header *)m_base;
+    bool ok = m_size >= sizeof(Header) && hdr->magic == kMagic && hdr->version == kVersion &&
+              m_size >= sizeof(Header) + uint64_t(hdr->count) * sizeof(Entry);
+    const Entry *index = (const Entry *)(m_base + sizeof(Header));
+    for (uint32_t i = 0; ok && i < hdr->count; ++i)
+        ok = uint64_t(index[i].offset) + index[i].size <= m_size && index[i].name[kNameLen - 1] == '\0';
+    if (!ok)
+    {
+        spdlog::error("[ShaderPak] invalid archive: {}", path);
+        close();
+        return false;
+    }
+
+    m_count = hdr->count;
+    m_path = path;
+    spdlog::info("[ShaderPak] mapped {} ({} shaders, {} KB)", path, m_count, m_size / 1024);
+    return true;
+}
+
+void ShaderArchive::close()
+{
+    if (!m_base)
+        return;
+#if defined(_WIN32)
+    UnmapViewOfFile(m_base);
+    CloseHandle((HANDLE)m_mapping);
+    CloseHandle((HANDLE)m_file);
+    m_file = m_mapping = nullptr;
+#else
+    munmap((void *)m_base, (size_t)m_size);
+#endif
+    m_base = nullptr;
+    m_size = 0;
+    m_count = 0;
+    m_path.clear();
+}
+
+bool ShaderArchive::find(const std::string &name, const uint8_t *&data, uint32_t &size) const
+{
+    if (!m_base)
+        return false;
+    const Entry *begin = (const Entry *)(m_base + sizeof(Header));
+    const Entry *end = begin + m_count;
+    const Entry *it = std::lower_bound(begin, end, name, [](const Entry &e, const std::string &n) {
+        return std::strcmp(e.name, n.c_str()) < 0;
+    });
+    if (it == end || name != it->name)
+        return false;
+    data = m_base + it->offset;
+    size = it->size;
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// 只读映射一个着色器包（格式见 ShaderArchiveFormat.h）
+// - open() 后整个文件 mmap 进来，find() 返回指向映射内的指针，不拷贝
+// - 交给 bgfx::makeRef 的内存要活到 bgfx 处理完命令：映射在 close() 前一直有效，
+//   Renderer 在 bgfx::shutdown() 之后才关闭
+class ShaderArchive {
+public:
+    ShaderArchive() = default;
+    ~ShaderArchive() { close(); }
+    ShaderArchive(const ShaderArchive&) = delete;
+    ShaderArchive& operator=(const ShaderArchive&) = delete;
+
+    bool open(const std::string& path); // 校验文件头与索引；失败时保持关闭状态
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+    const std::string& path() const { return m_path; }
+
+    // name：不含目录的文件名（"vs_pbr.bin"）；找不到返回 false
+    bool find(const std::string& name, const uint8_t*& data, uint32_t& size) const;
+    uint32_t count() const { return m_count; }
+
+private:
+    const uint8_t* m_base = nullptr;
+    uint64_t       m_size = 0;
+    uint32_t       m_count = 0;
+    std::string    m_path;
+#if defined(_WIN32)
+    void* m_file = nullptr;    // HANDLE
+    void* m_mapping = nullptr; // HANDLE
+#endif
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+// 着色器包（shaders/<backend>.pak）的磁盘格式；打包工具 tools/shaderpack 与运行时共用
+// [Header][Entry × count（按 name 升序，便于二分）][数据区，每块按 kAlign 对齐]
+// 所有整数为小端；文件整体 mmap 后直接当结构体读
+namespace ke::shaderpak {
+
+constexpr uint32_t kMagic   = 0x5053454B; // "KESP"
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kAlign   = 16;
+constexpr uint32_t kNameLen = 56;         // 含结尾 0；超长文件名打包时报错
+
+struct Header {
+    uint32_t magic   = kMagic;
+    uint32_t version = kVersion;
+    uint32_t count   = 0;
+    uint32_t reserved = 0;
+};
+
+struct Entry {
+    char     name[kNameLen] = {}; // 文件名（不含目录），如 "fs_pbr_mr_p2b.bin"
+    uint32_t offset = 0;          // 相对文件头
+    uint32_t size   = 0;
+};
+
+static_assert(sizeof(Header) == 16, "pak header layout");
+static_assert(sizeof(Entry) == 64, "pak entry layout");
+
+} // namespace ke::shaderpak
@@ -0,0 +1,208 @@
+#include "ShaderCache.h"
+#include <SDL.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+void ShaderCache::init(const std::string& root, uint64_t maxBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    if (!root.empty()) {
+        m_root = fs::path(root);
+    } else {
+        char* pref = SDL_GetPrefPath("K-ENGINE", "KEngine");
+        m_root = (pref ? fs::path(pref) : fs::current_path()) / "shadercache";
+        if (pref) SDL_free(pref);
+    }
+    m_dir.clear();
+    m_items.clear();
+    m_stats = {};
+}
+
+void ShaderCache::setDevice(bgfx::RendererType::Enum renderer, uint16_t vendorId, uint16_t deviceId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    char sub[64];
+    std::snprintf(sub, sizeof(sub), "%s_%04x_%04x", bgfx::getRendererName(renderer), vendorId, deviceId);
+    m_dir = m_root / sub;
+    m_items.clear();
+    m_stats.bytes = 0;
+
+    std::error_code ec;
+    fs::create_directories(m_dir, ec);
+    if (ec) {
+        spdlog::warn("[ShaderCache] cannot create {}: {}, cache disabled", m_dir.string(), ec.message());
+        m_dir.clear();
+        return;
+    }
+
+    // 扫描已有条目：按修改时间排出初始的使用顺序；残留的临时文件直接清掉
+    std::vector<std::pair<fs::file_time_type, uint64_t>> order;
+    for (const auto& de : fs::directory_iterator(m_dir, ec)) {
+        if (!de.is_regular_file(ec)) continue;
+        const fs::path p = de.path();
+        if (p.extension() != ".bin") { fs::remove(p, ec); continue; }
+        char* end = nullptr;
+        const std::string stem = p.stem().string();
+        const uint64_t id = std::strtoull(stem.c_str(), &end, 16);
+        if (stem.size() != 16 || !end || *end) continue;
+        m_items[id].bytes = de.file_size(ec);
+        m_stats.bytes += m_items[id].bytes;
+        order.push_back({ de.last_write_time(ec), id });
+    }
+    std::sort(order.begin(), order.end());
+    for (auto& [t, id] : order) m_items[id].lastUse = ++m_clock;
+    m_stats.entries = (uint32_t)m_items.size();
+
+    evictLocked(m_maxBytes);
+    spdlog::info("[ShaderCache] {}: {} entries, {:.1f} MB", m_dir.string(), m_stats.entries,
+                 m_stats.bytes / (1024.0 * 1024.0));
+}
+
+ShaderCache::Stats ShaderCache::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+fs::path ShaderCache::fileFor(uint64_t id) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)id);
+    return m_dir / name;
+}
+
+uint64_t ShaderCache::checksum(const void* data, uint32_t size) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    const uint8_t* p = (const uint8_t*)data;
+    for (uint32_t i = 0; i < size; ++i) { h ^= p[i]; h *= 0x100000001b3ull; }
+    return h;
+}
+
+void ShaderCache::dropLocked(uint64_t id) {
+    auto it = m_items.find(id);
+    if (it == m_items.end()) return;
+    std::error_code ec;
+    fs::remove(fileFor(id), ec);
+    m_stats.bytes -= std::min(m_stats.bytes, it->second.bytes);
+    m_items.erase(it);
+    m_stats.entries = (uint32_t)m_items.size();
+}
+
+void ShaderCache::evictLocked(uint64_t targetBytes) {
+    while (m_stats.bytes > targetBytes && !m_items.empty()) {
+        auto victim = std::min_element(m_items.begin(), m_items.end(),
+                                       [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+        dropLocked(victim->first);
+        ++m_stats.evictions;
+    }
+}
+
+uint32_t ShaderCache::cacheReadSize(uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_dir.empty() || !m_items.count(id)) { ++m_stats.misses; return 0; }
+
+    std::ifstream ifs(fileFor(id), std::ios::binary | std::ios::ate);
+    FileHeader hdr;
+    const uint64_t fileSize = ifs ? (uint64_t)ifs.tellg() : 0;
+    ifs.seekg(0);
+    const bool ok = ifs && fileSize >= sizeof(hdr) && ifs.read((char*)&hdr, sizeof(hdr))
+                 && hdr.magic == FileHeader{}.magic && hdr.version == FileHeader{}.version
+                 && fileSize == sizeof(hdr) + hdr.size;
+    if (!ok) {
+        ifs.close();
+        dropLocked(id);
+        ++m_stats.rejected;
+        ++m_stats.misses;
+        return 0;
+    }
+    return hdr.size;
+}
+
+bool ShaderCache::cacheRead(uint64_t id, void* data, uint32_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_dir.empty()) return false;
+
+    std::ifstream ifs(fileFor(id), std::ios::binary);
+    FileHeader hdr;
+    bool ok = ifs && ifs.read((char*)&hdr, sizeof(hdr)) && hdr.size == size
+           && ifs.read((char*)data, size) && checksum(data, size) == hdr.checksum;
+    if (!ok) {
+        // 损坏/被截断：删掉，bgfx 会重新编译并再次 cacheWrite
+        ifs.close();
+        spdlog::warn("[ShaderCache] corrupt entry {:016x}, dropped", id);
+        dropLocked(id);
+        ++m_stats.rejected;
+        ++m_stats.misses;
+        return false;
+    }
+    m_items[id].lastUse = ++m_clock;
+    ++m_stats.hits;
+    return true;
+}
+
+void ShaderCache::cacheWrite(uint64_t id, const void* data, uint32_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_dir.empty() || size == 0 || size > kMaxEntryBytes || sizeof(FileHeader) + size > m_maxBytes) return;
+
+    FileHeader hdr;
+    hdr.size = size;
+    hdr.checksum = checksum(data, size);
+
+    const fs::path dst = fileFor(id);
+    fs::path tmp = dst;
+    tmp += ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs.write((const char*)&hdr, sizeof(hdr)) || !ofs.write((const char*)data, size)) {
+            ofs.close();
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            return;
+        }
+    }
+    // 覆盖旧条目：先撤掉旧记账，文件由 rename 直接替换
+    if (auto old = m_items.find(id); old != m_items.end()) {
+        m_stats.bytes -= std::min(m_stats.bytes, old->second.bytes);
+        m_items.erase(old);
+    }
+    std::error_code ec;
+    fs::rename(tmp, dst, ec); // 同目录 rename：读者要么看到旧文件，要么看到完整的新文件
+    if (ec) { fs::remove(tmp, ec); return; }
+
+    Item& it = m_items[id];
+    it.bytes = sizeof(hdr) + size;
+    it.lastUse = ++m_clock;
+    m_stats.bytes += it.bytes;
+    m_stats.entries = (uint32_t)m_items.size();
+    ++m_stats.writes;
+    evictLocked(m_maxBytes);
+}
+
+void ShaderCache::fatal(const char* filePath, uint16_t line, bgfx::Fatal::Enum code, const char* str) {
+    if (code == bgfx::Fatal::DebugCheck) {
+        spdlog::error("[bgfx] {}({}): {}", filePath, line, str);
+        return;
+    }
+    // 其余致命错误 bgfx 约定由应用终止进程
+    spdlog::critical("[bgfx] fatal 0x{:08x} {}({}): {}", uint32_t(code), filePath, line, str);
+    spdlog::shutdown();
+    std::abort();
+}
+
+void ShaderCache::traceVargs(const char* filePath, uint16_t line, const char* format, va_list argList) {
+    (void)filePath; (void)line;
+    char buf[1024];
+    int n = std::vsnprintf(buf, sizeof(buf), format, argList);
+    if (n <= 0) return;
+    n = std::min<int>(n, sizeof(buf) - 1);
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == '\r')) buf[--n] = '\0';
+    spdlog::debug("[bgfx] {}", buf);
+}
+
+void ShaderCache::screenShot(const char* filePath, uint32_t, uint32_t, uint32_t, const void*, uint32_t, bool) {
+    spdlog::warn("[bgfx] screenshot '{}' ignored (not implemented)", filePath ? filePath : "");
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 名称速记：ShaderCache = bgfx::CallbackI 的磁盘缓存实现
+// - bgfx 在后端编译完着色器/程序后调 cacheWrite(id, 二进制)，下次启动先 cacheReadSize/cacheRead，
+//   命中就跳过驱动编译（GL 的 program binary、D3D 的编译结果等）
+// - 目录：<root>/<后端>_<vendor>_<device>/<id>.bin；换显卡/后端自动落到另一目录
+// - 完整性：每个文件带头（魔数 + 长度 + FNV-1a 校验），不符就删掉按未命中处理，bgfx 会重新编译
+// - 上限：总字节数超出 maxBytes 时按最近使用时间淘汰；写入走“临时文件 + rename”
+// - bgfx 可能在渲染线程调用这些回调，内部加锁
+class ShaderCache : public bgfx::CallbackI {
+public:
+    static constexpr uint64_t kDefaultMaxBytes = 64ull * 1024 * 1024; // 64 MB
+    static constexpr uint32_t kMaxEntryBytes   = 16u * 1024 * 1024;   // 单条上限
+
+    struct Stats {
+        uint64_t hits = 0, misses = 0, writes = 0, rejected = 0, evictions = 0;
+        uint64_t bytes = 0;   // 当前目录占用
+        uint32_t entries = 0;
+    };
+
+    ~ShaderCache() override = default;
+
+    // root 为空时用 SDL_GetPrefPath 下的 shadercache；须在 bgfx::init 之前调用
+    void init(const std::string& root = {}, uint64_t maxBytes = kDefaultMaxBytes);
+    // bgfx::init 之后调用：按实际后端/显卡确定子目录并扫描已有条目；之前的回调一律未命中
+    void setDevice(bgfx::RendererType::Enum renderer, uint16_t vendorId, uint16_t deviceId);
+
+    Stats stats() const;
+
+    // ===== bgfx::CallbackI =====
+    void fatal(const char* filePath, uint16_t line, bgfx::Fatal::Enum code, const char* str) override;
+    void traceVargs(const char* filePath, uint16_t line, const char* format, va_list argList) override;
+    void profilerBegin(const char*, uint32_t, const char*, uint16_t) override {}
+    void profilerBeginLiteral(const char*, uint32_t, const char*, uint16_t) override {}
+    void profilerEnd() override {}
+    uint32_t cacheReadSize(uint64_t id) override;
+    bool cacheRead(uint64_t id, void* data, uint32_t size) override;
+    void cacheWrite(uint64_t id, const void* data, uint32_t size) override;
+    void screenShot(const char* filePath, uint32_t width, uint32_t height, uint32_t pitch,
+                    const void* data, uint32_t size, bool yflip) override;
+    void captureBegin(uint32_t, uint32_t, uint32_t, bgfx::TextureFormat::Enum, bool) override {}
+    void captureEnd() override {}
+    void captureFrame(const void*, uint32_t) override {}
+
+private:
+    struct FileHeader {
+        uint32_t magic = 0x4353454B; // "KESC"
+        uint32_t version = 1;
+        uint32_t size = 0;           // 负载字节数
+        uint32_t reserved = 0;
+        uint64_t checksum = 0;       // 负载的 FNV-1a 64
+    };
+    struct Item {
+        uint64_t bytes = 0; // 含文件头
+        uint64_t lastUse = 0;
+    };
+
+    std::filesystem::path fileFor(uint64_t id) const;
+    void dropLocked(uint64_t id);              // 删除文件并记账
+    void evictLocked(uint64_t targetBytes);    // 按 lastUse 淘汰到 <= targetBytes
+    static uint64_t checksum(const void* data, uint32_t size);
+
+    mutable std::mutex m_mutex;
+    std::filesystem::path m_root, m_dir; // m_dir 为空 = 尚未 setDevice
+    uint64_t m_maxBytes = kDefaultMaxBytes;
+    uint64_t m_clock = 0;                // lastUse 计数
+    std::unordered_map<uint64_t, Item> m_items;
+    Stats m_stats;
+};
@@ -0,0 +1,90 @@
+#include "ShaderWatcher.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace fs = std::filesystem;
+
+static bool isShaderBin(const std::string& name) {
+    return name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0;
+}
+
+bool ShaderWatcher::init(const std::string& dir) {
+    shutdown();
+    std::error_code ec;
+    if (dir.empty() || !fs::is_directory(dir, ec)) {
+        spdlog::info("[ShaderWatch] {} not found, hot reload disabled", dir);
+        return false;
+    }
+    m_dir = dir;
+#if defined(__linux__)
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0 || inotify_add_watch(m_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        spdlog::warn("[ShaderWatch] inotify failed on {}: errno {}", dir, errno);
+        shutdown();
+        return false;
+    }
+#else
+    scan(nullptr);
+#endif
+    spdlog::info("[ShaderWatch] watching {}", dir);
+    return true;
+}
+
+void ShaderWatcher::shutdown() {
+#if defined(__linux__)
+    if (m_fd >= 0) close(m_fd); // 关 fd 会一并移除 watch
+    m_fd = -1;
+#else
+    m_mtimes.clear();
+    m_frame = 0;
+#endif
+    m_dir.clear();
+}
+
+void ShaderWatcher::poll(std::vector<std::string>& changed) {
+    const size_t first = changed.size();
+#if defined(__linux__)
+    if (m_fd < 0) return;
+    alignas(inotify_event) char buf[4096];
+    for (;;) {
+        const ssize_t n = read(m_fd, buf, sizeof(buf));
+        if (n <= 0) break; // EAGAIN：没有更多事件
+        for (ssize_t off = 0; off < n;) {
+            const inotify_event* ev = (const inotify_event*)(buf + off);
+            if (ev->len > 0 && isShaderBin(ev->name)) changed.emplace_back(ev->name);
+            off += sizeof(inotify_event) + ev->len;
+        }
+    }
+#else
+    if (m_dir.empty() || ++m_frame % kPollFrames != 0) return;
+    scan(&changed);
+#endif
+    // 同一个文件一次保存可能触发多次事件
+    std::sort(changed.begin() + first, changed.end());
+    changed.erase(std::unique(changed.begin() + first, changed.end()), changed.end());
+}
+
+#if !defined(__linux__)
+void ShaderWatcher::scan(std::vector<std::string>* changed) {
+    std::error_code ec;
+    for (const auto& de : fs::directory_iterator(m_dir, ec)) {
+        const std::string name = de.path().filename().string();
+        if (!isShaderBin(name)) continue;
+        const auto t = de.last_write_time(ec);
+        auto it = m_mtimes.find(name);
+        if (it == m_mtimes.end()) {
+            m_mtimes.emplace(name, t);
+            if (changed) changed->push_back(name);
+        } else if (it->second != t) {
+            it->second = t;
+            if (changed) changed->push_back(name);
+        }
+    }
+}
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 名称速记：ShaderWatcher = 盯着 shaderc 输出目录，报告改动过的 .bin
+// - Linux：inotify（IN_CLOSE_WRITE / IN_MOVED_TO），非阻塞读，每帧 poll 只是一次系统调用
+// - 其他平台：每 kPollFrames 帧比较一次修改时间
+// - 只报文件名（不含目录），同一帧内去重；真正的重载交给 ProgramRegistry
+class ShaderWatcher {
+public:
+    static constexpr uint32_t kPollFrames = 30;
+
+    ShaderWatcher() = default;
+    ~ShaderWatcher() { shutdown(); }
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    bool init(const std::string& dir); // 目录不存在时返回 false（热重载不可用，不影响运行）
+    void shutdown();
+
+    const std::string& dir() const { return m_dir; }
+
+    // 追加自上次调用以来改动过的 .bin 文件名
+    void poll(std::vector<std::string>& changed);
+
+private:
+    std::string m_dir;
+#if defined(__linux__)
+    int m_fd = -1;
+#else
+    void scan(std::vector<std::string>* changed);
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_mtimes;
+    uint32_t m_frame = 0;
+#endif
+};
@@ -1,9 +1,9 @@
 #include "shader_utils.h"
+#include "ShaderArchive.h"
 
 #include <SDL.h>
 #include <filesystem>
 #include <fstream>
-#include <vector>
 #include <spdlog/spdlog.h>
 
 namespace fs = std::filesystem;
@@ -24,6 +24,92 @@ static std::string u8(const fs::path &p)
 #endif
 }
 
+const char *ke_shaderBackendDir()
+{
+    switch (bgfx::getRendererType())
+    {
+    case bgfx::RendererType::Direct3D11:
+    case bgfx::RendererType::Direct3D12:
+        return "dx11";
+    case bgfx::RendererType::Vulkan:
+        return "spirv";
+    case bgfx::RendererType::OpenGL:
+        return "glsl";
+    default:
+    {
+        // 其余后端（Metal/GLES…）CMake 还没编译对应产物
+        static bool warned = false;
+        if (!warned)
+        {
+            warned = true;
+            spdlog::warn("No shader binaries for renderer {}, falling back to dx11",
+                         bgfx::getRendererName(bgfx::getRendererType()));
+        }
+        return "dx11";
+    }
+    }
+}
+
+static fs::path exeDirPath()
+{
+    char *base = SDL_GetBasePath();
+    fs::path exeDir = base ? fs::path(base) : fs::current_path();
+    if (base)
+        SDL_free(base);
+    return exeDir;
+}
+
+// 当前后端的着色器包：第一次加载着色器时打开，找不到就一直走散文件
+static ShaderArchive s_archive;
+static bool s_archiveTried = false;
+static bool s_preferLoose = false; // 热重载时：shaderc 输出目录里的散文件优先于包
+
+static ShaderArchive *shaderArchive()
+{
+    if (!s_archiveTried)
+    {
+        s_archiveTried = true;
+        const std::string pak = std::string(ke_shaderBackendDir()) + ".pak";
+        std::error_code ec;
+        fs::path p1 = exeDirPath() / "shaders" / pak;
+        if (!(fs::exists(p1, ec) && s_archive.open(u8(p1))))
+        {
+#ifdef KE_SHADER_DIR
+            fs::path p2 = fs::path(KE_SHADER_DIR) / pak;
+            if (fs::exists(p2, ec))
+                s_archive.open(u8(p2));
+#endif
+        }
+        if (!s_archive.isOpen())
+            spdlog::info("[ShaderPak] {} not found, loading loose shader files", pak);
+    }
+    return s_archive.isOpen() ? &s_archive : nullptr;
+}
+
+void ke_preferLooseShaders(bool enable)
+{
+    s_preferLoose = enable;
+}
+
+void ke_closeShaderArchive()
+{
+    s_archive.close();
+    s_archiveTried = false;
+}
+
+std::string ke_shaderOutputDir()
+{
+    std::error_code ec;
+    const char *backend = ke_shaderBackendDir();
+#ifdef KE_SHADER_DIR
+    // 构建目录里的产物由 shaderc 直接写，改 .sc 重编后这里最先更新
+    fs::path p = fs::path(KE_SHADER_DIR) / backend;
+    if (fs::is_directory(p, ec))
+        return u8(p);
+#endif
+    return u8(exeDirPath() / "shaders" / backend);
+}
+
 std::string ke_resolveShaderPath(const std::string &filename)
 {
     std::error_code ec;
@@ -36,13 +122,9 @@ std::string ke_resolveShaderPath(const std::string &filename)
         return u8(in);
     }
 
-    // 2) exeDir/shaders/dx11/<filename>
-    char *base = SDL_GetBasePath();
-    fs::path exeDir = base ? fs::path(base) : fs::current_path();
-    if (base)
-        SDL_free(base);
-
-    fs::path p1 = exeDir / "shaders" / "dx11" / in.filename();
+    // 2) exeDir/shaders/<backend>/<filename>
+    const char *backend = ke_shaderBackendDir();
+    fs::path p1 = exeDirPath() / "shaders" / backend / in.filename();
     if (fs::exists(p1, ec))
     {
         return u8(p1);
@@ -50,7 +132,7 @@ std::string ke_resolveShaderPath(const std::string &filename)
 
     // 3) 兜底到 CMake 定义的 KE_SHADER_DIR（绝对路径）
 #ifdef KE_SHADER_DIR
-    fs::path p2 = fs::path(KE_SHADER_DIR) / "dx11" / in.filename();
+    fs::path p2 = fs::path(KE_SHADER_DIR) / backend / in.filename();
     if (fs::exists(p2, ec))
     {
         return u8(p2);
@@ -68,29 +150,61 @@ std::string ke_resolveShaderPath(const std::string &filename)
 
 bgfx::ShaderHandle ke_loadShaderFile(const std::string &filename)
 {
-    const std::string path = ke_resolveShaderPath(filename);
+    // 1) 只给了文件名：先查着色器包，命中则直接引用映射内存（热重载时 shaderc 输出目录里有的先用它）
+    const fs::path in(filename);
+    std::error_code ec;
+    fs::path loose;
+    if (s_preferLoose && !in.has_parent_path())
+    {
+        loose = fs::path(ke_shaderOutputDir()) / in;
+        if (!fs::exists(loose, ec))
+            loose.clear();
+    }
+    if (loose.empty() && !in.has_parent_path())
+    {
+        if (ShaderArchive *pak = shaderArchive())
+        {
+            const uint8_t *data = nullptr;
+            uint32_t size = 0;
+            if (pak->find(in.filename().string(), data, size))
+            {
+                bgfx::ShaderHandle h = bgfx::createShader(bgfx::makeRef(data, size));
+                if (!bgfx::isValid(h))
+                    spdlog::error("createShader failed: {} ({})", filename, pak->path());
+                return h;
+            }
+        }
+    }
+
+    // 2) 散文件
+    const std::string path = loose.empty() ? ke_resolveShaderPath(filename) : u8(loose);
     if (path.empty())
     {
         spdlog::error("Shader file NOT found: {}", filename);
         return BGFX_INVALID_HANDLE;
     }
 
-    std::ifstream ifs(path, std::ios::binary);
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
     if (!ifs)
     {
         spdlog::error("Failed to open shader: {}", path);
         return BGFX_INVALID_HANDLE;
     }
 
-    std::vector<char> buf((std::istreambuf_iterator<char>(ifs)),
-                          std::istreambuf_iterator<char>());
-    if (buf.empty())
+    // 按文件大小一次读进 bgfx 分配的内存，省掉中间 vector 和逐字符迭代
+    const std::streamoff size = ifs.tellg();
+    if (size <= 0)
     {
         spdlog::error("Shader file is empty: {}", path);
         return BGFX_INVALID_HANDLE;
     }
-
-    const bgfx::Memory *mem = bgfx::copy(buf.data(), (uint32_t)buf.size());
+    const bgfx::Memory *mem = bgfx::alloc((uint32_t)size);
+    ifs.seekg(0);
+    if (!ifs.read((char *)mem->data, size))
+    {
+        spdlog::error("Failed to read shader: {}", path);
+        return BGFX_INVALID_HANDLE; // bgfx::alloc 没有单独的释放接口；读失败极少见，接受这一次泄漏
+    }
     bgfx::ShaderHandle h = bgfx::createShader(mem);
     if (!bgfx::isValid(h))
     {
@@ -103,15 +217,15 @@ bgfx::ShaderHandle ke_loadShaderFile(const std::string &filename)
     return h;
 }
 
-bgfx::ProgramHandle ke_loadProgramDx11(const std::string &vsFilename,
-                                       const std::string &fsFilename)
+bgfx::ProgramHandle ke_loadProgram(const std::string &vsFilename,
+                                   const std::string &fsFilename)
 {
     auto vsh = ke_loadShaderFile(vsFilename);
     auto fsh = ke_loadShaderFile(fsFilename);
 
     if (!bgfx::isValid(vsh) || !bgfx::isValid(fsh))
     {
-        spdlog::error("loadProgramDx11 failed. vs='{}' fs='{}'", vsFilename, fsFilename);
+        spdlog::error("loadProgram failed. vs='{}' fs='{}'", vsFilename, fsFilename);
         if (bgfx::isValid(vsh))
             bgfx::destroy(vsh);
         if (bgfx::isValid(fsh))
@@ -2,12 +2,28 @@
 #include <bgfx/bgfx.h>
 #include <string>
 
+// 当前渲染后端对应的着色器目录名："dx11" / "spirv" / "glsl"（须在 bgfx::init 之后调用）
+const char* ke_shaderBackendDir();
+
 // 解析并返回可用的着色器路径（绝对路径）。找不到则返回空字符串。
+// 按当前后端查找：exeDir/shaders/<backend>/<filename>，再到 KE_SHADER_DIR/<backend>/
 std::string ke_resolveShaderPath(const std::string& filename);
 
+// shaderc 输出当前后端 .bin 的目录（热重载监视/读取的地方）：优先 KE_SHADER_DIR/<backend>
+std::string ke_shaderOutputDir();
+
 // 加载单个 .bin（filename 可以是“vs_simple.bin”这样的文件名，或绝对/相对路径）
+// 只给文件名时优先从 shaders/<backend>.pak 里取（mmap，零拷贝），包里没有再读散文件
+// 开启 ke_preferLooseShaders 后先查 ke_shaderOutputDir() 里的散文件，没有才查包
 bgfx::ShaderHandle ke_loadShaderFile(const std::string& filename);
 
+// 热重载监视运行时打开：包只在重新链接时更新，改 .sc 后首次用到的排列也要读到新产物，
+// 不能和已热重载的着色器混用旧字节
+void ke_preferLooseShaders(bool enable);
+
 // 组合创建 Program（推荐：直接传文件名）
-bgfx::ProgramHandle ke_loadProgramDx11(const std::string& vsFilename,
-                                       const std::string& fsFilename);
+bgfx::ProgramHandle ke_loadProgram(const std::string& vsFilename,
+                                   const std::string& fsFilename);
+
+// 关闭着色器包映射；makeRef 出去的内存在 bgfx 处理完之前必须有效，所以放在 bgfx::shutdown() 之后
+void ke_closeShaderArchive();
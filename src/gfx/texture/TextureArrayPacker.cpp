@@ -0,0 +1,264 @@
+#include "TextureArrayPacker.h"
+#include "TextureLoader.h"
+#include "gfx/resource/TextureCache.h"
+#include "core/JobSystem.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <map>
+
+// 各槽位的默认色与色彩空间（同 PbrMaterialRegistry 的默认纹理）
+static const uint8_t kDefaultRGBA[5][4] = {
+    {255, 255, 255, 255}, // baseColor
+    {255, 255, 255, 255}, // mr
+    {128, 128, 255, 255}, // normal
+    {255, 255, 255, 255}, // ao
+    {  0,   0,   0, 255}, // emissive
+};
+static const bool kSlotSrgb[5] = { true, false, false, false, true };
+
+bool TextureArrayPacker::init(ke::JobSystem& jobs, TextureCache& cache) {
+    m_jobs = &jobs;
+    m_cache = &cache;
+    const bgfx::Caps* caps = bgfx::getCaps();
+    m_supported = caps && (caps->supported & BGFX_CAPS_TEXTURE_2D_ARRAY) != 0;
+    setEnabled(m_supported);
+    if (!m_supported) {
+        spdlog::info("[TexArray] 2D texture arrays not supported, packing disabled");
+        return false;
+    }
+    return true;
+}
+
+void TextureArrayPacker::shutdown() {
+    if (m_jobs) m_jobs->waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_built.clear();
+    }
+    for (uint32_t i = 0; i < m_groups.size(); ++i)
+        if (m_groups[i].refs > 0) destroyGroup(i);
+    m_groups.clear();
+    m_freeGroups.clear();
+    m_waiting.clear();
+    if (m_cache) m_cache->setKeepPixels(0);
+    m_cache = nullptr;
+    m_scannedSerial = 0;
+    m_stats = {};
+}
+
+void TextureArrayPacker::setEnabled(bool b) {
+    m_enabled = b && m_supported;
+    // 关掉时不再替它保留像素（已保留的随条目销毁）
+    if (m_cache) m_cache->setKeepPixels(m_enabled ? kMaxDim : 0);
+}
+
+void TextureArrayPacker::update(PbrMaterialManager& mgr, TextureCache& cache) {
+    if (!m_supported) return;
+
+    std::vector<std::shared_ptr<Plan>> built;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        built.swap(m_built);
+    }
+    for (auto& p : built) {
+        --m_stats.pending;
+        finish(*p, mgr);
+    }
+
+    if (m_enabled) scan(mgr, cache);
+}
+
+void TextureArrayPacker::scan(PbrMaterialManager& mgr, TextureCache& cache) {
+    // 候选：新材质 + 上次贴图还在解码的材质
+    std::vector<PbrMatHandle> candidates;
+    candidates.swap(m_waiting);
+    uint32_t maxSerial = m_scannedSerial;
+    for (uint32_t i = 0; i < mgr.count(); ++i) {
+        const PbrMaterialGPU& m = mgr.at(i);
+        if (m.serial <= m_scannedSerial) continue;
+        maxSerial = std::max(maxSerial, m.serial);
+        candidates.push_back(mgr.handleAt(i));
+    }
+    m_scannedSerial = maxSerial;
+    if (candidates.empty()) return;
+
+    // 一批里还有贴图在解码就整批留到下帧：一起分组，免得拆成凑不够 kMinMaterials 的小组
+    for (PbrMatHandle h : candidates) {
+        const PbrMaterialGPU* m = mgr.tryGet(h);
+        if (!m || m->texArray >= 0) continue;
+        for (TexRef r : { m->r_baseColor, m->r_mr, m->r_normal, m->r_ao, m->r_emissive }) {
+            if (cache.loading(r)) {
+                m_waiting.swap(candidates);
+                return;
+            }
+        }
+    }
+
+    // 按尺寸分组；没有任何贴图的材质最后并入最大的一组（全用层 0）
+    std::map<uint32_t, std::shared_ptr<Plan>> plans;
+    std::vector<PbrMatHandle> untextured;
+    for (PbrMatHandle h : candidates) {
+        const PbrMaterialGPU* m = mgr.tryGet(h);
+        if (!m || m->texArray >= 0) continue; // 已销毁 / 已打包
+
+        const TexRef refs[5] = { m->r_baseColor, m->r_mr, m->r_normal, m->r_ao, m->r_emissive };
+        std::shared_ptr<const TexPixels> pixels[5];
+        int w = 0, hgt = 0;
+        bool ok = true, any = false;
+        for (uint32_t s = 0; s < 5 && ok; ++s) {
+            if (!refs[s].valid()) continue;
+            // 没有保留像素 = 解码失败或超过 kMaxDim
+            pixels[s] = cache.pixels(refs[s]);
+            if (!pixels[s] || (any && (pixels[s]->w != w || pixels[s]->h != hgt))) { ok = false; break; }
+            w = pixels[s]->w; hgt = pixels[s]->h; any = true;
+        }
+        if (!ok) continue;
+        if (!any) { untextured.push_back(h); continue; }
+
+        auto& plan = plans[(uint32_t(w) << 16) | uint32_t(hgt)];
+        if (!plan) {
+            plan = std::make_shared<Plan>();
+            plan->w = (uint16_t)w;
+            plan->h = (uint16_t)hgt;
+            for (auto& l : plan->layers) l.emplace_back(); // 层 0：默认色
+        }
+
+        std::array<uint16_t, 5> layers{};
+        for (uint32_t s = 0; s < 5; ++s) {
+            if (!pixels[s]) continue;
+            auto& list = plan->layers[s];
+            auto it = std::find(list.begin(), list.end(), pixels[s]); // 同一份像素只占一层
+            layers[s] = (uint16_t)(it - list.begin());
+            if (it == list.end()) list.push_back(pixels[s]);
+        }
+        plan->mats.push_back(h);
+        plan->matLayers.push_back(layers);
+    }
+
+    std::shared_ptr<Plan> largest;
+    for (auto& [key, p] : plans)
+        if (!largest || p->mats.size() > largest->mats.size()) largest = p;
+    if (largest) {
+        for (PbrMatHandle h : untextured) {
+            largest->mats.push_back(h);
+            largest->matLayers.push_back({});
+        }
+    }
+
+    const uint32_t maxLayers = bgfx::getCaps()->limits.maxTextureLayers;
+    for (auto& [key, p] : plans) {
+        if (p->mats.size() < kMinMaterials) continue;
+        size_t layers = 0;
+        for (auto& l : p->layers) layers = std::max(layers, l.size());
+        if (layers > maxLayers) {
+            spdlog::warn("[TexArray] {}x{}: {} layers > device limit {}, skipped", p->w, p->h, layers, maxLayers);
+            continue;
+        }
+
+        // numLayers == 1 时 bgfx 建的是普通 2D 纹理，补一层默认色保证是数组
+        for (auto& l : p->layers)
+            if (l.size() < 2) l.emplace_back();
+
+        ++m_stats.pending;
+        m_jobs->submit([this, p] {
+            build(*p);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_built.push_back(p);
+        });
+    }
+}
+
+void TextureArrayPacker::build(Plan& p) {
+    std::vector<uint8_t> fill, chain;
+    for (uint32_t s = 0; s < 5; ++s) {
+        for (auto& layer : p.layers[s]) {
+            const uint8_t* rgba = layer ? layer->rgba.data() : nullptr;
+            if (!rgba) { // 默认色层
+                fill.resize(size_t(p.w) * p.h * 4);
+                for (size_t i = 0; i < fill.size(); i += 4)
+                    std::copy(kDefaultRGBA[s], kDefaultRGBA[s] + 4, fill.begin() + i);
+                rgba = fill.data();
+            }
+            // bgfx 数组纹理内存布局：逐层，每层是完整 mip 链
+            int cw = 0, ch = 0;
+            buildMipChainRGBA(rgba, p.w, p.h, 0, chain, cw, ch);
+            p.data[s].insert(p.data[s].end(), chain.begin(), chain.end());
+            layer.reset(); // 像素已进 mip 链；缓存那份照旧随条目走
+        }
+    }
+}
+
+void TextureArrayPacker::finish(Plan& p, PbrMaterialManager& mgr) {
+    Group g;
+    for (uint32_t s = 0; s < 5; ++s) {
+        const uint16_t layers = (uint16_t)p.layers[s].size();
+        const uint64_t flags = kSlotSrgb[s] ? BGFX_TEXTURE_SRGB : BGFX_TEXTURE_NONE;
+        g.arrays[s] = bgfx::createTexture2D(p.w, p.h, true, layers, bgfx::TextureFormat::RGBA8, flags,
+                                            bgfx::copy(p.data[s].data(), (uint32_t)p.data[s].size()));
+        if (!bgfx::isValid(g.arrays[s])) {
+            spdlog::error("[TexArray] createTexture2D {}x{}x{} failed", p.w, p.h, layers);
+            for (auto& t : g.arrays)
+                if (bgfx::isValid(t)) bgfx::destroy(t);
+            return;
+        }
+        bgfx::TextureInfo info{};
+        bgfx::calcTextureSize(info, p.w, p.h, 1, false, true, layers, bgfx::TextureFormat::RGBA8);
+        g.bytes  += info.storageSize;
+        g.layers += layers;
+    }
+
+    uint32_t index;
+    if (!m_freeGroups.empty()) { index = m_freeGroups.back(); m_freeGroups.pop_back(); }
+    else { index = (uint32_t)m_groups.size(); m_groups.emplace_back(); }
+    m_groups[index] = g;
+    m_cache->chargeExternal(g.bytes);
+    ++m_stats.groups;
+    m_stats.layers += g.layers;
+    m_stats.bytes  += g.bytes;
+
+    // 每个绑上的材质经 bindTextureArray 给组 +1 引用
+    const int16_t group = (int16_t)index;
+    for (size_t i = 0; i < p.mats.size(); ++i) {
+        const PbrMaterialGPU* m = mgr.tryGet(p.mats[i]);
+        if (!m || m->texArray >= 0) continue; // 解码期间被销毁
+        mgr.bindTextureArray(p.mats[i], group, p.matLayers[i].data());
+    }
+    const uint32_t bound = m_groups[index].refs;
+    if (bound == 0) destroyGroup(index); // 材质全没了：数组白建，立即还掉
+    spdlog::info("[TexArray] group {}: {}x{}, {} materials", group, p.w, p.h, bound);
+}
+
+void TextureArrayPacker::addRef(int16_t group) {
+    if (group < 0 || uint32_t(group) >= m_groups.size()) return;
+    ++m_groups[group].refs;
+    ++m_stats.materials;
+}
+
+void TextureArrayPacker::release(int16_t group) {
+    // shutdown 之后材质才清：组已经全部销毁
+    if (group < 0 || uint32_t(group) >= m_groups.size() || m_groups[group].refs == 0) return;
+    --m_stats.materials;
+    if (--m_groups[group].refs == 0) destroyGroup(uint32_t(group));
+}
+
+// 材质引用在 GPU 资源延迟释放时才归还，此时已没有在途 draw 引用这些数组
+void TextureArrayPacker::destroyGroup(uint32_t index) {
+    Group& g = m_groups[index];
+    for (auto& t : g.arrays)
+        if (bgfx::isValid(t)) bgfx::destroy(t);
+    if (m_cache) m_cache->refundExternal(g.bytes);
+    --m_stats.groups;
+    m_stats.layers -= g.layers;
+    m_stats.bytes  -= g.bytes;
+    g = Group{};
+    m_freeGroups.push_back(index);
+}
+
+void TextureArrayPacker::bind(const PbrMaterialGPU& m, const PbrMaterialRegistry& reg) const {
+    const Group& g = m_groups[m.texArray];
+    bgfx::setTexture(0, reg.s_baseColor, g.arrays[0]);
+    bgfx::setTexture(1, reg.s_mr,        g.arrays[1]);
+    bgfx::setTexture(2, reg.s_normal,    g.arrays[2]);
+    bgfx::setTexture(3, reg.s_ao,        g.arrays[3]);
+    bgfx::setTexture(4, reg.s_emissive,  g.arrays[4]);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "gfx/material/PbrMaterial.h"
+
+namespace ke { class JobSystem; }
+
+// 名称速记：TextureArrayPacker = 把同尺寸的小材质纹理装进 bgfx 2D 纹理数组
+// - 每组（同 w×h）5 个数组，对应 baseColor/mr/normal/ao/emissive 五个槽位；层 0 为默认色
+// - 材质只记组号 + 每槽层号（层号进材质常量块）；同组材质共用同一套纹理绑定
+// - 可选阶段：设备不支持 2D 数组或关闭时，材质照旧走 t_* 单张纹理
+// - 层像素取自 TextureCache 解码时保留的 mip0，不再读文件；贴图还在解码的一批材质等解码完再分组
+// - 组按材质引用计数：材质绑上时 +1、GPU 资源释放时 -1（PbrMaterialManager 调），归零即销毁数组、槽位复用；
+//   数组字节记进 TextureCache 预算
+class TextureArrayPacker {
+public:
+    static constexpr uint16_t kMaxDim       = 256; // 只打包不超过该尺寸的纹理
+    static constexpr uint32_t kMinMaterials = 2;   // 一组少于这么多材质就不值得打包
+
+    struct Stats {
+        uint32_t groups    = 0; // 存活的组
+        uint32_t layers    = 0; // 所有数组的层数总和
+        uint32_t materials = 0; // 已改用数组的材质数
+        uint32_t pending   = 0; // 正在后台解码的组
+        uint64_t bytes     = 0; // 数组纹理占用（含 mip）
+    };
+
+    bool init(ke::JobSystem& jobs, TextureCache& cache);
+    void shutdown();
+
+    void setEnabled(bool b);
+    bool enabled() const { return m_enabled; }
+
+    // 每帧（主线程）：扫描新创建的材质并提交打包任务；已完成的组创建数组并改绑材质
+    void update(PbrMaterialManager& mgr, TextureCache& cache);
+
+    // 绑定材质所在组的数组（stage 0..4）；材质须 texArray >= 0
+    void bind(const PbrMaterialGPU& m, const PbrMaterialRegistry& reg) const;
+
+    // 组的材质引用（PbrMaterialManager::bindTextureArray / 材质 GPU 资源释放时调用）
+    void addRef(int16_t group);
+    void release(int16_t group);
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Group {
+        bgfx::TextureHandle arrays[5] = { BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE,
+                                          BGFX_INVALID_HANDLE, BGFX_INVALID_HANDLE };
+        uint32_t refs   = 0; // 绑着它的材质（含墓地里还没释放的）；0 = 空闲槽位
+        uint32_t layers = 0;
+        uint64_t bytes  = 0;
+    };
+    struct Plan {
+        uint16_t w = 0, h = 0;
+        // 槽位 → 每层的像素（空 = 默认色，层 0 总是默认色）
+        std::vector<std::shared_ptr<const TexPixels>> layers[5];
+        std::vector<PbrMatHandle> mats;
+        std::vector<std::array<uint16_t, 5>> matLayers;
+        std::vector<uint8_t> data[5]; // 工作线程填写：逐层拼接的完整 mip 链
+    };
+
+    void scan(PbrMaterialManager& mgr, TextureCache& cache);
+    static void build(Plan& p);
+    void finish(Plan& p, PbrMaterialManager& mgr);
+    void destroyGroup(uint32_t index);
+
+    ke::JobSystem* m_jobs = nullptr;
+    TextureCache*  m_cache = nullptr; // 像素来源 + 预算记账
+    std::vector<Group> m_groups;
+    std::vector<uint32_t> m_freeGroups;
+    std::vector<PbrMatHandle> m_waiting; // 贴图还没解码完的材质，下帧再看
+    uint32_t m_scannedSerial = 0; // 已扫描过的最大材质创建序号
+    bool m_supported = false;
+    bool m_enabled = false;
+    Stats m_stats;
+
+    std::mutex m_mutex; // 保护 m_built（工作线程写，主线程读）
+    std::vector<std::shared_ptr<Plan>> m_built;
+};
@@ -1,22 +1,36 @@
 #include "TextureLoader.h"
+#include "core/ContentHash.h"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 
 // 只需要这一个头；实现放在本 cpp（单 TU）里
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION   // 新增：提供 stbi_write_* 的实现
 #define STBI_ONLY_PNG
 #define STBI_ONLY_JPEG
+#define STBI_ONLY_HDR                    // 环境光 IBL 读 .hdr（stbi_loadf）
 #define STBI_MSC_SECURE_CRT
 #include <stb_image.h>
 #include <stb_image_write.h>
 
 bool loadImageRGBA(const std::string& path, int& w, int& h,
-                   std::vector<uint8_t>& pixels, bool flipY)
+                   std::vector<uint8_t>& pixels, bool flipY, uint64_t* contentHash)
 {
-    stbi_set_flip_vertically_on_load(flipY ? 1 : 0);
+    // 线程局部版本：解码会在工作线程里并发进行
+    stbi_set_flip_vertically_on_load_thread(flipY ? 1 : 0);
 
     int comp = 0;
-    unsigned char* data = stbi_load(path.c_str(), &w, &h, &comp, STBI_rgb_alpha);
+    unsigned char* data = nullptr;
+    if (contentHash) {
+        std::vector<uint8_t> file;
+        if (!ke::readFileHashed(path, file, *contentHash)) {
+            spdlog::error("[Texture] read failed: {}", path);
+            return false;
+        }
+        data = stbi_load_from_memory(file.data(), (int)file.size(), &w, &h, &comp, STBI_rgb_alpha);
+    } else {
+        data = stbi_load(path.c_str(), &w, &h, &comp, STBI_rgb_alpha);
+    }
     if (!data) {
         spdlog::error("[Texture] load failed: {} ({})", path, stbi_failure_reason());
         return false;
@@ -28,9 +42,15 @@ bool loadImageRGBA(const std::string& path, int& w, int& h,
     return true;
 }
 
+bool imageInfo(const std::string& path, int& w, int& h)
+{
+    int comp = 0;
+    return stbi_info(path.c_str(), &w, &h, &comp) != 0;
+}
+
 bgfx::TextureHandle createTexture2DFromFile(const std::string& path,
-                                            bool /*srgb*/,
-                                            uint64_t /*samplerFlags*/)
+                                            bool srgb,
+                                            uint64_t samplerFlags)
 {
     int w = 0, h = 0;
     std::vector<uint8_t> rgba;
@@ -41,9 +61,48 @@ bgfx::TextureHandle createTexture2DFromFile(const std::string& path,
     const bgfx::Memory* mem = bgfx::copy(rgba.data(), (uint32_t)rgba.size());
     // 这里只建 base level；需要 mip 的话后面我们再加离线/在线生成
     auto tex = bgfx::createTexture2D((uint16_t)w, (uint16_t)h,
-                                     false, 1, bgfx::TextureFormat::RGBA8, 0, mem);
+                                     false, 1, bgfx::TextureFormat::RGBA8,
+                                     (srgb ? BGFX_TEXTURE_SRGB : BGFX_TEXTURE_NONE) | samplerFlags, mem);
     if (!bgfx::isValid(tex)) {
         spdlog::error("[Texture] createTexture2D failed: {}", path);
     }
     return tex;
 }
+
+uint8_t mipCountFor(int w, int h)
+{
+    uint8_t n = 1;
+    for (int d = std::max(w, h); d > 1; d >>= 1) ++n;
+    return n;
+}
+
+void buildMipChainRGBA(const uint8_t* rgba, int w, int h, uint8_t firstMip,
+                       std::vector<uint8_t>& out, int& outW, int& outH)
+{
+    out.clear();
+    std::vector<uint8_t> cur(rgba, rgba + size_t(w) * size_t(h) * 4), next;
+    int cw = w, ch = h;
+    for (uint8_t mip = 0;; ++mip) {
+        if (mip == firstMip) { outW = cw; outH = ch; }
+        if (mip >= firstMip) out.insert(out.end(), cur.begin(), cur.end());
+        if (cw == 1 && ch == 1) break;
+
+        const int nw = std::max(1, cw / 2), nh = std::max(1, ch / 2);
+        next.resize(size_t(nw) * size_t(nh) * 4);
+        for (int y = 0; y < nh; ++y) {
+            const int y0 = std::min(ch - 1, y * 2), y1 = std::min(ch - 1, y * 2 + 1);
+            for (int x = 0; x < nw; ++x) {
+                const int x0 = std::min(cw - 1, x * 2), x1 = std::min(cw - 1, x * 2 + 1);
+                const uint8_t* a = &cur[(size_t(y0) * cw + x0) * 4];
+                const uint8_t* b = &cur[(size_t(y0) * cw + x1) * 4];
+                const uint8_t* c = &cur[(size_t(y1) * cw + x0) * 4];
+                const uint8_t* d = &cur[(size_t(y1) * cw + x1) * 4];
+                uint8_t* o = &next[(size_t(y) * nw + x) * 4];
+                for (int k = 0; k < 4; ++k)
+                    o[k] = uint8_t((a[k] + b[k] + c[k] + d[k] + 2) >> 2);
+            }
+        }
+        cur.swap(next);
+        cw = nw; ch = nh;
+    }
+}
@@ -4,10 +4,23 @@
 #include <vector>
 
 // 读文件到 RGBA8 像素；flipY=true 时做“上下翻转”（多数 2D 图片的原点在左上角）
+// contentHash 非空时整个文件先读进内存，边读边算文件内容的 XXH64（按内容去重用）
 bool loadImageRGBA(const std::string& path, int& w, int& h,
-                   std::vector<uint8_t>& pixels, bool flipY = true);
+                   std::vector<uint8_t>& pixels, bool flipY = true,
+                   uint64_t* contentHash = nullptr);
+
+// 只读文件头取尺寸（不解码像素）
+bool imageInfo(const std::string& path, int& w, int& h);
 
 // 直接创建 bgfx 纹理；失败返回 BGFX_INVALID_HANDLE
 bgfx::TextureHandle createTexture2DFromFile(const std::string& path,
                                             bool srgb = false,
                                             uint64_t samplerFlags = 0);
+
+// 完整 mip 链的级数（到 1x1 为止）
+uint8_t mipCountFor(int w, int h);
+
+// 从 RGBA8 原图生成 [firstMip, 最后一级] 的 mip 链（2x2 盒式滤波），按 bgfx 要求逐级拼接到 out；
+// outW/outH 为 firstMip 这一级的尺寸
+void buildMipChainRGBA(const uint8_t* rgba, int w, int h, uint8_t firstMip,
+                       std::vector<uint8_t>& out, int& outW, int& outH);
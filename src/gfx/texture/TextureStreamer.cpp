@@ -0,0 +1,169 @@
+#include "TextureStreamer.h"
+#include "TextureLoader.h"
+#include "core/JobSystem.h"
+#include "gfx/material/PbrMaterial.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+bool TextureStreamer::init(TextureCache& cache, ke::JobSystem& jobs) {
+    m_cache = &cache;
+    m_jobs  = &jobs;
+    m_slots.clear();
+    m_frame = 1;
+    m_stats = {};
+    return true;
+}
+
+void TextureStreamer::shutdown() {
+    if (m_jobs) m_jobs->waitIdle();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_done.clear();
+    m_slots.clear();
+    m_stats.inFlight = 0;
+}
+
+void TextureStreamer::requestMaterial(const PbrMaterialGPU& m, float screenPx) {
+    request(m.r_baseColor, screenPx);
+    request(m.r_mr,        screenPx);
+    request(m.r_normal,    screenPx);
+    request(m.r_ao,        screenPx);
+    request(m.r_emissive,  screenPx);
+}
+
+void TextureStreamer::request(TexRef r, float screenPx) {
+    if (!r.valid() || !m_cache || !m_cache->streaming()) return;
+    r = m_cache->resolve(r); // 别名的需求记到真正持有纹理的条目上
+    if (r.idx >= m_slots.size()) m_slots.resize(r.idx + 1);
+    Slot& s = m_slots[r.idx];
+    if (s.lastRequestFrame != m_frame) { s.lastRequestFrame = m_frame; s.wantPx = 0.0f; }
+    s.wantPx = std::max(s.wantPx, screenPx);
+}
+
+uint8_t TextureStreamer::startMipFor(const TextureCache::StreamInfo& info) const {
+    uint8_t mip = 0;
+    while (std::max(info.fullW >> mip, info.fullH >> mip) > m_cache->streamStartDim()) ++mip;
+    return mip;
+}
+
+void TextureStreamer::update() {
+    if (!m_cache) return;
+
+    // 1) 换入已经解码好的 mip 链（只有主线程能碰 bgfx）
+    std::vector<Result> done;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        done.swap(m_done);
+    }
+    for (Result& r : done) {
+        --m_stats.inFlight;
+        if (r.idx < m_slots.size()) m_slots[r.idx].pending = false;
+        if (r.chain.empty()) continue; // 解码失败：保持原样
+
+        const uint64_t flags = r.srgb ? BGFX_TEXTURE_SRGB : BGFX_TEXTURE_NONE;
+        bgfx::TextureHandle tex = bgfx::createTexture2D((uint16_t)r.w, (uint16_t)r.h, true, 1,
+                                                        bgfx::TextureFormat::RGBA8, flags,
+                                                        bgfx::copy(r.chain.data(), (uint32_t)r.chain.size()));
+        if (!bgfx::isValid(tex)) continue;
+        bgfx::TextureInfo ti{};
+        bgfx::calcTextureSize(ti, (uint16_t)r.w, (uint16_t)r.h, 1, false, true, 1, bgfx::TextureFormat::RGBA8);
+        m_cache->replaceTexture(r.idx, r.serial, tex, ti.storageSize, r.mip);
+    }
+
+    if (!m_cache->streaming()) { ++m_frame; return; }
+
+    // 2) 按上一帧的请求决定每张纹理的目标 mip
+    struct Cand { uint32_t idx; uint8_t mip; float prio; };
+    std::vector<Cand> ins, outs;
+    const uint32_t lastFrame = m_frame;
+    const bool overBudget = m_cache->stats().bytesResident > m_cache->budget();
+    if (m_slots.size() < m_cache->capacity()) m_slots.resize(m_cache->capacity());
+
+    uint32_t streamable = 0;
+    TextureCache::StreamInfo info;
+    for (uint32_t idx = 0; idx < m_cache->capacity(); ++idx) {
+        Slot& s = m_slots[idx];
+        if (!m_cache->streamInfo(idx, info)) { if (!s.pending) s = Slot{}; continue; }
+        ++streamable;
+        if (s.serial != info.serial) { // 槽位换了新纹理：丢掉旧请求
+            const bool pending = s.pending;
+            s = Slot{};
+            s.serial = info.serial;
+            s.pending = pending;
+            s.lastRequestFrame = lastFrame;
+        }
+        if (s.pending) continue;
+
+        const uint8_t startMip = startMipFor(info);
+        uint8_t want = startMip;
+        const bool recent = lastFrame - s.lastRequestFrame < kStreamOutFrames;
+        if (recent && s.wantPx > 0.0f) {
+            // 纹素密度：网格投影 N 像素时，纹理最长边约需 N 个纹素
+            const float maxDim = float(std::max(info.fullW, info.fullH));
+            const float lod = std::log2(maxDim / std::max(s.wantPx, 1.0f)) + m_mipBias;
+            want = (uint8_t)std::clamp(int(std::floor(lod)), 0, int(startMip));
+        }
+
+        if (want < info.residentMip) {
+            s.overFrames = 0;
+            ins.push_back({ idx, want, s.wantPx });
+        } else if (want > info.residentMip) {
+            if (++s.overFrames >= kStreamOutFrames || overBudget)
+                outs.push_back({ idx, want, s.wantPx });
+        } else {
+            s.overFrames = 0;
+        }
+    }
+    m_stats.streamable = streamable;
+
+    // 3) 先流出（腾显存），再按“屏幕上越大越优先”流入
+    std::sort(outs.begin(), outs.end(), [](const Cand& a, const Cand& b) { return a.prio < b.prio; });
+    std::sort(ins.begin(),  ins.end(),  [](const Cand& a, const Cand& b) { return a.prio > b.prio; });
+
+    for (const Cand& c : outs) {
+        if (m_stats.inFlight >= kMaxInFlight) break;
+        if (!m_cache->streamInfo(c.idx, info)) continue;
+        schedule(c.idx, info, c.mip);
+        ++m_stats.streamedOut;
+    }
+    for (const Cand& c : ins) {
+        if (m_stats.inFlight >= kMaxInFlight) break;
+        if (!m_cache->streamInfo(c.idx, info)) continue;
+
+        bgfx::TextureInfo ti{};
+        bgfx::calcTextureSize(ti, uint16_t(std::max(1, info.fullW >> c.mip)), uint16_t(std::max(1, info.fullH >> c.mip)),
+                              1, false, true, 1, bgfx::TextureFormat::RGBA8);
+        const uint64_t delta = ti.storageSize > info.bytes ? ti.storageSize - info.bytes : 0;
+        m_cache->makeRoom(delta);
+        if (m_cache->stats().bytesResident + delta > m_cache->budget()) continue; // 预算不够：本帧放弃
+        schedule(c.idx, info, c.mip);
+        ++m_stats.streamedIn;
+    }
+
+    ++m_frame;
+}
+
+void TextureStreamer::schedule(uint32_t idx, const TextureCache::StreamInfo& info, uint8_t mip) {
+    m_slots[idx].pending = true;
+    m_slots[idx].overFrames = 0;
+    ++m_stats.inFlight;
+
+    m_jobs->submit([this, idx, mip, serial = info.serial, path = info.path,
+                    srgb = info.srgb, flipY = info.flipY] {
+        Result r;
+        r.idx = idx;
+        r.serial = serial;
+        r.mip = mip;
+        r.srgb = srgb;
+
+        int w = 0, h = 0;
+        std::vector<uint8_t> rgba;
+        if (loadImageRGBA(path, w, h, rgba, flipY))
+            buildMipChainRGBA(rgba.data(), w, h, std::min<uint8_t>(mip, mipCountFor(w, h) - 1), r.chain, r.w, r.h);
+        else
+            spdlog::warn("[Stream] decode failed: {}", path);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.push_back(std::move(r));
+    });
+}
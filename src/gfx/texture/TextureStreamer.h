@@ -0,0 +1,70 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "gfx/resource/TextureCache.h"
+
+namespace ke { class JobSystem; }
+struct PbrMaterialGPU;
+
+// 名称速记：TextureStreamer = 按屏幕纹素密度决定每张纹理该驻留哪一级 mip
+// - 剔除阶段：每个可见网格按投影尺寸（像素）调用 requestMaterial()
+// - 下一帧 update()：需要更清晰 → 异步解码并生成新 mip 链（流入）；
+//   长时间用不上 → 换回低 mip（流出）；新纹理在主线程创建并替换缓存条目
+// - 全部受 TextureCache 的预算约束：先流出、再按优先级流入
+class TextureStreamer {
+public:
+    struct Stats {
+        uint32_t streamable = 0; // 参与流送的纹理数
+        uint32_t inFlight   = 0; // 正在解码的任务
+        uint64_t streamedIn = 0; // 累计流入次数
+        uint64_t streamedOut= 0; // 累计流出次数
+    };
+
+    bool init(TextureCache& cache, ke::JobSystem& jobs);
+    void shutdown(); // 等待在途任务并丢弃结果
+
+    // screenPx：网格在屏幕上的投影直径（像素）；材质的所有纹理都按它计算需要的 mip
+    void requestMaterial(const PbrMaterialGPU& m, float screenPx);
+    void request(TexRef r, float screenPx);
+
+    // 每帧绘制前调用一次（主线程）
+    void update();
+
+    void setMipBias(float bias) { m_mipBias = bias; } // >0 更省显存，<0 更清晰
+    const Stats& stats() const { return m_stats; }
+
+private:
+    static constexpr uint32_t kMaxInFlight     = 4;   // 同时解码的纹理数上限
+    static constexpr uint32_t kStreamOutFrames = 120; // 连续这么多帧用不上才流出（滞回）
+
+    struct Slot {
+        uint32_t serial = 0;             // 对应 TextureCache 条目的 serial
+        float    wantPx = 0.0f;          // 最近一次被请求那帧的最大投影尺寸
+        uint32_t lastRequestFrame = 0;
+        uint32_t overFrames = 0;         // 连续“驻留级别高于需要”的帧数
+        bool     pending = false;
+    };
+    struct Result {
+        uint32_t idx = 0, serial = 0;
+        uint8_t  mip = 0;
+        bool     srgb = false;
+        int      w = 0, h = 0;
+        std::vector<uint8_t> chain;      // mip..最后一级，逐级拼接
+    };
+
+    void schedule(uint32_t idx, const TextureCache::StreamInfo& info, uint8_t mip);
+    uint8_t startMipFor(const TextureCache::StreamInfo& info) const;
+
+    TextureCache*  m_cache = nullptr;
+    ke::JobSystem* m_jobs  = nullptr;
+    std::vector<Slot> m_slots; // 按 TextureCache 条目下标索引
+    uint32_t m_frame = 1;
+    float    m_mipBias = 0.0f;
+    Stats    m_stats;
+
+    std::mutex          m_mutex; // 保护 m_done（工作线程写，主线程读）
+    std::vector<Result> m_done;
+};
@@ -9,19 +9,19 @@
 #include <bgfx/bgfx.h>
 #include <bx/math.h>
 
-#include "scene/Scene.h"    // 使用 MeshComp 及其嵌套类型
+#include "scene/Scene.h"    // 使用 Scene 的 world 数组与 exports 旁表
 
 namespace fs = std::filesystem;
 
 /**
  * OBJ 导出实现思路（在你的基础上修正）：
- * - 真正导出使用 Scene::MeshComp 中的 CPU 缓存：
- *     std::vector<MeshComp::MeshVertexExport> cpuVertices;
- *     std::vector<uint32_t>                   cpuIndices;
+ * - 真正导出使用 Scene::exports 旁表里的 CPU 缓存：
+ *     std::vector<MeshVertexExport> cpuVertices;
+ *     std::vector<uint32_t>         cpuIndices;
  *   这些由 Renderer::addMeshFromGltfToScene(...) 填好。
  * - 如果没有 CPU 数据，就导出一个占位三角形，确保流程可跑通。
- * - 顶点位置应用 mc.model（SRT），法线使用 inverse-transpose(3x3)。
- * - 若 baseColorPath 非空，写入 .mtl 的 map_Kd。
+ * - 顶点位置应用 Scene::world[i]（SRT），法线使用 inverse-transpose(3x3)。
+ * - 若实体的 baseColorPath 非空（按加载路径记，不随共享几何走），写入 .mtl 的 map_Kd。
  */
 
 // 列优先 4x4 矩阵 * 位置（w=1）
@@ -58,17 +58,17 @@ static inline float length3(const float v[3])
 
 // —— 读取导出缓存：优先用 CPU 数据，否则输出占位三角 —— //
 static void fetchMeshCPUData(
-    const MeshComp& mc,
-    std::vector<MeshComp::MeshVertexExport>& outVerts,
+    const MeshExportData* mc,
+    std::vector<MeshVertexExport>& outVerts,
     std::vector<uint32_t>& outIndices)
 {
     outVerts.clear();
     outIndices.clear();
 
-    if (!mc.cpuVertices.empty() && !mc.cpuIndices.empty())
+    if (mc && !mc->cpuVertices.empty() && !mc->cpuIndices.empty())
     {
-        outVerts   = mc.cpuVertices;  // 类型完全一致：std::vector<MeshComp::MeshVertexExport>
-        outIndices = mc.cpuIndices;
+        outVerts   = mc->cpuVertices;  // 类型完全一致：std::vector<MeshVertexExport>
+        outIndices = mc->cpuIndices;
         return;
     }
 
@@ -81,7 +81,7 @@ static void fetchMeshCPUData(
 
 bool exportSceneToOBJ(const Scene& scn, const std::string& objPath, const std::string& mtlName)
 {
-    if (scn.meshes.empty()) {
+    if (scn.empty()) {
         spdlog::warn("[Exporter] Scene is empty. Nothing to export.");
         return false;
     }
@@ -116,9 +116,14 @@ bool exportSceneToOBJ(const Scene& scn, const std::string& objPath, const std::s
     uint32_t baseIndex = 1; // OBJ 索引从 1
     int meshId = 0;
 
-    for (auto const& mc : scn.meshes)
+    for (uint32_t i = 0; i < scn.size(); ++i)
     {
-        std::vector<MeshComp::MeshVertexExport> verts;
+        const MeshExportData* mc = scn.exports[i].mesh.get(); // 共用同一网格的实体指向同一份
+        const std::string& baseColor = scn.exports[i].baseColorPath; // 按路径各自一份
+        const float* model = scn.world[i].m;
+        if (!scn.render[i].mesh.valid() && !mc)
+            continue; // 纯变换节点（分组），没有几何
+        std::vector<MeshVertexExport> verts;
         std::vector<uint32_t> indices;
         fetchMeshCPUData(mc, verts, indices);
 
@@ -129,7 +134,7 @@ bool exportSceneToOBJ(const Scene& scn, const std::string& objPath, const std::s
 
         // 法线矩阵
         float n3[9];
-        computeNormalMat3(mc.model, n3);
+        computeNormalMat3(model, n3);
 
         // 材质
         std::string matName = "mat_" + std::to_string(meshId);
@@ -138,8 +143,8 @@ bool exportSceneToOBJ(const Scene& scn, const std::string& objPath, const std::s
             mtl << "Kd 1.000 1.000 1.000\n";
             mtl << "Ka 0.000 0.000 0.000\n";
             mtl << "Ks 0.000 0.000 0.000\n";
-            if (!mc.baseColorPath.empty()) {
-                mtl << "map_Kd " << mc.baseColorPath << "\n";
+            if (!baseColor.empty()) {
+                mtl << "map_Kd " << baseColor << "\n";
             }
             mtl << "\n";
         }
@@ -151,7 +156,7 @@ bool exportSceneToOBJ(const Scene& scn, const std::string& objPath, const std::s
         for (auto const& v : verts) {
             float pIn[3] = { v.px, v.py, v.pz };
             float pOut[3];
-            transformPosition(mc.model, pIn, pOut);
+            transformPosition(model, pIn, pOut);
             ofs << "v "  << pOut[0] << " " << pOut[1] << " " << pOut[2] << "\n";
         }
 
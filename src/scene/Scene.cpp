@@ -0,0 +1,255 @@
+#include "Scene.h"
+#include <bx/math.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define KE_SCENE_SSE 1
+#else
+#define KE_SCENE_SSE 0
+#endif
+
+// ========== 4 宽浮点：SSE 有就用，没有退回标量（两边同一份内核代码） ==========
+namespace {
+#if KE_SCENE_SSE
+struct F4 {
+    __m128 v;
+};
+inline F4 f4(float a, float b, float c, float d) { return {_mm_setr_ps(a, b, c, d)}; }
+inline F4 f4Load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline F4 f4Splat(float a) { return {_mm_set1_ps(a)}; }
+inline void f4Store(float* p, F4 a) { _mm_storeu_ps(p, a.v); }
+inline F4 operator+(F4 a, F4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline F4 operator-(F4 a, F4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline F4 operator*(F4 a, F4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+#else
+struct F4 {
+    float v[4];
+};
+inline F4 f4(float a, float b, float c, float d) { return {{a, b, c, d}}; }
+inline F4 f4Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline F4 f4Splat(float a) { return {{a, a, a, a}}; }
+inline void f4Store(float* p, F4 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline F4 operator+(F4 a, F4 b) { return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+inline F4 operator-(F4 a, F4 b) { return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}}; }
+inline F4 operator*(F4 a, F4 b) { return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+#endif
+
+// 4 个节点的本地 SRT 一起组合，写进各自的 out[i]
+// 与 bx::mtxSRT 逐项相同（旧 MeshComp::updateModel 的约定）：行向量下 M = S·Rz·Rx·Ry，即先绕 Z、再 X、最后 Y；
+// 行 0/1/2 = 缩放后的 X/Y/Z 轴，行 3 = 平移
+void composeSrt4(const SceneFloat3* const s[4], const SceneFloat3* const r[4], const SceneFloat3* const t[4],
+                 float* const out[4]) {
+    float sinX[4], cosX[4], sinY[4], cosY[4], sinZ[4], cosZ[4];
+    for (int i = 0; i < 4; ++i) {
+        sinX[i] = std::sin(r[i]->x); cosX[i] = std::cos(r[i]->x);
+        sinY[i] = std::sin(r[i]->y); cosY[i] = std::cos(r[i]->y);
+        sinZ[i] = std::sin(r[i]->z); cosZ[i] = std::cos(r[i]->z);
+    }
+    const F4 sx = f4Load(sinX), cx = f4Load(cosX);
+    const F4 sy = f4Load(sinY), cy = f4Load(cosY);
+    const F4 sz = f4Load(sinZ), cz = f4Load(cosZ);
+    const F4 kx = f4(s[0]->x, s[1]->x, s[2]->x, s[3]->x);
+    const F4 ky = f4(s[0]->y, s[1]->y, s[2]->y, s[3]->y);
+    const F4 kz = f4(s[0]->z, s[1]->z, s[2]->z, s[3]->z);
+
+    const F4 zero = f4Splat(0.0f);
+    const F4 sxsz = sx * sz, cycz = cy * cz;
+    F4 m[12];
+    m[0]  = kx * (cycz - sxsz * sy);
+    m[1]  = zero - kx * (cx * sz);
+    m[2]  = kx * (cz * sy + cy * sxsz);
+    m[3]  = zero;
+    m[4]  = ky * (cz * sx * sy + cy * sz);
+    m[5]  = ky * (cx * cz);
+    m[6]  = ky * (sy * sz - cycz * sx);
+    m[7]  = zero;
+    m[8]  = zero - kz * (cx * sy);
+    m[9]  = kz * sx;
+    m[10] = kz * (cx * cy);
+    m[11] = zero;
+
+    // SoA → 每个节点一份矩阵
+    float lanes[12][4];
+    for (int e = 0; e < 12; ++e) f4Store(lanes[e], m[e]);
+    for (int i = 0; i < 4; ++i) {
+        float* o = out[i];
+        for (int e = 0; e < 12; ++e) o[e] = lanes[e][i];
+        o[12] = t[i]->x;
+        o[13] = t[i]->y;
+        o[14] = t[i]->z;
+        o[15] = 1.0f;
+    }
+}
+
+#ifndef NDEBUG
+// 调试构建首次 update 时跑一遍：随机 SRT 与 bx::mtxSRT 逐元素比对，内核和约定走样会直接断言
+void checkComposeSrt4() {
+    std::mt19937 rng(0x5c3e);
+    std::uniform_real_distribution<float> angle(-6.3f, 6.3f), scale(0.1f, 4.0f), offset(-100.0f, 100.0f);
+    for (int iter = 0; iter < 64; ++iter) {
+        SceneFloat3 s[4], r[4], t[4];
+        SceneMat4 got[4];
+        const SceneFloat3* sp[4];
+        const SceneFloat3* rp[4];
+        const SceneFloat3* tp[4];
+        float* out[4];
+        for (int i = 0; i < 4; ++i) {
+            s[i] = {scale(rng), scale(rng), scale(rng)};
+            r[i] = {angle(rng), angle(rng), angle(rng)};
+            t[i] = {offset(rng), offset(rng), offset(rng)};
+            sp[i] = &s[i]; rp[i] = &r[i]; tp[i] = &t[i];
+            out[i] = got[i].m;
+        }
+        composeSrt4(sp, rp, tp, out);
+        for (int i = 0; i < 4; ++i) {
+            float ref[16];
+            bx::mtxSRT(ref, s[i].x, s[i].y, s[i].z, r[i].x, r[i].y, r[i].z, t[i].x, t[i].y, t[i].z);
+            for (int e = 0; e < 16; ++e)
+                assert(std::fabs(got[i].m[e] - ref[e]) <= 1e-4f * std::max(1.0f, std::fabs(ref[e]))
+                       && "composeSrt4 disagrees with bx::mtxSRT");
+        }
+    }
+}
+#endif
+
+// out = a × b（bx 的行向量约定：先 a 后 b）；每行 = a 的该行对 b 四行的线性组合
+void mul4x4(float* out, const float* a, const float* b) {
+    const F4 b0 = f4Load(b), b1 = f4Load(b + 4), b2 = f4Load(b + 8), b3 = f4Load(b + 12);
+    float row[16];
+    for (int i = 0; i < 4; ++i) {
+        const float* ai = a + i * 4;
+        f4Store(row + i * 4, f4Splat(ai[0]) * b0 + f4Splat(ai[1]) * b1 + f4Splat(ai[2]) * b2 + f4Splat(ai[3]) * b3);
+    }
+    std::memcpy(out, row, sizeof(row)); // out 可以就是 a
+}
+} // namespace
+
+uint32_t Scene::add(const SceneRender& r, const SceneBounds& b, SceneExport exportData,
+                    uint32_t parent) {
+    const uint32_t index = size();
+    positions.push_back({});
+    rotations.push_back({});
+    scales.push_back({1.0f, 1.0f, 1.0f});
+    world.emplace_back();
+    bx::mtxIdentity(world.back().m);
+    bounds.push_back(b);
+    render.push_back(r);
+    parents.push_back(parent < index ? parent : kNoParent);
+    dirty.push_back(1); // 有父节点时 world 要乘上父 world
+    moved.push_back(0);
+    exports.push_back(std::move(exportData));
+    anyDirty_ = true;
+    return index;
+}
+
+// 按 remap 压紧一条数组（保持拓扑序）
+template <typename T>
+static void compact(std::vector<T>& v, const std::vector<uint32_t>& remap) {
+    uint32_t w = 0;
+    for (uint32_t i = 0; i < v.size(); ++i) {
+        if (remap[i] == Scene::kNoParent) continue;
+        if (w != i) v[w] = std::move(v[i]);
+        ++w;
+    }
+    v.resize(w);
+}
+
+void Scene::remove(uint32_t index) {
+    const uint32_t n = size();
+    if (index >= n) return;
+
+    // 父在子前：一趟就能标出整棵子树；remap = 新下标（删掉的记 kNoParent）
+    std::vector<uint32_t> remap(n, 0);
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const bool gone = (i == index) || (i > index && parents[i] != kNoParent && remap[parents[i]] == kNoParent);
+        remap[i] = gone ? kNoParent : next++;
+        if (gone && meshes) meshes->release(render[i].mesh);
+    }
+    for (uint32_t i = 0; i < n; ++i)
+        if (remap[i] != kNoParent && parents[i] != kNoParent) parents[i] = remap[parents[i]];
+
+    compact(positions, remap);
+    compact(rotations, remap);
+    compact(scales, remap);
+    compact(world, remap);
+    compact(bounds, remap);
+    compact(render, remap);
+    compact(parents, remap);
+    compact(dirty, remap);
+    compact(moved, remap);
+    compact(exports, remap);
+
+    // updated_ 里的旧下标已失效
+    updated_.clear();
+    std::fill(moved.begin(), moved.end(), uint8_t(0));
+}
+
+void Scene::clear() {
+    if (meshes)
+        for (const SceneRender& r : render) meshes->release(r.mesh);
+    positions.clear();
+    rotations.clear();
+    scales.clear();
+    world.clear();
+    bounds.clear();
+    render.clear();
+    parents.clear();
+    dirty.clear();
+    moved.clear();
+    exports.clear();
+    updated_.clear();
+    anyDirty_ = false;
+}
+
+uint32_t Scene::update() {
+    for (uint32_t i : updated_) moved[i] = 0;
+    updated_.clear();
+    if (!anyDirty_) return 0; // 静态场景：每帧只到这里
+    anyDirty_ = false;
+
+    // 1) 脏标记往下传：父在子前，一趟即可；顺便收集要重算的节点（仍是拓扑序）
+    const uint32_t n = size();
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint32_t p = parents[i];
+        if (!dirty[i] && !(p != kNoParent && dirty[p])) continue;
+        dirty[i] = 1;
+        updated_.push_back(i);
+    }
+
+    // 2) 本地 SRT 4 个一组组合，先写进 world（不足 4 个用最后一个补齐，重复写同一值）
+    const uint32_t count = static_cast<uint32_t>(updated_.size());
+#ifndef NDEBUG
+    static const bool srtChecked = (checkComposeSrt4(), true);
+    (void)srtChecked;
+#endif
+    for (uint32_t base = 0; base < count; base += 4) {
+        const SceneFloat3* s[4];
+        const SceneFloat3* r[4];
+        const SceneFloat3* t[4];
+        float* out[4];
+        for (uint32_t k = 0; k < 4; ++k) {
+            const uint32_t i = updated_[std::min(base + k, count - 1)];
+            s[k] = &scales[i];
+            r[k] = &rotations[i];
+            t[k] = &positions[i];
+            out[k] = world[i].m;
+        }
+        composeSrt4(s, r, t, out);
+    }
+
+    // 3) 按拓扑序乘父 world：父节点要么没动（world 是上次的结果），要么在前面已经算完
+    for (uint32_t i : updated_) {
+        const uint32_t p = parents[i];
+        if (p != kNoParent) mul4x4(world[i].m, world[i].m, world[p].m);
+        dirty[i] = 0;
+        moved[i] = 1;
+    }
+    return count;
+}
@@ -1,84 +1,137 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 #include <bgfx/bgfx.h>
-#include <bx/math.h>
+#include "gfx/resource/MeshRegistry.h" // MeshHandle / PbrMatHandle
 
 /**
- * Mesh 组件（最小可用 + Day4 扩展）：
- * - GPU 资源（VB/IB/可选贴图）
- * - 渲染状态与索引数
- * - 变换参数（SRT：position/rotation/scale）
- * - 最终模型矩阵（提交前由 updateModel() 生成）
- * - Day4: 导出用 CPU 缓存
+ * 场景存储（SoA，按访问频率拆开）：
+ * - 一个实体 = 各数组里同一个下标；每种热数据一条紧凑数组，
+ *   update 只走 SRT + world，裁剪只走 world + bounds，提交再加 render，互不把对方拖进缓存
+ * - 冷数据（导出用 CPU 顶点 / 索引 / 贴图路径）放在 exports 旁表，只有 Exporter 读；同一网格的实体共用一份
+ * - 网格按 MeshHandle 引用 MeshRegistry 里的共享缓冲：多个实体可以指向同一份 GPU 网格
+ * - 变换层级：parents 存父节点下标，数组按拓扑序（父在子前，add 时父节点必须已存在）；
+ *   world = 本地 SRT × 父 world
+ * - 脏标记：改 SRT 后 markDirty（或用 setPosition 等）；update 只重算脏节点及其子孙，
+ *   本地 SRT 4 个一组用 SIMD 组合；没有脏节点时 update 直接返回
+ * - 增删走 add / remove；remove 连子孙一起删并压紧数组，之后的下标会前移
  */
-struct MeshComp
+
+// 变换参数（相对父节点）：rotation 为 XYZ 欧拉角（弧度，先绕 X 再 Y 再 Z），scale 支持非均匀缩放
+struct SceneFloat3
 {
-    // —— GPU 资源句柄 —— //
-    bgfx::VertexBufferHandle vbh{BGFX_INVALID_HANDLE};
-    bgfx::IndexBufferHandle  ibh{BGFX_INVALID_HANDLE};
-    bgfx::TextureHandle      baseColor{BGFX_INVALID_HANDLE};
-
-    // —— 渲染状态与索引数 —— //
-    uint64_t state =
-        BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_WRITE_Z |
-        BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-    uint32_t indexCount = 0;
-
-    // —— 变换参数（世界空间）—— //
-    // 约定 rotation 为 XYZ 欧拉角（单位：弧度），scale 支持非均匀缩放
-    float position[3] = {0.0f, 0.0f, 0.0f};
-    float rotation[3] = {0.0f, 0.0f, 0.0f};
-    float scale[3]    = {1.0f, 1.0f, 1.0f};
-
-    // —— 模型矩阵（由 updateModel() 自动生成）—— //
-    float model[16];
-
-    MeshComp() { bx::mtxIdentity(model); }
-
-    // 将 SRT 组合为模型矩阵
-    void updateModel()
-    {
-        bx::mtxSRT(
-            model,
-            scale[0], scale[1], scale[2],
-            rotation[0], rotation[1], rotation[2],
-            position[0], position[1], position[2]);
-    }
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+};
 
-    // —— Day4: 导出用 CPU 缓存（与 GltfLoader 顶点字段一致）—— //
-    struct MeshVertexExport
-    {
-        float px, py, pz;
-        float nx, ny, nz;
-        float u, v;
-    };
+// 模型矩阵（与 bx 相同的内存布局：m[12..14] 是平移，由 Scene::update() 生成）
+struct SceneMat4
+{
+    float m[16];
+};
+
+// 物体空间 AABB（加载时计算）
+struct SceneBounds
+{
+    float min[3] = {0.0f, 0.0f, 0.0f};
+    float max[3] = {0.0f, 0.0f, 0.0f};
+};
+
+// 提交一个网格要的全部：共享网格的句柄 + 材质（缓冲 / 索引数在 MeshRegistry 里）
+struct SceneRender
+{
+    MeshHandle   mesh{};     // 无效 = 纯变换节点
+    PbrMatHandle material{};
+    bool         dynamic = false; // 会动的网格：所在的阴影级不能缓存
+};
+
+// 导出用 CPU 缓存（与 GltfLoader 顶点字段一致）
+struct MeshVertexExport
+{
+    float px, py, pz;
+    float nx, ny, nz;
+    float u, v;
+};
 
+struct MeshExportData
+{
     std::vector<MeshVertexExport> cpuVertices;
     std::vector<uint32_t>         cpuIndices;
+};
 
-    // 贴图源路径（若有）
-    std::string baseColorPath;
+// 每个实体的导出信息：几何按内容共享，贴图跟着加载它的路径走
+struct SceneExport
+{
+    std::shared_ptr<const MeshExportData> mesh; // 可空；与网格同享
+    std::string                           baseColorPath; // 贴图源路径（若有）
 };
 
 /**
  * 场景容器：
- * - 管理一组 MeshComp
- * - 每帧调用 update() 生成/刷新每个网格的模型矩阵
+ * - 每帧调用 update() 把 SRT 写入 world
+ * - 只登记句柄，不负责创建 / 销毁 bgfx 资源
+ * - 每个带网格的实体持有一份 MeshRegistry 引用：add 接管调用方拿到的那份，
+ *   remove / clear 归还（须先设置 meshes；Renderer::addMeshFromGltfToScene 会设置）
  */
 struct Scene
 {
-    std::vector<MeshComp> meshes;
+    static constexpr uint32_t kNoParent = UINT32_MAX;
+
+    // —— 热数据 —— //
+    std::vector<SceneFloat3> positions;
+    std::vector<SceneFloat3> rotations;
+    std::vector<SceneFloat3> scales;
+    std::vector<SceneMat4>   world;
+    std::vector<SceneBounds> bounds;
+    std::vector<SceneRender> render;
+    std::vector<uint32_t>    parents; // kNoParent = 根；总是小于自身下标
+    std::vector<uint8_t>     dirty;   // 本地 SRT 改过、world 待重算
+    std::vector<uint8_t>     moved;   // 最近一次 update 重算过 world（阴影缓存据此判断投射体动没动）
 
-    void clear() { meshes.clear(); } // 注意：仅清空容器，不负责销毁 bgfx 句柄
-    bool empty() const { return meshes.empty(); }
+    // —— 冷数据 —— //
+    std::vector<SceneExport> exports;
 
-    // 每帧更新：把 SRT 写入 model 矩阵
-    void update()
+    MeshRegistry *meshes = nullptr; // 实体引用的网格归它管
+
+    uint32_t size() const { return static_cast<uint32_t>(render.size()); }
+    bool empty() const { return render.empty(); }
+
+    // 新实体：单位变换；parent 必须是已有实体（或 kNoParent）；返回下标
+    // r.mesh 有效时接管它的一份引用
+    uint32_t add(const SceneRender &r, const SceneBounds &b,
+                 SceneExport exportData = {}, uint32_t parent = kNoParent);
+    // 不带网格的纯变换节点（分组用）
+    uint32_t addNode(uint32_t parent = kNoParent) { return add({}, {}, {}, parent); }
+    void remove(uint32_t index); // 连同子孙一起删，归还它们的网格引用
+    void clear();                // 归还全部网格引用；缓冲由 MeshRegistry 延迟销毁
+
+    void markDirty(uint32_t index)
     {
-        for (auto &m : meshes)
-        {
-            m.updateModel();
-        }
+        dirty[index] = 1;
+        anyDirty_ = true;
     }
+    void setPosition(uint32_t index, float x, float y, float z)
+    {
+        positions[index] = {x, y, z};
+        markDirty(index);
+    }
+    void setRotation(uint32_t index, float x, float y, float z)
+    {
+        rotations[index] = {x, y, z};
+        markDirty(index);
+    }
+    void setScale(uint32_t index, float x, float y, float z)
+    {
+        scales[index] = {x, y, z};
+        markDirty(index);
+    }
+
+    // 每帧更新：脏标记传给子孙，重算它们的 world；返回重算的节点数
+    uint32_t update();
+    uint32_t lastUpdated() const { return static_cast<uint32_t>(updated_.size()); }
+
+private:
+    bool                  anyDirty_ = false;
+    std::vector<uint32_t> updated_; // 最近一次 update 重算的节点（按拓扑序），下次 update 先清它们的 moved
 };
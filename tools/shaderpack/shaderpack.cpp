@@ -0,0 +1,109 @@
+// shaderpack：把同一后端的 shaderc 产物打成一个 .pak（格式见 gfx/shaders/ShaderArchiveFormat.h）
+// 用法：shaderpack <out.pak> <a.bin> [b.bin ...]
+#include "gfx/shaders/ShaderArchiveFormat.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace ke::shaderpak;
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "usage: shaderpack <out.pak> <shader.bin>...\n");
+        return 1;
+    }
+
+    struct Item { std::string name; std::vector<char> data; };
+    std::vector<Item> items;
+    for (int i = 2; i < argc; ++i)
+    {
+        const fs::path p(argv[i]);
+        Item it;
+        it.name = p.filename().string();
+        if (it.name.size() >= kNameLen)
+        {
+            std::fprintf(stderr, "shaderpack: name too long (max %u): %s\n", kNameLen - 1, it.name.c_str());
+            return 1;
+        }
+        std::ifstream ifs(p, std::ios::binary | std::ios::ate);
+        if (!ifs)
+        {
+            std::fprintf(stderr, "shaderpack: cannot open %s\n", argv[i]);
+            return 1;
+        }
+        it.data.resize((size_t)ifs.tellg());
+        ifs.seekg(0);
+        ifs.read(it.data.data(), (std::streamsize)it.data.size());
+        items.push_back(std::move(it));
+    }
+
+    // 按名字排序（运行时二分查找），去掉重复输入
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.name < b.name; });
+    items.erase(std::unique(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.name == b.name; }),
+                items.end());
+
+    Header hdr;
+    hdr.count = (uint32_t)items.size();
+    std::vector<Entry> index(items.size());
+    uint64_t offset = sizeof(Header) + sizeof(Entry) * items.size();
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        offset = (offset + kAlign - 1) / kAlign * kAlign;
+        std::memcpy(index[i].name, items[i].name.c_str(), items[i].name.size());
+        index[i].offset = (uint32_t)offset;
+        index[i].size = (uint32_t)items[i].data.size();
+        offset += items[i].data.size();
+    }
+    if (offset > UINT32_MAX)
+    {
+        std::fprintf(stderr, "shaderpack: archive exceeds 4 GB\n");
+        return 1;
+    }
+
+    // 先写临时文件再改名覆盖：运行中的引擎可能正映射着旧包，原地截断会让它读到 SIGBUS
+    const fs::path out(argv[1]);
+    fs::path tmp = out;
+    tmp += ".tmp";
+    std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+    {
+        std::fprintf(stderr, "shaderpack: cannot write %s\n", tmp.string().c_str());
+        return 1;
+    }
+    ofs.write((const char*)&hdr, sizeof(hdr));
+    ofs.write((const char*)index.data(), (std::streamsize)(sizeof(Entry) * index.size()));
+    uint64_t pos = sizeof(Header) + sizeof(Entry) * index.size();
+    static const char zeros[kAlign] = {};
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        ofs.write(zeros, (std::streamsize)(index[i].offset - pos));
+        ofs.write(items[i].data.data(), (std::streamsize)items[i].data.size());
+        pos = index[i].offset + items[i].data.size();
+    }
+    ofs.close();
+    if (!ofs)
+    {
+        std::fprintf(stderr, "shaderpack: write failed %s\n", tmp.string().c_str());
+        fs::remove(tmp);
+        return 1;
+    }
+
+    // 同一文件系统内 rename 是原子的；旧包的映射仍指向原 inode，不受影响
+    std::error_code ec;
+    fs::rename(tmp, out, ec);
+    if (ec)
+    {
+        std::fprintf(stderr, "shaderpack: cannot replace %s (%s)\n", argv[1], ec.message().c_str());
+        fs::remove(tmp, ec);
+        return 1;
+    }
+    return 0;
+}